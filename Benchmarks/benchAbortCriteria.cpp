@@ -0,0 +1,106 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  benchAbortCriteria.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "ReflexSweep.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Total time of a wide sweep with and without abort criteria. A grid of 48
+ * property sets of the reflex circuit, from weak to strong reflexes, is run
+ * for the full 10 s of mainSimulation.cpp on one thread per hardware
+ * thread. It is run once to the final time and once with runs aborted when
+ * the block leaves [-0.25, 0.25] or original1 stays saturated for 0.5 s.
+ * The wall time of both sweeps is reported with the number of aborted runs
+ * and the simulated time they skipped, and the aborted runs are listed with
+ * their reasons.
+ */
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    try {
+        ReflexSweep sweep;
+        sweep.setFinalTime(10.0);
+        sweep.addGrid({0.0, 0.05, 0.1, 0.2}, {0.02, 0.05, 0.1, 0.2}, {0.5},
+                      {{0.1, 0.1, 0.1}, {0.4, 0.4, 0.2}, {0.8, 0.1, 0.1}});
+
+        Clock::time_point start = Clock::now();
+        std::vector<ReflexSweepResult> full = sweep.run(0);
+        double fullTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+        ReflexAbortCriteria criteria;
+        criteria.minPosition = -0.25;
+        criteria.maxPosition = 0.25;
+        criteria.saturationLevel = 1.0;
+        criteria.maxSaturationTime = 0.5;
+        sweep.setAbortCriteria(criteria);
+
+        start = Clock::now();
+        std::vector<ReflexSweepResult> aborted = sweep.run(0);
+        double abortedTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+        int numAborted = 0;
+        double skipped = 0;
+        for (const ReflexSweepResult& result : aborted)
+        {
+            if (!result.abortReason.empty())
+            {
+                ++numAborted;
+                skipped += sweep.getFinalTime() - result.endTime;
+            }
+        }
+
+        std::cout << sweep.getNumPoints() << " points, "
+                  << sweep.getFinalTime() << " s each\n";
+        std::cout << "sweep\twall (s)\taborted\tskipped (s)\n";
+        std::cout << "full\t" << fullTime << "\t0\t0\n";
+        std::cout << "abort criteria\t" << abortedTime << "\t" << numAborted
+                  << "\t" << skipped << "\n";
+        std::cout << "speedup\t" << fullTime/abortedTime << "\n\n";
+
+        std::vector<ReflexSweepResult> listed;
+        for (const ReflexSweepResult& result : aborted)
+        {
+            if (!result.abortReason.empty())
+            {
+                listed.push_back(result);
+            }
+        }
+        ReflexSweep::writeTable(std::cout, listed);
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+/* -------------------------------------------------------------------------- *
+ *                     OpenSim:  benchActivation.cpp                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Compare the step and smooth activation modes of the interneuron on the
+ * tug-of-war model with the reflex loop closed, so that the signal of the
+ * interneuron excites original1 through the delay and its threshold reaches
+ * the continuous states the integrator controls the error of. The step is
+ * run with and without the events that locate its threshold crossings and
+ * the onset of the delay. For every mode and sharpness the model is
+ * integrated for 10 s at an accuracy of 1e-6, as in mainSimulation.cpp, and
+ * the accepted and rejected steps of the integrator are reported together
+ * with its realizations, the wall time and the largest difference of the
+ * interneuron signal from the step without events, sampled every
+ * millisecond. The rejected steps the events save and the steps they
+ * attempt are summarized against the step and the smooth modes.
+ */
+
+namespace {
+
+    const double finalTime = 10.0;
+
+    struct Run {
+        int accepted;
+        int rejected;
+        int realizations;
+        double wallTime;
+        std::vector<double> signal;
+    };
+
+    Run simulate(const std::string& activation, double sharpness,
+                 bool localize = true)
+    {
+        Model model;
+        buildTugOfWarModel(model, ReflexExcitation);
+
+        MuscleReflexCircuit& circuit =
+            model.updComponent<MuscleReflexCircuit>("reflex_circuit");
+        circuit.updInterneuron().setActivation(activation);
+        circuit.updInterneuron().setSharpness(sharpness);
+        circuit.updInterneuron().setLocalizeThreshold(localize);
+        circuit.updDelay().setLocalizeOnset(localize);
+
+        TableReporter* reporter = new TableReporter();
+        reporter->setName("signal_reporter");
+        reporter->set_report_time_interval(0.001);
+        reporter->addToReport(circuit.getInterneuron().getOutput("signal"));
+        model.addComponent(reporter);
+
+        SimTK::State& si = initializeTugOfWarState(model);
+
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+
+        Run run;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        manager.initialize(si);
+        manager.integrate(finalTime);
+        run.wallTime = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        const SimTK::Integrator& integrator = manager.getIntegrator();
+        run.accepted = integrator.getNumStepsTaken();
+        run.rejected = integrator.getNumStepsAttempted() -
+                       integrator.getNumStepsTaken();
+        run.realizations = integrator.getNumRealizations();
+
+        const TimeSeriesTable& table = reporter->getTable();
+        const auto& column = table.getDependentColumnAtIndex(0);
+        for (int i = 0; i < (int)column.size(); ++i)
+        {
+            run.signal.push_back(column[i]);
+        }
+        return run;
+    }
+
+    void report(const std::string& activation, double sharpness,
+                const Run& run, const Run& step)
+    {
+        int n = (int)std::min(run.signal.size(), step.signal.size());
+        double maxDifference = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            maxDifference = std::max(maxDifference,
+                                     std::fabs(run.signal[i] - step.signal[i]));
+        }
+
+        std::cout << activation << "\t" << sharpness << "\t" << run.accepted
+                  << "\t" << run.rejected << "\t" << run.realizations << "\t"
+                  << run.wallTime << "\t" << step.wallTime/run.wallTime << "\t"
+                  << maxDifference << "\n";
+    }
+
+}
+
+int main() {
+
+    try {
+        std::cout << "activation\tsharpness\taccepted\trejected\t"
+                  << "realizations\twall (s)\tspeedup\tmax difference\n";
+
+        Run step = simulate("step", 100.0, false);
+        report("step", 100.0, step, step);
+        Run events = simulate("step", 100.0);
+        report("step+events", 100.0, events, step);
+
+        int smoothAttempted = std::numeric_limits<int>::max();
+        const std::string modes[] = {"logistic", "softplus"};
+        const double sharpnesses[] = {30.0, 100.0, 300.0, 1000.0};
+        for (const std::string& mode : modes)
+        {
+            for (double sharpness : sharpnesses)
+            {
+                Run run = simulate(mode, sharpness);
+                report(mode, sharpness, run, step);
+                smoothAttempted = std::min(smoothAttempted,
+                                           run.accepted + run.rejected);
+            }
+        }
+
+        std::cout << "\nstep+events saves " << step.rejected - events.rejected
+                  << " of " << step.rejected << " rejected steps and attempts "
+                  << events.accepted + events.rejected << " steps, the step "
+                  << step.accepted + step.rejected << " and the fewest of the "
+                  << "smooth modes " << smoothAttempted << "\n";
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
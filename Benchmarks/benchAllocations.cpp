@@ -0,0 +1,172 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchAllocations.cpp                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Count the heap allocations of the spindle -> interneuron -> delay ->
+ * muscle_signal chain of the tug-of-war model with the reflex loop closed,
+ * as it is deployed in mainSimulation.cpp, once it is warmed up. Global
+ * operator new is replaced by a counting one. The chain is evaluated at new
+ * times on a copy of an integrated State and its allocations are reported
+ * per evaluation, net of realizing the model to Velocity on its own. These
+ * must be 0, or the benchmark fails.
+ *
+ * The allocations of manager.integrate() are reported per simulated second
+ * and per accepted step for reference only and are deliberately not
+ * enforced: the Manager appends every step to its state Storage and the
+ * integrator allocates when it handles events, so integrate() allocates
+ * with or without the chain. A run with the circuit removed is no baseline
+ * either, since without the loop the block moves differently and the
+ * integrator takes a different number of steps. The realizations the
+ * integrator does per step are the ones evaluated above, so the gate on the
+ * chain covers them. Last, how often each output of the chain was computed
+ * and read during the integration is reported.
+ */
+
+namespace {
+
+    std::atomic<long long> numAllocations(0);
+
+    void printCounter(const std::string& output, const OutputCounter& counter)
+    {
+        std::cout << output << "\t" << counter.numComputed << "\t"
+                  << counter.numRead << "\n";
+    }
+
+}
+
+void* operator new(std::size_t size)
+{
+    ++numAllocations;
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+int main() {
+
+    try {
+        Model model;
+        buildTugOfWarModel(model, ReflexExcitation);
+        const MuscleReflexCircuit& circuit =
+            model.getComponent<MuscleReflexCircuit>("reflex_circuit");
+
+        SimTK::State& si = initializeTugOfWarState(model);
+
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+        manager.initialize(si);
+
+        // warm up past the delay so that the history is in use
+        manager.integrate(0.5);
+
+        int steps = manager.getIntegrator().getNumStepsTaken();
+        long long before = numAllocations;
+        manager.integrate(1.5);
+        long long integrateAllocations = numAllocations - before;
+        steps = manager.getIntegrator().getNumStepsTaken() - steps;
+
+        SimTK::State s = manager.getState();
+        const int numEvaluations = 1000;
+        const double h = 1.0e-4;
+        double t0 = s.getTime();
+        double checksum = 0;
+
+        // realizing on its own, then realizing and reading the chain
+        before = numAllocations;
+        for (int i = 0; i < numEvaluations; ++i)
+        {
+            s.setTime(t0 + i*h);
+            model.realizeVelocity(s);
+        }
+        long long realizeAllocations = numAllocations - before;
+
+        before = numAllocations;
+        for (int i = 0; i < numEvaluations; ++i)
+        {
+            s.setTime(t0 + (numEvaluations + i)*h);
+            model.realizeVelocity(s);
+            checksum += circuit.getMuscleSignal(s);
+        }
+        long long chainAllocations =
+            numAllocations - before - realizeAllocations;
+
+        std::cout << "allocations per muscle_signal evaluation\t"
+                  << (double)chainAllocations/numEvaluations << "\n";
+        std::cout << "allocations per realizeVelocity\t"
+                  << (double)realizeAllocations/numEvaluations << "\n";
+        std::cout << "allocations per simulated second of integrate\t"
+                  << integrateAllocations/1.0 << "\n";
+        std::cout << "allocations per accepted step of integrate\t"
+                  << (double)integrateAllocations/std::max(steps, 1) << "\n";
+
+        const SimTK::State& end = manager.getState();
+        const SimpleSpindle& spindle = circuit.getSpindle();
+        std::cout << "\noutput\tcomputed\tread\n";
+        printCounter("spindle_length", spindle.getSpindleLengthCounter(end));
+        printCounter("spindle_speed", spindle.getSpindleSpeedCounter(end));
+        printCounter("golgiLength",
+                     circuit.getGolgi().getTendonLengthCounter(end));
+        printCounter("interneuron signal",
+                     circuit.getInterneuron().getSignalCounter(end));
+        printCounter("delay controlSignal",
+                     circuit.getDelay().getSignalCounter(end));
+        printCounter("muscle_signal", circuit.getMuscleSignalCounter(end));
+
+        std::cout << "\n(checksum " << checksum << ")\n";
+
+        if (chainAllocations > 0)
+        {
+            std::cout << "The reflex chain allocates after warm up" << std::endl;
+            return 1;
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
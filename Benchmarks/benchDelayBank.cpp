@@ -0,0 +1,299 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchDelayBank.cpp                            *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "DelayBankLine.h"
+#include "DelayLine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Delay many channels through one DelayBankHistory and through one
+ * DelayHistory per channel, as a model with a Delay per reflex circuit does,
+ * driven through the same variable steps, Runge-Kutta stages and rejected
+ * steps as benchDelayLine. Channel delays are spread between 20 and 60 ms.
+ * Reports the cost per step and per channel for each bank size and the
+ * largest difference between the two, then the cost and stored samples as
+ * more channels tap the same 64 source signals. The gathered lookup of the
+ * bank is checked against its scalar reference on the final line of every
+ * run; the benchmark fails if they differ by more than rounding.
+ */
+
+namespace {
+
+    const double minStepSize = 1.0e-4;
+    const double maxStepSize = 1.0e-3;
+    const double duration = 5.0;
+
+    double nextStep(unsigned int& seed)
+    {
+        seed = 1664525u*seed + 1013904223u;
+        return minStepSize + (maxStepSize - minStepSize)*(seed >> 8)/16777216.0;
+    }
+
+    const double stages[] = {0.0, 0.5, 0.5, 1.0};
+
+    // every source is a phase shifted sine
+    double sample(double t, int source)
+    {
+        return 0.5 + 0.5*std::sin(10*t + 0.1*source);
+    }
+
+    // channel c taps source c % numSources
+    struct BankChannels {
+        DelayBankHistory committed;
+        DelayBankHistory update;
+        const std::vector<double>& delays;
+        std::vector<int> sources;
+        std::vector<double> row, times, values;
+
+        BankChannels(const std::vector<double>& d, int numSources) :
+            delays(d), sources(d.size()), row(numSources), times(d.size()),
+            values(d.size())
+        {
+            for (int c = 0; c < (int)d.size(); ++c)
+            {
+                sources[c] = c % numSources;
+            }
+            double maxDelay = *std::max_element(d.begin(), d.end());
+            committed.reset(numSources, (int)d.size(), maxDelay, minStepSize);
+            update = committed;
+        }
+        const std::vector<double>& evaluate(double t)
+        {
+            for (int k = 0; k < (int)row.size(); ++k)
+            {
+                row[k] = sample(t, k);
+            }
+            update.prepareUpdate(committed, t, row.data());
+            for (int c = 0; c < (int)delays.size(); ++c)
+            {
+                times[c] = t - delays[c];
+            }
+            update.getValues(sources.data(), times.data(), values.data());
+            return values;
+        }
+        void accept() { std::swap(committed, update); }
+        long storedSamples() const
+        {
+            const DelayBankLine& line = committed.getLine();
+            return (long)line.getSize()*line.getNumChannels();
+        }
+    };
+
+    struct SeparateChannels {
+        std::vector<DelayHistory> committed;
+        std::vector<DelayHistory> update;
+        const std::vector<double>& delays;
+        int numSources;
+        std::vector<double> values;
+
+        SeparateChannels(const std::vector<double>& d, int n) :
+            committed(d.size()), update(d.size()), delays(d), numSources(n),
+            values(d.size())
+        {
+            for (int c = 0; c < (int)d.size(); ++c)
+            {
+                committed[c].reset(d[c], minStepSize);
+                update[c] = committed[c];
+            }
+        }
+        const std::vector<double>& evaluate(double t)
+        {
+            for (int c = 0; c < (int)delays.size(); ++c)
+            {
+                update[c].prepareUpdate(committed[c], t,
+                                        sample(t, c % numSources));
+                values[c] = update[c].getValue(t - delays[c]);
+            }
+            return values;
+        }
+        void accept()
+        {
+            for (int c = 0; c < (int)delays.size(); ++c)
+            {
+                std::swap(committed[c], update[c]);
+            }
+        }
+        long storedSamples() const
+        {
+            long size = 0;
+            for (const DelayHistory& history : committed)
+            {
+                size += history.getLine().getSize();
+            }
+            return size;
+        }
+    };
+
+    // largest difference of the gathered lookup from the scalar one on the
+    // committed line, at times spread across its window
+    double gatherDifference(const BankChannels& bank)
+    {
+        const DelayBankLine& line = bank.committed.getLine();
+        int numTaps = line.getNumTaps();
+        std::vector<double> times(numTaps), gathered(numTaps), scalar(numTaps);
+        double end = line.getLastTime();
+        double begin = line.getStartTime() > end - line.getMaxDelay() ?
+                       line.getStartTime() : end - line.getMaxDelay();
+        for (int c = 0; c < numTaps; ++c)
+        {
+            times[c] = begin + (end - begin)*c/std::max(1, numTaps - 1);
+        }
+        line.getValues(bank.sources.data(), times.data(), gathered.data());
+        line.getValuesReference(bank.sources.data(), times.data(), scalar.data());
+        double difference = 0;
+        for (int c = 0; c < numTaps; ++c)
+        {
+            difference = std::max(difference, std::fabs(gathered[c] - scalar[c]));
+        }
+        return difference;
+    }
+
+    // ns per step, leaving the delayed values of the last stage in channels
+    template <class Channels>
+    double runSteps(Channels& channels, long& steps, double& checksum)
+    {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now();
+        double t = 0;
+        unsigned int seed = 1;
+        steps = 0;
+        while (t < duration)
+        {
+            double h = nextStep(seed);
+            if (steps % 50 == 49)
+            {
+                for (double c : stages)
+                {
+                    checksum += channels.evaluate(t + c*h)[0];
+                }
+                h *= 0.5;
+            }
+            for (double c : stages)
+            {
+                checksum += channels.evaluate(t + c*h)[0];
+            }
+            channels.accept();
+            t += h;
+            ++steps;
+        }
+        return std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count()/steps;
+    }
+
+}
+
+int main() {
+
+    std::cout << "DelayBankHistory interpolation: "
+              << DelayBankLine::getKernelName() << "\n";
+    std::cout << "channels\tbank ns/step\tseparate ns/step\t"
+                 "bank ns/channel\tseparate ns/channel\tmax difference\t"
+                 "gather difference\n";
+
+    // a + w*(b - a) may be contracted to a fused multiply-add in one pass
+    // and not the other
+    const double gatherTolerance = 1.0e-14;
+    double maxGatherDifference = 0;
+
+    double checksum = 0;
+    int sizes[] = {4, 16, 64, 256, 512};
+    for (int numChannels : sizes)
+    {
+        std::vector<double> delays(numChannels);
+        for (int c = 0; c < numChannels; ++c)
+        {
+            delays[c] = 0.02 + 0.04*c/numChannels;
+        }
+
+        BankChannels bank(delays, numChannels);
+        SeparateChannels separate(delays, numChannels);
+        long steps = 0;
+        double bankNs = runSteps(bank, steps, checksum);
+        double separateNs = runSteps(separate, steps, checksum);
+
+        // both are left at the last stage of the run
+        double maxDifference = 0;
+        for (int c = 0; c < numChannels; ++c)
+        {
+            maxDifference = std::max(maxDifference,
+                std::fabs(bank.values[c] - separate.values[c]));
+        }
+
+        double gather = gatherDifference(bank);
+        maxGatherDifference = std::max(maxGatherDifference, gather);
+
+        std::cout << numChannels << "\t" << bankNs << "\t" << separateNs
+                  << "\t" << bankNs/numChannels << "\t"
+                  << separateNs/numChannels << "\t" << maxDifference << "\t"
+                  << gather << "\n";
+    }
+
+    std::cout << "\nTaps per source on 64 sources\n";
+    std::cout << "taps\tchannels\tbank ns/step\tseparate ns/step\t"
+                 "bank samples\tseparate samples\n";
+
+    const int numSources = 64;
+    int taps[] = {1, 2, 4, 8};
+    for (int tapsPerSource : taps)
+    {
+        int numChannels = numSources*tapsPerSource;
+        std::vector<double> delays(numChannels);
+        for (int c = 0; c < numChannels; ++c)
+        {
+            delays[c] = 0.02 + 0.04*(c/numSources)/tapsPerSource;
+        }
+
+        BankChannels bank(delays, numSources);
+        SeparateChannels separate(delays, numSources);
+        long steps = 0;
+        double bankNs = runSteps(bank, steps, checksum);
+        double separateNs = runSteps(separate, steps, checksum);
+        maxGatherDifference = std::max(maxGatherDifference,
+                                       gatherDifference(bank));
+
+        std::cout << tapsPerSource << "\t" << numChannels << "\t" << bankNs
+                  << "\t" << separateNs << "\t" << bank.storedSamples()
+                  << "\t" << separate.storedSamples() << "\n";
+    }
+
+    std::cout << "\n(checksum " << checksum << ")\n";
+
+    if (maxGatherDifference > gatherTolerance)
+    {
+        std::cout << "The gathered lookup differs from the scalar one by "
+                  << maxGatherDifference << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
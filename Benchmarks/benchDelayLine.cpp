@@ -0,0 +1,209 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchDelayLine.cpp                            *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "DelayLine.h"
+#include <OpenSim/Common/PiecewiseLinearFunction.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Drive the delay history the way the integrator drives Delay::getSignal over
+ * a 10 minute simulated run: variable steps, several stage evaluations per
+ * step and an occasional rejected step, with the history committed only on
+ * accepted steps. The cost per step is reported for every simulated minute
+ * and should stay flat. The old PiecewiseLinearFunction history is timed over
+ * the first seconds for comparison, and the compacted history is timed for a
+ * range of history tolerances.
+ */
+
+namespace {
+
+    const double delay = 0.1;
+    const double minStepSize = 1.0e-4;
+    const double maxStepSize = 1.0e-3;
+
+    // deterministic step sizes between minStepSize and maxStepSize
+    double nextStep(unsigned int& seed)
+    {
+        seed = 1664525u*seed + 1013904223u;
+        return minStepSize + (maxStepSize - minStepSize)*(seed >> 8)/16777216.0;
+    }
+
+    double signal(double t) { return 0.5 + 0.5*std::sin(10*t); }
+
+    // stage fractions of a step evaluated by an embedded Runge-Kutta method
+    const double stages[] = {0.0, 0.5, 0.5, 1.0};
+
+    // The committed history and its update, as Delay keeps them in the State
+    struct StateHistory {
+        DelayHistory committed;
+        DelayHistory update;
+        double maxError;
+        long long sumSize;
+
+        StateHistory(double tolerance) : maxError(0), sumSize(0)
+        {
+            committed.reset(delay, minStepSize, tolerance);
+            update = committed;
+        }
+        double evaluate(double t)
+        {
+            update.prepareUpdate(committed, t, signal(t));
+            sumSize += update.getLine().getSize();
+            if (t - delay < update.getStartTime()) return 1.0;
+            double value = update.getValue(t - delay);
+            maxError = std::max(maxError, std::fabs(value - signal(t - delay)));
+            return value;
+        }
+        void accept() { std::swap(committed, update); }
+    };
+
+    // The history Delay kept before: every evaluation is inserted
+    struct SplineHistory {
+        PiecewiseLinearFunction spline;
+
+        double evaluate(double t)
+        {
+            spline.addPoint(t, signal(t));
+            if (t - delay < spline.getXValues()[0]) return 1.0;
+            return spline.calcValue(SimTK::Vector(1, t - delay));
+        }
+        void accept() {}
+    };
+
+    template <class History>
+    double runSteps(History& history, double& t, double endTime,
+                    unsigned int& seed, long& steps)
+    {
+        double sum = 0;
+        while (t < endTime)
+        {
+            double h = nextStep(seed);
+            // every 50th step is rejected and retried at half the size
+            if (steps % 50 == 49)
+            {
+                for (double c : stages)
+                {
+                    sum += history.evaluate(t + c*h);
+                }
+                h *= 0.5;
+            }
+            for (double c : stages)
+            {
+                sum += history.evaluate(t + c*h);
+            }
+            history.accept();
+            t += h;
+            ++steps;
+        }
+        return sum;
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    //////////////////////////////
+    // RING BUFFER DELAY LINE   //
+    //////////////////////////////
+    StateHistory history(0.0);
+
+    std::cout << "DelayHistory, 10 minute run (delay " << delay << " s)\n";
+    std::cout << "minute\tsteps\tns/step\tsize\tcapacity\n";
+
+    double t = 0;
+    unsigned int seed = 1;
+    double checksum = 0;
+    for (int minute = 1; minute <= 10; ++minute)
+    {
+        long steps = 0;
+        Clock::time_point start = Clock::now();
+        checksum += runSteps(history, t, 60.0*minute, seed, steps);
+        double ns = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        const DelayLine& line = history.committed.getLine();
+        std::cout << minute << "\t" << steps << "\t" << ns/steps << "\t"
+                  << line.getSize() << "\t" << line.getCapacity() << "\n";
+    }
+    std::cout << "committed " << history.committed.getNumCommitted()
+              << ", evaluated " << history.committed.getNumEvaluated() << "\n";
+
+    //////////////////////////////
+    // LEGACY SPLINE HISTORY    //
+    //////////////////////////////
+    SplineHistory legacy;
+
+    std::cout << "\nPiecewiseLinearFunction, first 5 seconds\n";
+    std::cout << "second\tsteps\tns/step\tsize\n";
+
+    t = 0;
+    seed = 1;
+    for (int second = 1; second <= 5; ++second)
+    {
+        long steps = 0;
+        Clock::time_point start = Clock::now();
+        checksum += runSteps(legacy, t, 1.0*second, seed, steps);
+        double ns = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        std::cout << second << "\t" << steps << "\t" << ns/steps << "\t"
+                  << legacy.spline.getSize() << "\n";
+    }
+
+    //////////////////////////////
+    // COMPACTED HISTORY        //
+    //////////////////////////////
+    std::cout << "\nCompacted DelayHistory, 1 minute run\n";
+    std::cout << "tolerance\tns/step\tmean size\tratio\tmax error\n";
+
+    double tolerances[] = {0.0, 1.0e-7, 1.0e-6, 1.0e-5, 1.0e-4};
+    for (double tolerance : tolerances)
+    {
+        StateHistory compacted(tolerance);
+
+        t = 0;
+        seed = 1;
+        long steps = 0;
+        Clock::time_point start = Clock::now();
+        checksum += runSteps(compacted, t, 60.0, seed, steps);
+        double ns = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        std::cout << tolerance << "\t" << ns/steps << "\t"
+                  << (double)compacted.sumSize/compacted.update.getNumEvaluated()
+                  << "\t" << compacted.committed.getLine().getCompactionRatio()
+                  << "\t" << compacted.maxError << "\n";
+    }
+
+    std::cout << "\n(checksum " << checksum << ")\n";
+
+    return 0;
+}
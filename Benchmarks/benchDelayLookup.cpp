@@ -0,0 +1,144 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchDelayLookup.cpp                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "DelayLine.h"
+#include <OpenSim/Common/PiecewiseLinearFunction.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Time lookups into a full delay window, the inner operation of
+ * Delay::getSignal. Each kernel of DelayLine is timed for queries marching
+ * forward in time, as the integrator asks for them, and for queries that
+ * step back by a few samples every fourth lookup, as a rejected step does.
+ * PiecewiseLinearFunction::calcValue over the same samples is timed for
+ * comparison. The maximum error against the sampled signal is reported at
+ * the midpoints between samples.
+ */
+
+namespace {
+
+    const double delay = 0.1;
+    const double step = 1.0e-4;
+    const int numLookups = 2000000;
+
+    double signal(double t) { return 0.5 + 0.5*std::sin(10*t); }
+
+    // lookup times moving forward through the window, stepping back 3.5
+    // samples every fourth lookup when backtrack is set
+    double queryTime(int i, bool backtrack)
+    {
+        const int window = (int)(delay/step) - 8;
+        double x = (i % (4*window))/4.0;
+        if (backtrack && i % 4 == 3)
+        {
+            x = std::max(0.0, x - 3.5);
+        }
+        return 4*step + x*step;
+    }
+
+    template <class Lookup>
+    double timeLookups(const Lookup& lookup, bool backtrack, double& sum)
+    {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < numLookups; ++i)
+        {
+            sum += lookup(queryTime(i, backtrack));
+        }
+        double s = std::chrono::duration<double>(Clock::now() - start).count();
+        return numLookups/s;
+    }
+
+    struct LineLookup {
+        const DelayLine& line;
+        double operator()(double t) const { return line.getValue(t); }
+    };
+
+    struct SplineLookup {
+        const PiecewiseLinearFunction& spline;
+        double operator()(double t) const
+        {
+            return spline.calcValue(SimTK::Vector(1, t));
+        }
+    };
+
+}
+
+int main() {
+
+    const int numSamples = (int)(delay/step) + 1;
+    double checksum = 0;
+
+    std::cout << "Lookups into a " << delay << " s window of " << numSamples
+              << " samples\n";
+    std::cout << "kernel\t\tforward/s\tbacktrack/s\tmax error\n";
+
+    const char* names[] = {"zero_order_hold", "linear\t", "cubic_hermite"};
+    DelayLine::Interpolation kernels[] = {DelayLine::ZeroOrderHold,
+        DelayLine::Linear, DelayLine::CubicHermite};
+    for (int k = 0; k < 3; ++k)
+    {
+        DelayLine line;
+        line.reset(delay, step, 0, kernels[k]);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            line.push(i*step, signal(i*step));
+        }
+
+        double maxError = 0;
+        for (int i = 2; i < line.getSize() - 2; ++i)
+        {
+            double t = (i + 0.5)*step;
+            maxError = std::max(maxError,
+                                std::fabs(line.getValue(t) - signal(t)));
+        }
+
+        LineLookup lookup = {line};
+        double forward = timeLookups(lookup, false, checksum);
+        double backtrack = timeLookups(lookup, true, checksum);
+        std::cout << names[k] << "\t" << forward << "\t" << backtrack << "\t"
+                  << maxError << "\n";
+    }
+
+    PiecewiseLinearFunction spline;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        spline.addPoint(i*step, signal(i*step));
+    }
+    SplineLookup lookup = {spline};
+    double forward = timeLookups(lookup, false, checksum);
+    double backtrack = timeLookups(lookup, true, checksum);
+    std::cout << "PiecewiseLinear\t" << forward << "\t" << backtrack << "\n";
+
+    std::cout << "\n(checksum " << checksum << ")\n";
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchDelayModes.cpp                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Compare the history and Pade delay modes on the tug-of-war model with the
+ * reflex loop closed, so that the delay sits inside the loop the Pade mode
+ * turns into a smooth ODE: wall time and steps taken of a 10 second
+ * integration and the error of the delayed muscle_signal against the
+ * history mode, sampled every millisecond.
+ */
+
+namespace {
+
+    const double finalTime = 10.0;
+
+    struct Run {
+        double wallTime;
+        int steps;
+        std::vector<double> signal;
+    };
+
+    Run simulate(const std::string& mode, int padeOrder)
+    {
+        Model model;
+        buildTugOfWarModel(model, ReflexExcitation);
+
+        MuscleReflexCircuit& circuit =
+            model.updComponent<MuscleReflexCircuit>("reflex_circuit");
+        circuit.updDelay().setDelayMode(mode);
+        circuit.updDelay().setPadeOrder(padeOrder);
+
+        TableReporter* reporter = new TableReporter();
+        reporter->setName("signal_reporter");
+        reporter->set_report_time_interval(0.001);
+        reporter->addToReport(circuit.getOutput("muscle_signal"));
+        model.addComponent(reporter);
+
+        SimTK::State& si = initializeTugOfWarState(model);
+
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+
+        Run run;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        manager.initialize(si);
+        manager.integrate(finalTime);
+        run.wallTime = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        run.steps = manager.getIntegrator().getNumStepsTaken();
+
+        const TimeSeriesTable& table = reporter->getTable();
+        const auto& column = table.getDependentColumnAtIndex(0);
+        for (int i = 0; i < (int)column.size(); ++i)
+        {
+            run.signal.push_back(column[i]);
+        }
+        return run;
+    }
+
+}
+
+int main() {
+
+    try {
+        Run history = simulate("history", 4);
+
+        std::cout << "mode\torder\twall (s)\tsteps\trms error\tmax error\n";
+        std::cout << "history\t-\t" << history.wallTime << "\t"
+                  << history.steps << "\t0\t0\n";
+
+        int orders[] = {2, 4, 6, 8};
+        for (int order : orders)
+        {
+            Run pade = simulate("pade", order);
+
+            int n = (int)std::min(pade.signal.size(), history.signal.size());
+            double sumSquares = 0, maxError = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                double e = std::fabs(pade.signal[i] - history.signal[i]);
+                sumSquares += e*e;
+                maxError = std::max(maxError, e);
+            }
+
+            std::cout << "pade\t" << order << "\t" << pade.wallTime << "\t"
+                      << pade.steps << "\t"
+                      << std::sqrt(sumSquares/std::max(n, 1)) << "\t"
+                      << maxError << "\n";
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
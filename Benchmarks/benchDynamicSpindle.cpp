@@ -0,0 +1,242 @@
+/* -------------------------------------------------------------------------- *
+ *                     OpenSim:  benchDynamicSpindle.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include "SimpleSpindle.h"
+#include "DynamicSpindle.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Cost of a DynamicSpindle against a SimpleSpindle on original1 of the
+ * tug-of-war model. Each model is integrated for 1 s at an accuracy of
+ * 1e-6, and the steps, realizations and wall time of the integrator are
+ * reported together with the wall time per accepted step and its ratio
+ * between the two probes. For reference, the cost of realizing the model to
+ * Acceleration at a new time and reading the afferents of the probe is
+ * reported as well, net of the model without a probe.
+ *
+ * Finally the analytic Jacobian of the DynamicSpindle is compared with
+ * central differences of its state derivatives, at the end of the
+ * integration with fusimotor drive on.
+ *
+ * The benchmark exits with 1 if the Jacobian differs from the central
+ * differences by more than jacobianTolerance relative to its largest entry,
+ * or if an accepted integration step with a DynamicSpindle costs more than
+ * maxRatio steps with a SimpleSpindle.
+ */
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    const double jacobianTolerance = 1.0e-5;
+    const double maxRatio = 2.0;
+
+    enum Probe { None, Static, Dynamic };
+
+    void addProbe(Model& model, Probe probe)
+    {
+        const Muscle& muscle = model.getComponent<Muscle>("original1");
+        if (probe == Static)
+        {
+            model.addComponent(new SimpleSpindle("probe", muscle, 1.0));
+        }
+        else if (probe == Dynamic)
+        {
+            model.addComponent(new DynamicSpindle("probe", muscle, 70.0, 40.0));
+        }
+    }
+
+    double readProbe(const Model& model, const SimTK::State& s, Probe probe)
+    {
+        if (probe == Static)
+        {
+            const SimpleSpindle& spindle = model.getComponent<SimpleSpindle>("probe");
+            return spindle.getSpindleLength(s) + spindle.getSpindleSpeed(s);
+        }
+        if (probe == Dynamic)
+        {
+            const DynamicSpindle& spindle = model.getComponent<DynamicSpindle>("probe");
+            return spindle.getPrimaryAfferent(s) + spindle.getSecondaryAfferent(s);
+        }
+        return 0;
+    }
+
+    double timeRealizations(Probe probe, double& checksum)
+    {
+        Model model;
+        buildTugOfWarModel(model);
+        addProbe(model, probe);
+        SimTK::State s = initializeTugOfWarState(model);
+
+        const int numRealizations = 20000;
+        const double h = 1.0e-4;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < numRealizations; ++i)
+        {
+            s.setTime(i*h);
+            model.realizeAcceleration(s);
+            checksum += readProbe(model, s, probe);
+        }
+        return std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count()/numRealizations;
+    }
+
+    struct Integration {
+        double nsPerStep;
+        // error of the Jacobian of a DynamicSpindle relative to its largest
+        // entry, 0 for the other probes
+        double jacobianError;
+    };
+
+    Integration integrate(Probe probe, const std::string& label)
+    {
+        Model model;
+        buildTugOfWarModel(model);
+        addProbe(model, probe);
+        SimTK::State& si = initializeTugOfWarState(model);
+
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+        Clock::time_point start = Clock::now();
+        manager.initialize(si);
+        manager.integrate(1.0);
+        double wallTime = std::chrono::duration<double>(
+            Clock::now() - start).count();
+
+        const SimTK::Integrator& integrator = manager.getIntegrator();
+        Integration result;
+        result.nsPerStep =
+            1.0e9*wallTime/std::max(integrator.getNumStepsTaken(), 1);
+        result.jacobianError = 0;
+        std::cout << label << "\t" << integrator.getNumStepsTaken() << "\t"
+                  << integrator.getNumStepsAttempted() - integrator.getNumStepsTaken()
+                  << "\t" << integrator.getNumRealizations() << "\t"
+                  << wallTime << "\t" << result.nsPerStep << "\n";
+
+        if (probe != Dynamic)
+        {
+            return result;
+        }
+
+        // the Jacobian against central differences at the final state
+        const DynamicSpindle& spindle = model.getComponent<DynamicSpindle>("probe");
+        SimTK::State s = manager.getState();
+        model.realizeVelocity(s);
+        SimTK::Matrix J = spindle.getStateJacobian(s);
+
+        const int n = SpindleDynamics::NumStates;
+        double maxError = 0, maxEntry = 0;
+        for (int j = 0; j < n; ++j)
+        {
+            const char* name = DynamicSpindle::getStateName(j);
+            double y = spindle.getStateVariableValue(s, name);
+            double dy = 1.0e-6*std::max(1.0, std::fabs(y));
+            SimTK::Vector plus(n), minus(n);
+
+            spindle.setStateVariableValue(s, name, y + dy);
+            model.realizeAcceleration(s);
+            for (int i = 0; i < n; ++i)
+            {
+                plus[i] = spindle.getStateVariableDerivativeValue(s,
+                    DynamicSpindle::getStateName(i));
+            }
+            spindle.setStateVariableValue(s, name, y - dy);
+            model.realizeAcceleration(s);
+            for (int i = 0; i < n; ++i)
+            {
+                minus[i] = spindle.getStateVariableDerivativeValue(s,
+                    DynamicSpindle::getStateName(i));
+            }
+            spindle.setStateVariableValue(s, name, y);
+
+            for (int i = 0; i < n; ++i)
+            {
+                double difference = (plus[i] - minus[i])/(2*dy);
+                maxError = std::max(maxError, std::fabs(difference - J(i, j)));
+                maxEntry = std::max(maxEntry, std::fabs(J(i, j)));
+            }
+        }
+        std::cout << "\nJacobian max entry\t" << maxEntry << "\n";
+        std::cout << "max difference from central differences\t" << maxError
+                  << "\n";
+        result.jacobianError = maxError/std::max(1.0, maxEntry);
+        return result;
+    }
+
+}
+
+int main() {
+
+    try {
+        std::cout << "probe\taccepted\trejected\trealizations\twall (s)\t"
+                  << "ns/step\n";
+        integrate(None, "none");
+        Integration simple = integrate(Static, "SimpleSpindle");
+        Integration dynamic = integrate(Dynamic, "DynamicSpindle");
+        double ratio = dynamic.nsPerStep/simple.nsPerStep;
+        std::cout << "ratio per step\t" << ratio << "\n\n";
+
+        double checksum = 0;
+        double baseNs = timeRealizations(None, checksum);
+        std::cout << "realizeAcceleration ns\t" << baseNs << "\n";
+        std::cout << "SimpleSpindle ns/realization\t"
+                  << timeRealizations(Static, checksum) - baseNs << "\n";
+        std::cout << "DynamicSpindle ns/realization\t"
+                  << timeRealizations(Dynamic, checksum) - baseNs << "\n";
+
+        std::cout << "\n(checksum " << checksum << ")\n";
+
+        if (dynamic.jacobianError > jacobianTolerance)
+        {
+            std::cout << "\nFAILED: relative Jacobian error "
+                      << dynamic.jacobianError << " above "
+                      << jacobianTolerance << "\n";
+            return 1;
+        }
+        if (ratio > maxRatio)
+        {
+            std::cout << "\nFAILED: cost ratio per step " << ratio
+                      << " above " << maxRatio << "\n";
+            return 1;
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
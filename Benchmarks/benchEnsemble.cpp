@@ -0,0 +1,133 @@
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim:  benchEnsemble.cpp                         *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "ReflexSweep.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Throughput of the lockstep ensemble against independent runs. Ensembles of
+ * K = 1, 4, 16 and 64 property sets of the reflex circuit, thresholds and
+ * time delays spread around those of mainSimulation.cpp, are run for 2 s of
+ * the tug-of-war model on one core: once as K independent variable step
+ * runs at an accuracy of 1e-6, as ReflexSweep::run() on one thread, and
+ * once in lockstep at fixed steps of 1 ms and 0.5 ms. The throughput is
+ * reported in variant-seconds simulated per wall-second, together with the
+ * largest difference of the final block position and mean signal of the
+ * lockstep runs from the independent ones.
+ */
+
+namespace {
+
+    const double finalTime = 2.0;
+
+    double throughput(const std::vector<ReflexSweepResult>& results,
+                      double wallTime)
+    {
+        double simulated = 0;
+        for (const ReflexSweepResult& result : results)
+        {
+            simulated += result.endTime;
+        }
+        return simulated/wallTime;
+    }
+
+    double maxDifference(const std::vector<ReflexSweepResult>& results,
+                         const std::vector<ReflexSweepResult>& reference)
+    {
+        double difference = 0;
+        for (int i = 0; i < (int)results.size(); ++i)
+        {
+            if (!results[i].error.empty())
+            {
+                std::cout << "point " << i << ": " << results[i].error << "\n";
+            }
+            difference = std::max(difference, std::fabs(
+                results[i].finalPosition - reference[i].finalPosition));
+            difference = std::max(difference, std::fabs(
+                results[i].meanSignal - reference[i].meanSignal));
+        }
+        return difference;
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    try {
+        const int ensembleSizes[] = {1, 4, 16, 64};
+        const double stepSizes[] = {1.0e-3, 0.5e-3};
+
+        std::cout << "K\tmode\twall (s)\tvariant-s/wall-s\tspeedup\t"
+                  << "max difference\n";
+        for (int K : ensembleSizes)
+        {
+            ReflexSweep sweep;
+            sweep.setFinalTime(finalTime);
+            ReflexParameters parameters = ReflexSweep::getDefaultParameters();
+            for (int k = 0; k < K; ++k)
+            {
+                parameters.threshold = 0.05 + 0.15*(k % 8)/7.0;
+                parameters.timeDelay = 0.05 + 0.15*(k/8 % 8)/7.0;
+                sweep.addPoint(parameters);
+            }
+
+            Clock::time_point start = Clock::now();
+            std::vector<ReflexSweepResult> reference = sweep.run(1);
+            double independentTime =
+                std::chrono::duration<double>(Clock::now() - start).count();
+            double independent = throughput(reference, independentTime);
+            std::cout << K << "\tindependent\t" << independentTime << "\t"
+                      << independent << "\t1\t0\n";
+
+            for (double h : stepSizes)
+            {
+                start = Clock::now();
+                std::vector<ReflexSweepResult> results = sweep.runEnsemble(h);
+                double wallTime =
+                    std::chrono::duration<double>(Clock::now() - start).count();
+                double lockstep = throughput(results, wallTime);
+                std::cout << K << "\tlockstep h=" << h << "\t" << wallTime
+                          << "\t" << lockstep << "\t" << lockstep/independent
+                          << "\t" << maxDifference(results, reference) << "\n";
+            }
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
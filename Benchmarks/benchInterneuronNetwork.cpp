@@ -0,0 +1,228 @@
+/* -------------------------------------------------------------------------- *
+ *                   OpenSim:  benchInterneuronNetwork.cpp                    *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "InterneuronNetwork.h"
+#include "SimpleSpindle.h"
+#include "GolgiTendon.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Evaluate an InterneuronNetwork over 2 to 1000 muscles. Each model is a
+ * block on a slider pulled by N Millard muscles in agonist-antagonist pairs
+ * from the two sides, every muscle with its own spindle and Golgi tendon.
+ * The network has one motor pool per muscle, excited by the spindle length,
+ * spindle speed and Golgi length of its muscle and inhibited by the spindle
+ * length of its antagonist, i.e. four non-zero weights per pool. The
+ * weights are written to and read back from a file.
+ *
+ * The network is timed at new times on the same State, net of realizing the
+ * model to Velocity on its own, and reported per non-zero weight, which
+ * stays flat if the cost is proportional to them. The signals are checked
+ * against a dense weighted sum of the afferent outputs.
+ */
+
+namespace {
+
+    void buildModel(Model& model, int numMuscles, const std::string& weightsFile)
+    {
+        model.setName("interneuronNetwork");
+        Ground& ground = model.updGround();
+
+        double blockMass = 20.0, blockSideLength = 0.1;
+        OpenSim::Body* block = new OpenSim::Body("block", blockMass, Vec3(0),
+            blockMass*Inertia::brick(blockSideLength, blockSideLength,
+                                     blockSideLength));
+        SliderJoint* slider = new SliderJoint("slider", ground, *block);
+        model.addBody(block);
+        model.addJoint(slider);
+
+        SparseWeights weights;
+        InterneuronNetwork* network =
+            new InterneuronNetwork("network", weightsFile);
+
+        double maxIsometricForce = 1000.0, optimalFiberLength = 0.2,
+        tendonSlackLength = 0.1, pennationAngle = 0.0;
+        for (int i = 0; i < numMuscles; ++i)
+        {
+            std::ostringstream suffix;
+            suffix << i;
+            Millard2012EquilibriumMuscle* muscle =
+                new Millard2012EquilibriumMuscle("muscle" + suffix.str(),
+                    maxIsometricForce, optimalFiberLength, tendonSlackLength,
+                    pennationAngle);
+            // agonists pull from the left, antagonists from the right
+            double side = i % 2 == 0 ? -1.0 : 1.0;
+            double offset = 0.05*std::sin(0.7*i);
+            muscle->addNewPathPoint("point1", ground,
+                Vec3(side*(0.35 + offset), 0, 0.01*i));
+            muscle->addNewPathPoint("point2", *block, Vec3(0, 0, 0.01*i));
+            muscle->setDefaultActivation(0.1);
+            muscle->setDefaultFiberLength(optimalFiberLength);
+            model.addForce(muscle);
+
+            SimpleSpindle* spindle = new SimpleSpindle("spindle" + suffix.str(),
+                *muscle, 0.9 + 0.2*(i % 3)/2.0);
+            GolgiTendon* golgi = new GolgiTendon("golgi" + suffix.str(), *muscle);
+            model.addComponent(spindle);
+            model.addComponent(golgi);
+
+            // afferents 3i, 3i+1 and 3i+2 of the network
+            network->connectInput_afferents(spindle->getOutput("spindle_length"));
+            network->connectInput_afferents(spindle->getOutput("spindle_speed"));
+            network->connectInput_afferents(golgi->getOutput("golgiLength"));
+
+            int antagonist = i % 2 == 0 ? i + 1 : i - 1;
+            weights.addNeuron("pool" + suffix.str(), 0.02);
+            weights.addWeight(3*i, 0.4);
+            weights.addWeight(3*i + 1, 0.4);
+            weights.addWeight(3*i + 2, 0.2);
+            if (antagonist < numMuscles)
+            {
+                weights.addWeight(3*antagonist, -0.3);
+            }
+        }
+
+        std::ofstream file(weightsFile.c_str());
+        file << "# " << numMuscles << " motor pools with reciprocal inhibition\n";
+        weights.write(file);
+        file.close();
+
+        model.addComponent(network);
+        model.setUseVisualizer(false);
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+    const std::string weightsFile = "benchInterneuronNetwork.txt";
+
+    try {
+        std::cout << "muscles\tnon-zeros\trealize ns\tnetwork ns\t"
+                  << "ns/non-zero\tmax difference\n";
+
+        const int sizes[] = {2, 10, 50, 100, 200, 500, 1000};
+        for (int numMuscles : sizes)
+        {
+            Model model;
+            buildModel(model, numMuscles, weightsFile);
+            SimTK::State s = model.initSystem();
+            model.equilibrateMuscles(s);
+
+            const InterneuronNetwork& network =
+                model.getComponent<InterneuronNetwork>("network");
+            const SparseWeights& weights = network.getWeights();
+
+            // sweep the block so that every stretch and speed changes
+            const Coordinate& x = model.getCoordinateSet()[0];
+            const int numEvaluations = std::max(20, 20000/numMuscles);
+            const double h = 1.0e-4;
+            double checksum = 0;
+            auto setTime = [&](int i)
+            {
+                double t = i*h;
+                s.setTime(t);
+                x.setValue(s, 0.02*std::sin(5*t), false);
+                x.setSpeedValue(s, 0.1*std::cos(5*t));
+            };
+
+            // realizing on its own
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < numEvaluations; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+            }
+            double realizeNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numEvaluations;
+
+            start = Clock::now();
+            for (int i = 0; i < numEvaluations; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+                checksum += network.getSignals(s)[numMuscles - 1];
+            }
+            double networkNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numEvaluations - realizeNs;
+
+            // a dense weighted sum of the afferent outputs on the last State
+            const Input<double>& afferents = network.getInput<double>("afferents");
+            std::vector<double> values(afferents.getNumConnectees());
+            for (int j = 0; j < (int)values.size(); ++j)
+            {
+                values[j] = afferents.getValue(s, j);
+            }
+            std::vector<double> dense(values.size());
+            double maxDifference = 0;
+            for (int i = 0; i < numMuscles; ++i)
+            {
+                std::fill(dense.begin(), dense.end(), 0.0);
+                dense[3*i] = 0.4;
+                dense[3*i + 1] = 0.4;
+                dense[3*i + 2] = 0.2;
+                int antagonist = i % 2 == 0 ? i + 1 : i - 1;
+                if (antagonist < numMuscles)
+                {
+                    dense[3*antagonist] = -0.3;
+                }
+                double sum = 0;
+                for (int j = 0; j < (int)values.size(); ++j)
+                {
+                    sum += dense[j]*values[j];
+                }
+                double expected = sum > weights.getThreshold(i) ? sum : 0.0;
+                maxDifference = std::max(maxDifference,
+                    std::fabs(expected - network.getNeuronSignal(s, i)));
+            }
+
+            std::cout << numMuscles << "\t" << weights.getNumNonZeros() << "\t"
+                      << realizeNs << "\t" << networkNs << "\t"
+                      << networkNs/weights.getNumNonZeros() << "\t"
+                      << maxDifference << "\t(checksum " << checksum << ")\n";
+        }
+        std::remove(weightsFile.c_str());
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        std::remove(weightsFile.c_str());
+        return 1;
+    }
+
+    return 0;
+}
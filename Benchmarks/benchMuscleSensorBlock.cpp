@@ -0,0 +1,222 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchMuscleSensorBlock.cpp                    *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "SimpleSpindle.h"
+#include "GolgiTendon.h"
+#include "MuscleSensorBlock.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Sensor cost per step of a SimpleSpindle and GolgiTendon pair against a
+ * MuscleSensorBlock on the same muscle, for 2 to 500 muscles. Each model is
+ * a block on a slider pulled by N Millard muscles, every muscle with a pair
+ * and a block. A step is realizing the model to Velocity at a new time and
+ * reading the three afferents of every muscle, from the pairs or from the
+ * blocks. Both are reported per muscle net of realizing on its own,
+ * together with the largest difference between the two.
+ *
+ * The optimal fiber length of a muscle is then edited without building the
+ * system again, and the afferents of the pair and the block are compared
+ * once more to check that the block does not keep a stale snapshot.
+ */
+
+namespace {
+
+    void buildModel(Model& model, int numMuscles)
+    {
+        model.setName("muscleSensorBlock");
+        Ground& ground = model.updGround();
+
+        double blockMass = 20.0, blockSideLength = 0.1;
+        OpenSim::Body* block = new OpenSim::Body("block", blockMass, Vec3(0),
+            blockMass*Inertia::brick(blockSideLength, blockSideLength,
+                                     blockSideLength));
+        SliderJoint* slider = new SliderJoint("slider", ground, *block);
+        model.addBody(block);
+        model.addJoint(slider);
+
+        double maxIsometricForce = 1000.0, optimalFiberLength = 0.2,
+        tendonSlackLength = 0.1, pennationAngle = 0.0;
+        for (int i = 0; i < numMuscles; ++i)
+        {
+            std::ostringstream suffix;
+            suffix << i;
+            Millard2012EquilibriumMuscle* muscle =
+                new Millard2012EquilibriumMuscle("muscle" + suffix.str(),
+                    maxIsometricForce, optimalFiberLength, tendonSlackLength,
+                    pennationAngle);
+            // spread the anchors so that the muscles differ in length
+            double offset = 0.05*std::sin(0.7*i);
+            muscle->addNewPathPoint("point1", ground,
+                Vec3(-0.35 + offset, 0, 0.01*i));
+            muscle->addNewPathPoint("point2", *block, Vec3(0, 0, 0.01*i));
+            muscle->setDefaultActivation(0.1);
+            muscle->setDefaultFiberLength(optimalFiberLength);
+            model.addForce(muscle);
+
+            double restLength = 0.9 + 0.2*(i % 3)/2.0;
+            model.addComponent(new SimpleSpindle("spindle" + suffix.str(),
+                *muscle, restLength));
+            model.addComponent(new GolgiTendon("golgi" + suffix.str(), *muscle));
+            model.addComponent(new MuscleSensorBlock("sensors" + suffix.str(),
+                *muscle, restLength));
+        }
+
+        model.setUseVisualizer(false);
+    }
+
+    double maxDifference(const SimTK::State& s,
+                         const std::vector<const SimpleSpindle*>& spindles,
+                         const std::vector<const GolgiTendon*>& golgis,
+                         const std::vector<const MuscleSensorBlock*>& blocks)
+    {
+        double difference = 0;
+        for (int i = 0; i < (int)blocks.size(); ++i)
+        {
+            difference = std::max(difference, std::fabs(
+                spindles[i]->getSpindleLength(s) - blocks[i]->getSpindleLength(s)));
+            difference = std::max(difference, std::fabs(
+                spindles[i]->getSpindleSpeed(s) - blocks[i]->getSpindleSpeed(s)));
+            difference = std::max(difference, std::fabs(
+                golgis[i]->getTendonLength(s) - blocks[i]->getTendonLength(s)));
+        }
+        return difference;
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    try {
+        std::cout << "muscles\trealize ns\tpair ns/muscle\tblock ns/muscle\t"
+                  << "speedup\tmax difference\tafter edit\n";
+
+        const int sizes[] = {2, 5, 10, 20, 50, 100, 200, 500};
+        for (int numMuscles : sizes)
+        {
+            Model model;
+            buildModel(model, numMuscles);
+            SimTK::State s = model.initSystem();
+            model.equilibrateMuscles(s);
+
+            std::vector<const SimpleSpindle*> spindles;
+            std::vector<const GolgiTendon*> golgis;
+            std::vector<const MuscleSensorBlock*> blocks;
+            for (int i = 0; i < numMuscles; ++i)
+            {
+                std::ostringstream suffix;
+                suffix << i;
+                spindles.push_back(&model.getComponent<SimpleSpindle>("spindle" + suffix.str()));
+                golgis.push_back(&model.getComponent<GolgiTendon>("golgi" + suffix.str()));
+                blocks.push_back(&model.getComponent<MuscleSensorBlock>("sensors" + suffix.str()));
+            }
+
+            // sweep the block so that every stretch and speed changes
+            const Coordinate& x = model.getCoordinateSet()[0];
+            const int numSteps = std::max(20, 20000/numMuscles);
+            const double h = 1.0e-4;
+            double checksum = 0;
+            auto setTime = [&](int i)
+            {
+                double t = i*h;
+                s.setTime(t);
+                x.setValue(s, 0.02*std::sin(5*t), false);
+                x.setSpeedValue(s, 0.1*std::cos(5*t));
+            };
+
+            // realizing on its own
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < numSteps; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+            }
+            double realizeNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numSteps;
+
+            start = Clock::now();
+            for (int i = 0; i < numSteps; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+                for (int m = 0; m < numMuscles; ++m)
+                {
+                    checksum += spindles[m]->getSpindleLength(s)
+                              + spindles[m]->getSpindleSpeed(s)
+                              + golgis[m]->getTendonLength(s);
+                }
+            }
+            double pairNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numSteps - realizeNs;
+
+            start = Clock::now();
+            for (int i = 0; i < numSteps; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+                for (int m = 0; m < numMuscles; ++m)
+                {
+                    checksum += blocks[m]->getSpindleLength(s)
+                              + blocks[m]->getSpindleSpeed(s)
+                              + blocks[m]->getTendonLength(s);
+                }
+            }
+            double blockNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numSteps - realizeNs;
+
+            double difference = maxDifference(s, spindles, golgis, blocks);
+
+            // edit a muscle without building the system again
+            Muscle& muscle = model.updComponent<Muscle>("muscle0");
+            muscle.setOptimalFiberLength(0.25);
+            setTime(numSteps);
+            model.realizeVelocity(s);
+            double edited = maxDifference(s, spindles, golgis, blocks);
+
+            std::cout << numMuscles << "\t" << realizeNs << "\t"
+                      << pairNs/numMuscles << "\t" << blockNs/numMuscles << "\t"
+                      << pairNs/blockNs << "\t" << difference << "\t"
+                      << edited << "\t(checksum " << checksum << ")\n";
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim:  benchReentrant.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Stress test of integrating one finalized model from many States at once.
+ * The model of mainSimulation.cpp, original1 driven by its reflex circuit,
+ * is built once. 16 threads each copy its initial State and integrate it
+ * for 1 s, three times over, each with an integrator and time stepper of
+ * its own on the shared System. Every run must end in exactly the State of
+ * a serial run, since the reflex components keep all of their per-run data
+ * in the State. Build with ENABLE_TSAN to check the runs for data races
+ * under ThreadSanitizer.
+ *
+ * The memory and setup time of 16 such runs are then compared with the
+ * usual alternative of a model clone per thread, each with its own System,
+ * from the resident set size of the process.
+ *
+ * The benchmark exits with 1 if any run differs from the serial run.
+ */
+
+namespace {
+
+    const int numThreads = 16;
+    const int numRounds = 3;
+    const double finalTime = 1.0;
+
+    // resident set size of the process in MB, 0 where it cannot be read
+    double residentMB()
+    {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        long pages = 0, resident = 0;
+        if (statm >> pages >> resident)
+        {
+            return resident*(double)sysconf(_SC_PAGESIZE)/(1024.0*1024.0);
+        }
+#endif
+        return 0;
+    }
+
+    SimTK::Vector integrate(const Model& model, const SimTK::State& initial)
+    {
+        SimTK::State s = initial;
+        SimTK::RungeKuttaMersonIntegrator integrator(model.getMultibodySystem());
+        integrator.setAccuracy(1.0e-6);
+        SimTK::TimeStepper stepper(model.getMultibodySystem(), integrator);
+        stepper.initialize(s);
+        stepper.stepTo(finalTime);
+        return stepper.getState().getY();
+    }
+
+    // largest difference of a and b, infinite if they differ in size or in
+    // a NaN
+    double maxDifference(const SimTK::Vector& a, const SimTK::Vector& b)
+    {
+        if (a.size() != b.size())
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        double difference = 0;
+        for (int i = 0; i < a.size(); ++i)
+        {
+            if (a[i] != b[i])
+            {
+                double d = std::fabs(a[i] - b[i]);
+                difference = std::max(difference, d == d ? d :
+                    std::numeric_limits<double>::infinity());
+            }
+        }
+        return difference;
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    try {
+        double startMB = residentMB();
+
+        Model model;
+        buildTugOfWarModel(model, ReflexExcitation);
+        SimTK::State initial = initializeTugOfWarState(model);
+        initial.setTime(0.0);
+        double modelMB = residentMB() - startMB;
+
+        SimTK::Vector reference = integrate(model, initial);
+
+        // every thread integrates copies of the initial State on the
+        // shared model
+        std::vector<double> differences(numThreads, 0.0);
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            threads.push_back(std::thread([&, t]()
+            {
+                for (int round = 0; round < numRounds; ++round)
+                {
+                    differences[t] = std::max(differences[t],
+                        maxDifference(integrate(model, initial), reference));
+                }
+            }));
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        double sharedTime = std::chrono::duration<double>(
+            Clock::now() - start).count();
+
+        std::cout << numThreads << " threads x " << numRounds << " runs of "
+                  << finalTime << " s on one model\t" << sharedTime << " s\n";
+        double sharedDifference =
+            *std::max_element(differences.begin(), differences.end());
+        std::cout << "max difference from the serial run\t"
+                  << sharedDifference << "\n\n";
+
+        // memory and setup of a State per run against a model per run
+        double before = residentMB();
+        start = Clock::now();
+        std::vector<SimTK::State> states(numThreads, initial);
+        double stateTime = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        double stateMB = residentMB() - before;
+
+        before = residentMB();
+        start = Clock::now();
+        std::vector<std::unique_ptr<Model> > clones;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            clones.push_back(std::unique_ptr<Model>(model.clone()));
+            initializeTugOfWarState(*clones.back());
+        }
+        double cloneTime = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        double cloneMB = residentMB() - before;
+
+        std::cout << "setup of " << numThreads << " runs\tMB\tseconds\n";
+        std::cout << "model\t" << modelMB << "\t\n";
+        std::cout << "shared model, State per run\t" << stateMB << "\t"
+                  << stateTime << "\n";
+        std::cout << "model clone per run\t" << cloneMB << "\t"
+                  << cloneTime << "\n";
+        std::cout << "memory saved\t" << cloneMB - stateMB << "\n";
+
+        if (sharedDifference != 0)
+        {
+            std::cout << "\nFAILED: a run on the shared model differs from "
+                      << "the serial run\n";
+            return 1;
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/* -------------------------------------------------------------------------- *
+ *                  OpenSim:  benchReflexCircuitSet.cpp                       *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "MuscleReflexCircuit.h"
+#include "ReflexCircuitSet.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Evaluate the sensors and interneurons of 2 to 500 reflex circuits one
+ * component at a time and in one ReflexCircuitSet batch. Each model is a
+ * block on a slider pulled by N Millard muscles, every muscle with its own
+ * spindle, Golgi tendon and circuit, and every circuit in the set. The
+ * component path reads the Interneuron signal of every circuit, the batch
+ * path reads the set. Both are timed at new times on the same State and
+ * reported per circuit net of realizing the model to Velocity, together
+ * with the largest difference between the two signals.
+ */
+
+namespace {
+
+    void buildModel(Model& model, int numCircuits)
+    {
+        model.setName("reflexCircuitSet");
+        Ground& ground = model.updGround();
+
+        double blockMass = 20.0, blockSideLength = 0.1;
+        OpenSim::Body* block = new OpenSim::Body("block", blockMass, Vec3(0),
+            blockMass*Inertia::brick(blockSideLength, blockSideLength,
+                                     blockSideLength));
+        SliderJoint* slider = new SliderJoint("slider", ground, *block);
+        model.addBody(block);
+        model.addJoint(slider);
+
+        ReflexCircuitSet* set = new ReflexCircuitSet("circuit_set");
+        model.addComponent(set);
+
+        double maxIsometricForce = 1000.0, optimalFiberLength = 0.2,
+        tendonSlackLength = 0.1, pennationAngle = 0.0;
+        for (int i = 0; i < numCircuits; ++i)
+        {
+            std::ostringstream suffix;
+            suffix << i;
+            Millard2012EquilibriumMuscle* muscle =
+                new Millard2012EquilibriumMuscle("muscle" + suffix.str(),
+                    maxIsometricForce, optimalFiberLength, tendonSlackLength,
+                    pennationAngle);
+            // spread the anchors so that the muscles differ in length
+            double offset = 0.05*std::sin(0.7*i);
+            muscle->addNewPathPoint("point1", ground,
+                Vec3(-0.35 + offset, 0, 0.01*i));
+            muscle->addNewPathPoint("point2", *block, Vec3(0, 0, 0.01*i));
+            muscle->setDefaultActivation(0.1);
+            muscle->setDefaultFiberLength(optimalFiberLength);
+            model.addForce(muscle);
+
+            SimpleSpindle* spindle = new SimpleSpindle("spindle" + suffix.str(),
+                *muscle, 0.9 + 0.2*(i % 3)/2.0);
+            GolgiTendon* golgi = new GolgiTendon("golgi" + suffix.str(), *muscle);
+            model.addComponent(spindle);
+            model.addComponent(golgi);
+
+            MuscleReflexCircuit* circuit = new MuscleReflexCircuit(
+                "circuit" + suffix.str(), *muscle, *spindle, *golgi,
+                0.02, 0.05, 0.5);
+            circuit->append_weights(0.4);
+            circuit->append_weights(0.4);
+            circuit->append_weights(0.2);
+            circuit->setCircuitSet("circuit_set");
+            model.addComponent(circuit);
+        }
+
+        model.setUseVisualizer(false);
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    try {
+        std::cout << "circuits\trealize ns\tcomponents ns/circuit\t"
+                  << "set ns/circuit\tspeedup\tmax difference\n";
+
+        const int sizes[] = {2, 5, 10, 20, 50, 100, 200, 500};
+        for (int numCircuits : sizes)
+        {
+            Model model;
+            buildModel(model, numCircuits);
+            SimTK::State s = model.initSystem();
+            model.equilibrateMuscles(s);
+
+            const ReflexCircuitSet& set =
+                model.getComponent<ReflexCircuitSet>("circuit_set");
+            std::vector<const MuscleReflexCircuit*> circuits;
+            for (const MuscleReflexCircuit& circuit :
+                 model.getComponentList<MuscleReflexCircuit>())
+            {
+                circuits.push_back(&circuit);
+            }
+
+            // sweep the block so that every stretch and speed changes
+            const Coordinate& x = model.getCoordinateSet()[0];
+            const int numEvaluations = std::max(20, 20000/numCircuits);
+            const double h = 1.0e-4;
+            double checksum = 0;
+            double maxDifference = 0;
+            auto setTime = [&](int i)
+            {
+                double t = i*h;
+                s.setTime(t);
+                x.setValue(s, 0.02*std::sin(5*t), false);
+                x.setSpeedValue(s, 0.1*std::cos(5*t));
+            };
+
+            // realizing on its own
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < numEvaluations; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+            }
+            double realizeNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numEvaluations;
+
+            // one component chain per circuit
+            start = Clock::now();
+            for (int i = 0; i < numEvaluations; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+                for (const MuscleReflexCircuit* circuit : circuits)
+                {
+                    checksum += circuit->getInterneuron().getSignal(s);
+                }
+            }
+            double componentNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numEvaluations - realizeNs;
+
+            // one batch for the set
+            start = Clock::now();
+            for (int i = 0; i < numEvaluations; ++i)
+            {
+                setTime(i);
+                model.realizeVelocity(s);
+                checksum += set.getValues(s)[4*numCircuits - 1];
+            }
+            double setNs = std::chrono::duration<double, std::nano>(
+                Clock::now() - start).count()/numEvaluations - realizeNs;
+
+            // both paths on the last State
+            const SimTK::Vector& values = set.getValues(s);
+            for (const MuscleReflexCircuit* circuit : circuits)
+            {
+                int index = set.getCircuitIndex(circuit->getName());
+                maxDifference = std::max(maxDifference, std::fabs(
+                    circuit->getInterneuron().getSignal(s) -
+                    values[3*numCircuits + index]));
+            }
+
+            std::cout << numCircuits << "\t" << realizeNs << "\t"
+                      << componentNs/numCircuits << "\t"
+                      << setNs/numCircuits << "\t" << componentNs/setNs << "\t"
+                      << maxDifference << "\t(checksum " << checksum << ")\n";
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
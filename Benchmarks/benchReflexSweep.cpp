@@ -0,0 +1,121 @@
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim:  benchReflexSweep.cpp                       *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "ReflexSweep.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Scaling of ReflexSweep with the number of threads. A grid of 24 property
+ * sets of the reflex circuit, 4 thresholds by 3 time delays by 2 sets of
+ * weights, is run for 2 s of the tug-of-war model on 1, 2, 4, ... threads
+ * up to the hardware threads. The wall time, the speed-up over one thread
+ * and the parallel efficiency are reported, together with the largest
+ * difference of the results from those of one thread, which must be 0
+ * since every run has a model and State of its own.
+ *
+ * The same grid is then run in worker processes, one per hardware thread,
+ * to show the overhead of the processes and of merging their result files
+ * against the threads.
+ */
+
+int main() {
+
+    try {
+        ReflexSweep sweep;
+        sweep.setFinalTime(2.0);
+        sweep.addGrid({0.05, 0.1, 0.15, 0.2}, {0.05, 0.1, 0.2}, {0.5},
+                      {{0.4, 0.4, 0.2}, {0.6, 0.2, 0.2}});
+
+        int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+        std::vector<int> threadCounts;
+        for (int n = 1; n < maxThreads; n *= 2)
+        {
+            threadCounts.push_back(n);
+        }
+        threadCounts.push_back(maxThreads);
+
+        std::cout << sweep.getNumPoints() << " points, "
+                  << sweep.getFinalTime() << " s each\n";
+        std::cout << "threads\twall (s)\tspeedup\tefficiency\tmax difference\n";
+
+        std::vector<ReflexSweepResult> reference;
+        double serialTime = 0;
+        for (int k = 0; k <= (int)threadCounts.size(); ++k)
+        {
+            // the last row runs in processes
+            bool processes = k == (int)threadCounts.size();
+            int numThreads = processes ? maxThreads : threadCounts[k];
+            std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            std::vector<ReflexSweepResult> results = processes ?
+                sweep.runProcesses(numThreads, 600, 1) : sweep.run(numThreads);
+            double wallTime = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            if (reference.empty())
+            {
+                reference = results;
+                serialTime = wallTime;
+            }
+
+            double maxDifference = 0;
+            for (int i = 0; i < (int)results.size(); ++i)
+            {
+                if (!results[i].error.empty())
+                {
+                    std::cout << "point " << i << ": " << results[i].error << "\n";
+                }
+                maxDifference = std::max(maxDifference, std::fabs(
+                    results[i].finalPosition - reference[i].finalPosition));
+                maxDifference = std::max(maxDifference, std::fabs(
+                    results[i].meanSignal - reference[i].meanSignal));
+            }
+
+            double speedup = serialTime/wallTime;
+            std::cout << numThreads << (processes ? " processes" : "")
+                      << "\t" << wallTime << "\t" << speedup
+                      << "\t" << speedup/numThreads << "\t" << maxDifference
+                      << "\n";
+        }
+
+        std::cout << "\n";
+        ReflexSweep::writeTable(std::cout, reference);
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/* -------------------------------------------------------------------------- *
+ *                     OpenSim:  benchSpikeScheduler.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "SpikeScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Throughput of the SpikeScheduler of a spiking InterneuronNetwork with 1000
+ * to 20000 neurons on one core. The layer is run for 10 s of simulated time
+ * with the drives updated every millisecond, the default longest interval
+ * between the drive updates of the network: at every update a fifth of the
+ * neurons get a new drive between 0.4 and 1.0 against a threshold of 0.5,
+ * so about 5/6 of them fire.
+ * Reported are the spikes and the events (spikes, deliveries and stale
+ * predictions) processed per second of wall time, and the queue size at the
+ * end.
+ *
+ * The scheduler is first checked against the closed form rate of a neuron
+ * with a constant drive, 1/(refractory + tau*log(drive/(drive - threshold))),
+ * and the benchmark exits with 1 if the spike count is off by more than one.
+ */
+
+namespace {
+
+    const double tau = 0.01, refractory = 0.002, spikeDelay = 0.02,
+                 traceTau = 0.05;
+
+    // deterministic uniform numbers in [0, 1)
+    struct Random {
+        unsigned state;
+        double next()
+        {
+            state = state*1664525u + 1013904223u;
+            return (state >> 8)/16777216.0;
+        }
+    };
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // a constant drive fires at the closed form rate
+    const double drive = 0.8, threshold = 0.5, duration = 10.0;
+    SpikeScheduler single;
+    single.reset(std::vector<double>(1, threshold), 0, tau, refractory,
+                 spikeDelay, traceTau);
+    single.setDrive(0, drive);
+    single.advanceTo(duration);
+    double expected = duration/(refractory +
+                                tau*std::log(drive/(drive - threshold)));
+    std::cout << "constant drive: " << single.getNumSpikes() << " spikes, "
+              << expected << " expected\n\n";
+    if (std::fabs(single.getNumSpikes() - expected) > 1)
+    {
+        std::cout << "MISMATCH\n";
+        return 1;
+    }
+
+    std::cout << "neurons\tspikes\tdeliveries\tstale\tqueue\twall (s)\t"
+              << "spikes/s\tevents/s\n";
+
+    const int sizes[] = {1000, 2000, 5000, 10000, 20000};
+    for (int numNeurons : sizes)
+    {
+        SpikeScheduler scheduler;
+        scheduler.reset(std::vector<double>(numNeurons, threshold), 0, tau,
+                        refractory, spikeDelay, traceTau);
+        Random random = {1};
+
+        const double interval = 1.0e-3;
+        const int numUpdates = (int)(duration/interval);
+        Clock::time_point start = Clock::now();
+        for (int k = 1; k <= numUpdates; ++k)
+        {
+            scheduler.advanceTo(k*interval);
+            for (int i = 0; i < numNeurons; ++i)
+            {
+                if (random.next() < 0.2)
+                {
+                    scheduler.setDrive(i, 0.4 + 0.6*random.next());
+                }
+            }
+        }
+        double wallTime = std::chrono::duration<double>(
+            Clock::now() - start).count();
+
+        long long events = scheduler.getNumSpikes() +
+                           scheduler.getNumDeliveries() +
+                           scheduler.getNumStale();
+        std::cout << numNeurons << "\t" << scheduler.getNumSpikes() << "\t"
+                  << scheduler.getNumDeliveries() << "\t"
+                  << scheduler.getNumStale() << "\t"
+                  << scheduler.getQueueSize() << "\t" << wallTime << "\t"
+                  << scheduler.getNumSpikes()/wallTime << "\t"
+                  << events/wallTime << "\n";
+    }
+
+    return 0;
+}
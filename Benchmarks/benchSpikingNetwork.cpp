@@ -0,0 +1,174 @@
+/* -------------------------------------------------------------------------- *
+ *                     OpenSim:  benchSpikingNetwork.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include "InterneuronNetwork.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Integrate the tug-of-war model for 2 s with an InterneuronNetwork of 1 to
+ * 200 motor pools on the spindle and Golgi of original1, in the 'rate' and
+ * in the 'spiking' mode, and once without a network. Every pool weighs the
+ * spindle length, spindle speed and Golgi length 0.6, 0.3 and 0.1, with
+ * thresholds spread from 0.2 to 1.2 so that some pools fire and some stay
+ * silent.
+ *
+ * Reported are the wall time of each integration and, for the spiking
+ * network, the spikes and deliveries of the final State. The spiking layer
+ * is updated at every spike and delivery as well as every
+ * drive_update_interval, so its cost over the rate network grows with the
+ * spikes. The benchmark exits with 1 if no pool fires or a spike fired more
+ * than the spike delay before the end was not delivered.
+ */
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    const double finalTime = 2.0;
+
+    // Add a network of numPools pools to a new tug-of-war model
+    void buildModel(Model& model, int numPools, const std::string& mode,
+                    const std::string& weightsFile)
+    {
+        buildTugOfWarModel(model);
+        if (numPools == 0)
+        {
+            return;
+        }
+
+        SparseWeights weights;
+        for (int i = 0; i < numPools; ++i)
+        {
+            std::ostringstream name;
+            name << "pool" << i;
+            weights.addNeuron(name.str(), 0.2 + i/(double)numPools);
+            weights.addWeight(0, 0.6);
+            weights.addWeight(1, 0.3);
+            weights.addWeight(2, 0.1);
+        }
+        std::ofstream file(weightsFile.c_str());
+        weights.write(file);
+        file.close();
+
+        InterneuronNetwork* network =
+            new InterneuronNetwork("network", weightsFile);
+        network->set_mode(mode);
+        const SimpleSpindle& spindle =
+            model.getComponent<SimpleSpindle>("muscle_spindle");
+        const GolgiTendon& golgi =
+            model.getComponent<GolgiTendon>("muscle_golgi");
+        network->connectInput_afferents(spindle.getOutput("spindle_length"));
+        network->connectInput_afferents(spindle.getOutput("spindle_speed"));
+        network->connectInput_afferents(golgi.getOutput("golgiLength"));
+        model.addComponent(network);
+    }
+
+    // Wall time (seconds) of integrating model from its initial State
+    double integrate(Model& model, SimTK::State& end)
+    {
+        SimTK::State& si = initializeTugOfWarState(model);
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+        manager.initialize(si);
+
+        Clock::time_point start = Clock::now();
+        end = manager.integrate(finalTime);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+}
+
+int main() {
+
+    const std::string weightsFile = "benchSpikingNetwork.txt";
+
+    try {
+        Model reference;
+        buildModel(reference, 0, "rate", weightsFile);
+        SimTK::State s;
+        double referenceWall = integrate(reference, s);
+        std::cout << "no network wall (s)\t" << referenceWall << "\n\n";
+
+        std::cout << "pools\trate wall (s)\tspiking wall (s)\tspikes\t"
+                  << "deliveries\n";
+
+        bool failed = false;
+        const int sizes[] = {1, 10, 50, 200};
+        for (int numPools : sizes)
+        {
+            Model rate;
+            buildModel(rate, numPools, "rate", weightsFile);
+            double rateWall = integrate(rate, s);
+
+            Model spiking;
+            buildModel(spiking, numPools, "spiking", weightsFile);
+            double spikingWall = integrate(spiking, s);
+
+            const InterneuronNetwork& network =
+                spiking.getComponent<InterneuronNetwork>("network");
+            const SpikeScheduler& scheduler = network.getSpikeScheduler(s);
+            // only the spikes of the last spike delay are in flight, at most
+            // one per refractory period and pool
+            long long inFlight = numPools*((long long)std::ceil(
+                network.get_spike_delay()/network.get_refractory_period()) + 1);
+            if (scheduler.getNumSpikes() == 0 ||
+                scheduler.getNumSpikes() - scheduler.getNumDeliveries() > inFlight)
+            {
+                failed = true;
+            }
+
+            std::cout << numPools << "\t" << rateWall << "\t" << spikingWall
+                      << "\t" << scheduler.getNumSpikes() << "\t"
+                      << scheduler.getNumDeliveries() << "\n";
+        }
+        std::remove(weightsFile.c_str());
+
+        if (failed)
+        {
+            std::cout << "\nFAILED: a network did not fire or lost deliveries\n";
+            return 1;
+        }
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        std::remove(weightsFile.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/* -------------------------------------------------------------------------- *
+ *                  OpenSim:  benchStaticReflexCircuit.cpp                    *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include <OpenSim/OpenSim.h>
+#include "TugOfWarModel.h"
+#include "SpindleGolgiReflexCircuit.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+//_____________________________________________________________________________
+/**
+ * Compare the generic reflex circuit of the tug-of-war model with a
+ * SpindleGolgiReflexCircuit of the same parameters on the same spindle and
+ * golgi. The model is integrated for 2 s and the muscle signals of the two
+ * circuits are compared every 10 ms, and the output counters of the static
+ * circuit are printed. Both circuits are then evaluated at new
+ * times on a copy of the final State and timed per evaluation, net of
+ * realizing the model to Velocity on its own. The static circuit is also
+ * written to and read back from XML to check that it serializes.
+ */
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    template <class Evaluate>
+    double timeEvaluations(const Model& model, SimTK::State& s, double t0,
+                           int numEvaluations, Evaluate evaluate)
+    {
+        const double h = 1.0e-4;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < numEvaluations; ++i)
+        {
+            s.setTime(t0 + i*h);
+            model.realizeVelocity(s);
+            evaluate(s);
+        }
+        return std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count()/numEvaluations;
+    }
+
+}
+
+int main() {
+
+    try {
+        Model model;
+        buildTugOfWarModel(model);
+        const MuscleReflexCircuit& generic =
+            model.getComponent<MuscleReflexCircuit>("reflex_circuit");
+
+        SpindleGolgiReflexCircuit* circuit = new SpindleGolgiReflexCircuit(
+            "static_circuit", generic.getMuscle(), generic.getSpindle(),
+            generic.getGolgi(), generic.get_threshold(), generic.get_timeDelay(),
+            generic.get_defaultControlSignal());
+        for (int i = 0; i < 3; ++i)
+        {
+            circuit->set_weights(i, generic.get_weights(i));
+        }
+        model.addComponent(circuit);
+
+        SimTK::State& si = initializeTugOfWarState(model);
+        const SpindleGolgiReflexCircuit& fixed =
+            model.getComponent<SpindleGolgiReflexCircuit>("static_circuit");
+
+        // the static circuit round trips through the property system
+        Object::registerType(SpindleGolgiReflexCircuit());
+        fixed.print("benchStaticReflexCircuit.xml");
+        std::unique_ptr<Object> copy(
+            Object::makeObjectFromFile("benchStaticReflexCircuit.xml"));
+        const SpindleGolgiReflexCircuit& reloaded =
+            dynamic_cast<const SpindleGolgiReflexCircuit&>(*copy);
+        std::cout << "reloaded " << reloaded.getConcreteClassName()
+                  << " with weights " << reloaded.get_weights(0) << ", "
+                  << reloaded.get_weights(1) << ", "
+                  << reloaded.get_weights(2) << "\n";
+
+        Manager manager(model);
+        manager.setIntegratorAccuracy(1.0e-6);
+        si.setTime(0.0);
+        manager.initialize(si);
+
+        double maxDifference = 0;
+        for (int k = 1; k <= 200; ++k)
+        {
+            const SimTK::State& s = manager.integrate(0.01*k);
+            model.realizeVelocity(s);
+            maxDifference = std::max(maxDifference, std::fabs(
+                generic.getMuscleSignal(s) - fixed.getMuscleSignal(s)));
+        }
+        std::cout << "max muscle_signal difference over 2 s\t"
+                  << maxDifference << "\n";
+        const SimTK::State& end = manager.getState();
+        OutputCounter signalCount = fixed.getSignalCounter(end);
+        OutputCounter muscleSignalCount = fixed.getMuscleSignalCounter(end);
+        std::cout << "static signal computed/read\t"
+                  << signalCount.numComputed << "/" << signalCount.numRead << "\n";
+        std::cout << "static muscle_signal computed/read\t"
+                  << muscleSignalCount.numComputed << "/"
+                  << muscleSignalCount.numRead << "\n";
+
+        SimTK::State s = manager.getState();
+        const int numEvaluations = 20000;
+        double t0 = s.getTime();
+        double checksum = 0;
+
+        double realizeNs = timeEvaluations(model, s, t0, numEvaluations,
+            [](const SimTK::State&) {});
+        double genericNs = timeEvaluations(model, s, t0, numEvaluations,
+            [&](const SimTK::State& state) { checksum += generic.getMuscleSignal(state); })
+            - realizeNs;
+        double staticNs = timeEvaluations(model, s, t0, numEvaluations,
+            [&](const SimTK::State& state) { checksum += fixed.getMuscleSignal(state); })
+            - realizeNs;
+
+        std::cout << "realizeVelocity ns\t" << realizeNs << "\n";
+        std::cout << "MuscleReflexCircuit ns\t" << genericNs << "\n";
+        std::cout << "SpindleGolgiReflexCircuit ns\t" << staticNs << "\n";
+        std::cout << "speedup\t" << genericNs/staticNs << "\n";
+        std::cout << "\n(checksum " << checksum << ")\n";
+    }
+
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
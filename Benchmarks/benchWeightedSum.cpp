@@ -0,0 +1,161 @@
+/* -------------------------------------------------------------------------- *
+ *                    OpenSim:  benchWeightedSum.cpp                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "WeightedSum.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Check the vectorized Interneuron weighted sum against its scalar
+ * reference for fan-ins from 1 to 1024 afferents, and time both with the
+ * values written before every sum as Interneuron does. Weights
+ * are spread over [0,1] and scaled to sum to 1, as Interneuron requires.
+ * The two sums may differ only by the rounding of their different addition
+ * order, bounded by n*eps times the sum of |w*v|; the benchmark fails if
+ * they differ by more. The kernel the library was built with is printed
+ * first; unless it is built with ENABLE_AVX2 both sums are the scalar loop.
+ */
+
+namespace {
+
+    double nextUniform(unsigned int& seed)
+    {
+        seed = 1664525u*seed + 1013904223u;
+        return (seed >> 8)/16777216.0;
+    }
+
+}
+
+int main() {
+
+    typedef std::chrono::steady_clock Clock;
+
+    std::cout << "kernel " << WeightedSum::getKernelName() << "\n";
+    std::cout << "afferents\tvector ns\tscalar ns\tspeedup\terror\tbound\n";
+
+    const int fanIns[] = {1, 3, 4, 5, 8, 16, 33, 64, 256, 1024};
+    unsigned int seed = 1;
+    bool failed = false;
+    for (int n : fanIns)
+    {
+        std::vector<double> weights(n);
+        double total = 0;
+        for (double& w : weights)
+        {
+            w = nextUniform(seed);
+            total += w;
+        }
+        for (double& w : weights)
+        {
+            w /= total;
+        }
+
+        WeightedSum sum;
+        sum.assign(weights.data(), n);
+        std::vector<double> values(sum.getPaddedSize(), 0.0);
+
+        // largest difference over many value sets, against the bound
+        double maxError = 0;
+        double maxBound = 0;
+        for (int trial = 0; trial < 1000; ++trial)
+        {
+            double magnitude = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                values[i] = 2*nextUniform(seed) - 0.5;
+                magnitude += std::fabs(weights[i]*values[i]);
+            }
+            double error = std::fabs(sum.evaluate(values.data()) -
+                                     sum.evaluateReference(values.data()));
+            double bound = n*std::numeric_limits<double>::epsilon()*magnitude;
+            if (error > bound)
+            {
+                failed = true;
+            }
+            maxError = std::max(maxError, error);
+            maxBound = std::max(maxBound, bound);
+        }
+
+        // the values are written before every sum, as Interneuron does
+        const int numEvaluations = std::max(1000, 4000000/n);
+        double checksum = 0;
+        Clock::time_point start = Clock::now();
+        for (int k = 0; k < numEvaluations; ++k)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                values[i] = k*1.0e-9 + i;
+            }
+            checksum += sum.evaluate(values.data());
+        }
+        double vectorNs = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count()/numEvaluations;
+
+        start = Clock::now();
+        for (int k = 0; k < numEvaluations; ++k)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                values[i] = k*1.0e-9 + i;
+            }
+            checksum -= sum.evaluateReference(values.data());
+        }
+        double scalarNs = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count()/numEvaluations;
+
+        std::cout << n << "\t" << vectorNs << "\t" << scalarNs << "\t"
+                  << scalarNs/vectorNs << "\t" << maxError << "\t" << maxBound
+                  << "\t(checksum " << checksum << ")\n";
+    }
+
+    // copies keep their buffers aligned
+    WeightedSum original;
+    std::vector<double> weights(7, 0.1);
+    original.assign(weights.data(), 7);
+    std::vector<WeightedSum> copies(5, original);
+    for (const WeightedSum& copy : copies)
+    {
+        if ((std::size_t)copy.getWeights() % (WeightedSum::Width*sizeof(double)) != 0)
+        {
+            std::cout << "A copied WeightedSum lost its alignment" << std::endl;
+            failed = true;
+        }
+    }
+
+    if (failed)
+    {
+        std::cout << "The vector kernel does not match the scalar reference" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
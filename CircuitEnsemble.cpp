@@ -0,0 +1,173 @@
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim:  CircuitEnsemble.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "CircuitEnsemble.h"
+#include <algorithm>
+#include <cmath>
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+CircuitEnsemble::CircuitEnsemble() :
+    _numVariants(0),
+    _stepSize(0),
+    _numSamples(0),
+    _numSlots(0)
+{
+}
+
+void CircuitEnsemble::assign(const std::vector<ReflexParameters>& variants,
+                             double stepSize)
+{
+    const int K = (int)variants.size();
+    _numVariants = K;
+    _stepSize = stepSize;
+    
+    _thresholds.assign(K, 0.0);
+    _lengthWeights.assign(K, 0.0);
+    _speedWeights.assign(K, 0.0);
+    _tendonWeights.assign(K, 0.0);
+    _defaultSignals.assign(K, 0.0);
+    _delaySteps.assign(K, 0);
+    _delayFractions.assign(K, 0.0);
+    _firstSamples.assign(K, 0);
+    
+    int maxDelaySteps = 0;
+    for (int k = 0; k < K; ++k)
+    {
+        const ReflexParameters& variant = variants[k];
+        const std::vector<double>& weights = variant.weights;
+        _thresholds[k] = variant.threshold;
+        _lengthWeights[k] = weights.size() > 0 ? weights[0] : 0.0;
+        _speedWeights[k] = weights.size() > 1 ? weights[1] : 0.0;
+        _tendonWeights[k] = weights.size() > 2 ? weights[2] : 0.0;
+        _defaultSignals[k] = variant.defaultControlSignal;
+        
+        // delays that are a whole number of steps up to rounding have no
+        // fraction, so they need no sample before the one they read
+        double steps = std::max(0.0, variant.timeDelay/stepSize);
+        int m = (int)std::floor(steps + 1e-9);
+        double f = steps - m > 1e-9 ? steps - m : 0.0;
+        _delaySteps[k] = m;
+        _delayFractions[k] = f;
+        _firstSamples[k] = f > 0 ? m + 1 : m;
+        maxDelaySteps = std::max(maxDelaySteps, m);
+    }
+    
+    _spindleLengths.assign(K, 0.0);
+    _spindleSpeeds.assign(K, 0.0);
+    _tendonLengths.assign(K, 0.0);
+    _signals.assign(K, 0.0);
+    _muscleSignals.assign(_defaultSignals.begin(), _defaultSignals.end());
+    
+    // the two samples that bracket the longest delay, and the newest
+    _numSlots = maxDelaySteps + 2;
+    reset();
+}
+
+void CircuitEnsemble::reset()
+{
+    // the slots a variant reads before its first sample hold its default
+    _numSamples = 0;
+    _samples.resize((size_t)_numSlots*_numVariants);
+    for (int slot = 0; slot < _numSlots; ++slot)
+    {
+        std::copy(_defaultSignals.begin(), _defaultSignals.end(),
+                  _samples.begin() + (size_t)slot*_numVariants);
+    }
+}
+
+//=============================================================================
+// SIGNAL
+//=============================================================================
+
+void CircuitEnsemble::step()
+{
+    const int K = _numVariants;
+    const int n = _numSamples;
+    const int slot = n % _numSlots;
+    const int previous = (slot > 0 ? slot : _numSlots) - 1;
+    
+    const double* length = _spindleLengths.data();
+    const double* speed = _spindleSpeeds.data();
+    const double* tendon = _tendonLengths.data();
+    const double* lengthWeight = _lengthWeights.data();
+    const double* speedWeight = _speedWeights.data();
+    const double* tendonWeight = _tendonWeights.data();
+    const double* threshold = _thresholds.data();
+    double* signal = _signals.data();
+    
+    // weighted sums and the step of the interneurons
+    for (int k = 0; k < K; ++k)
+    {
+        double sum = lengthWeight[k]*length[k] + speedWeight[k]*speed[k] +
+                     tendonWeight[k]*tendon[k];
+        signal[k] = sum > threshold[k] ? sum : 0.0;
+    }
+    
+    // a sample is written to the slot it is read from, m steps later, so
+    // that every variant reads the same two slots
+    double* samples = _samples.data();
+    const int* delaySteps = _delaySteps.data();
+    for (int k = 0; k < K; ++k)
+    {
+        int target = slot + delaySteps[k];
+        target -= target >= _numSlots ? _numSlots : 0;
+        samples[(size_t)target*K + k] = signal[k];
+    }
+    
+    // the delayed time of a variant is between the samples m and m + 1
+    // steps back, those of this slot and the previous one
+    const double* current = samples + (size_t)slot*K;
+    const double* before = samples + (size_t)previous*K;
+    const double* fraction = _delayFractions.data();
+    double* muscleSignal = _muscleSignals.data();
+    for (int k = 0; k < K; ++k)
+    {
+        muscleSignal[k] = (1 - fraction[k])*current[k] + fraction[k]*before[k];
+    }
+    
+    // until then the default signal; a separate pass, since the select
+    // does not vectorize next to the interpolation
+    const int* firstSample = _firstSamples.data();
+    const double* defaultSignal = _defaultSignals.data();
+    for (int k = 0; k < K; ++k)
+    {
+        muscleSignal[k] = n >= firstSample[k] ? muscleSignal[k] : defaultSignal[k];
+    }
+    
+    ++_numSamples;
+}
@@ -0,0 +1,141 @@
+#ifndef OPENSIM_CircuitEnsemble_H_
+#define OPENSIM_CircuitEnsemble_H_
+/* -------------------------------------------------------------------------- *
+ *                         OpenSim: CircuitEnsemble.h                         *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimMuscleReflexCircuitDLL.h"
+#include "ReflexSweep.h"
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * CircuitEnsemble evaluates the reflex circuit of the tug-of-war model for
+ * K variants at once: the weighted sum of spindle length, spindle speed and
+ * tendon length, the step of the Interneuron and the time delay of the
+ * Delay, each variant with its own ReflexParameters.
+ *
+ * Everything is stored as a structure of arrays, one array of K entries per
+ * parameter and per signal, so that each stage of the circuit is a loop over
+ * the variants with no branches that the compiler vectorizes. The variants
+ * are sampled together at a fixed step h, so the delay line of all of them
+ * is one ring buffer of samples, slot after slot, K entries per slot. The
+ * delay of a variant is a whole number m of steps plus a fraction f, fixed
+ * when the variants are assigned, and its delayed signal is the linear
+ * interpolation between the samples m and m + 1 steps back, as with the
+ * Linear kernel of DelayLine. Each sample is written m slots ahead, to the
+ * slot it is read from, so the variants of different delays all read the
+ * same two contiguous slots and only the writes are scattered. Until the
+ * first sample is a delay old the delayed signal is the default control
+ * signal.
+ *
+ * A step reads the afferents written by the caller into the spindle and
+ * tendon arrays, pushes the interneuron signals of the variants into the
+ * delay line and computes their muscle signals at the time of the sample.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMMUSCLEREFLEXCIRCUIT_API CircuitEnsemble {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no variants. */
+    CircuitEnsemble();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Replace the variants, sampled every stepSize, and clear the samples.
+        The weights of a variant are those of the spindle length, spindle
+        speed and tendon length; missing weights are 0. */
+    void assign(const std::vector<ReflexParameters>& variants, double stepSize);
+    /** Drop the samples, so that the next step is at the start time. */
+    void reset();
+
+//--------------------------------------------------------------------------
+// CIRCUIT ENSEMBLE ACCESSORS
+//--------------------------------------------------------------------------
+    int getNumVariants() const { return _numVariants; }
+    double getStepSize() const { return _stepSize; }
+    /** Number of samples taken since the last reset. */
+    int getNumSamples() const { return _numSamples; }
+
+    /** The afferents of the next sample, one entry per variant. */
+    double* updSpindleLengths() { return _spindleLengths.data(); }
+    double* updSpindleSpeeds() { return _spindleSpeeds.data(); }
+    double* updTendonLengths() { return _tendonLengths.data(); }
+
+    /** The interneuron signals of the last sample. */
+    const double* getSignals() const { return _signals.data(); }
+    /** The delayed signals of the variants at the time of the last sample. */
+    const double* getMuscleSignals() const { return _muscleSignals.data(); }
+
+    /** Take one sample of every variant. */
+    void step();
+
+private:
+    int _numVariants;
+    double _stepSize;
+    int _numSamples;
+
+    // parameters of the variants
+    std::vector<double> _thresholds;
+    std::vector<double> _lengthWeights;
+    std::vector<double> _speedWeights;
+    std::vector<double> _tendonWeights;
+    std::vector<double> _defaultSignals;
+    // the delay of a variant is _delaySteps + _delayFractions steps, and its
+    // first delayed sample is sample _firstSamples
+    std::vector<int> _delaySteps;
+    std::vector<double> _delayFractions;
+    std::vector<int> _firstSamples;
+
+    // afferents and signals of the variants
+    std::vector<double> _spindleLengths;
+    std::vector<double> _spindleSpeeds;
+    std::vector<double> _tendonLengths;
+    std::vector<double> _signals;
+    std::vector<double> _muscleSignals;
+
+    // ring buffer of _numSlots samples of every variant, [slot*K + k]
+    std::vector<double> _samples;
+    int _numSlots;
+
+};  // END of class CircuitEnsemble
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_CircuitEnsemble_H_
@@ -29,6 +29,7 @@
 #include "Delay.h"
 #include <OpenSim/OpenSim.h>
 #include "OpenSim/Simulation/Model/Muscle.h"
+#include <algorithm>
 
 
 
@@ -44,7 +45,10 @@ using namespace SimTK;
 //=============================================================================
 //_____________________________________________________________________________
 /* Default constructor. */
-Delay::Delay()
+Delay::Delay() :
+    _interpolation(DelayLine::Linear),
+    _usePade(false),
+    _padeFeedthrough(0)
 {
     constructProperties();
 }
@@ -53,7 +57,10 @@ Delay::Delay()
 Delay::Delay(const std::string& name,
              const Muscle& muscle,
              double delay,
-             double defaultControlSignal)
+             double defaultControlSignal) :
+    _interpolation(DelayLine::Linear),
+    _usePade(false),
+    _padeFeedthrough(0)
 {
     OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
        
@@ -87,14 +94,175 @@ Delay::Delay(const std::string& name,
  */
 void Delay::constructProperties()
 {
+    constructProperty_delay(0.1);
+    constructProperty_defaultControlSignal(1.0);
+    constructProperty_minimum_step_size(1.0e-4);
+    constructProperty_history_tolerance(0.0);
+    constructProperty_delay_mode("history");
+    constructProperty_pade_order(4);
+    constructProperty_interpolation("linear");
+    constructProperty_localize_onset(true);
+}
+
+void Delay::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+    
+    OPENSIM_THROW_IF_FRMOBJ(get_delay() < 0, InvalidPropertyValue, getName(), "The delay cannot be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_minimum_step_size() <= 0, InvalidPropertyValue, getName(), "The minimum step size must be positive");
+    OPENSIM_THROW_IF_FRMOBJ(get_history_tolerance() < 0, InvalidPropertyValue, getName(), "The history tolerance cannot be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_delay_mode() != "history" && get_delay_mode() != "pade", InvalidPropertyValue, getName(), "The delay mode must be 'history' or 'pade'");
+    
+    const std::string& interpolation = get_interpolation();
+    if (interpolation == "zero_order_hold")
+    {
+        _interpolation = DelayLine::ZeroOrderHold;
+    }
+    else if (interpolation == "linear")
+    {
+        _interpolation = DelayLine::Linear;
+    }
+    else if (interpolation == "cubic_hermite")
+    {
+        _interpolation = DelayLine::CubicHermite;
+    }
+    else
+    {
+        OPENSIM_THROW_FRMOBJ(InvalidPropertyValue, getName(), "The interpolation must be 'zero_order_hold', 'linear' or 'cubic_hermite'");
+    }
+    OPENSIM_THROW_IF_FRMOBJ(get_history_tolerance() > 0 && _interpolation != DelayLine::Linear, InvalidPropertyValue, getName(), "A history tolerance is only bounded with 'linear' interpolation");
+    
+    _usePade = get_delay_mode() == "pade";
+    _padeDenominator.clear();
+    _padeOutput.clear();
+    _padeStateNames.clear();
+    if (!_usePade)
+    {
+        return;
+    }
+    
+    const int order = get_pade_order();
+    OPENSIM_THROW_IF_FRMOBJ(order < 1 || order > 10, InvalidPropertyValue, getName(), "The Pade order must be between 1 and 10");
+    OPENSIM_THROW_IF_FRMOBJ(get_delay() < SimTK::Eps, InvalidPropertyValue, getName(), "The Pade approximation needs a delay of at least SimTK::Eps");
+    
+    // The [N/N] Pade approximation of exp(-s*tau) is P(-tau*s)/P(tau*s) with
+    // P(x) = sum_k c_k x^k, c_k = (2N-k)! N! / ((2N)! k! (N-k)!) and c_0 = 1.
+    std::vector<double> c(order+1);
+    c[0] = 1;
+    for (int k = 0; k < order; ++k)
+    {
+        c[k+1] = c[k]*(order-k)/((2.0*order-k)*(k+1));
+    }
+    
+    // Controllable canonical form in time scaled by tau, with the states
+    // scaled so that at rest the first state equals the input and the others
+    // are zero. The feedthrough is (-1)^N.
+    _padeFeedthrough = order % 2 == 0 ? 1.0 : -1.0;
+    for (int k = 0; k < order; ++k)
+    {
+        double sign = k % 2 == 0 ? 1.0 : -1.0;
+        _padeDenominator.push_back(c[k]/c[order]);
+        _padeOutput.push_back((sign - _padeFeedthrough)*c[k]);
+        _padeStateNames.push_back("pade_state_" + std::to_string(k));
+    }
+}
+
+//=============================================================================
+// ONSET EVENT
+//=============================================================================
+
+namespace {
+    
+    // Stops the integrator at the onset of a history mode delay, where the
+    // signal jumps from the default control signal to the delayed history.
+    // Nothing in the State changes, the integrator just restarts there.
+    class OnsetEvent : public SimTK::ScheduledEventHandler {
+    public:
+        OnsetEvent(const Delay& delay) :
+            _delay(delay)
+        {
+        }
+        
+        SimTK::Real getNextEventTime(const SimTK::State& s,
+                                     bool includeCurrentTime) const override
+        {
+            double onset = _delay.getOnsetTime(s);
+            if (onset > s.getTime() || (includeCurrentTime && onset == s.getTime()))
+            {
+                return onset;
+            }
+            return SimTK::Infinity;
+        }
+        
+        void handleEvent(SimTK::State& s, SimTK::Real accuracy,
+                         bool& shouldTerminate) const override
+        {
+            shouldTerminate = false;
+        }
+        
+    private:
+        const Delay& _delay;
+    };
     
 }
 
-void Delay::addToSystem(SimTK::MultibodySystem& system) const
+void Delay::extendAddToSystem(SimTK::MultibodySystem& system) const
 {
-    Super::addToSystem(system);
-    Delay* mutableThis = const_cast<Delay*>(this);
+    Super::extendAddToSystem(system);
     
+    // the output is computed once per realization and counted
+    _signalCV = addCacheVariable("signal", 0.0, SimTK::Stage::Velocity);
+    _signalCountCV = addCacheVariable("signal_count", OutputCounter(), SimTK::Stage::Topology);
+    
+    for (const std::string& name : _padeStateNames)
+    {
+        addStateVariable(name);
+    }
+    
+    // the Pade states have no jump to locate
+    if (!_usePade && get_localize_onset())
+    {
+        system.addEventHandler(new OnsetEvent(*this));
+    }
+}
+
+void Delay::extendInitStateFromProperties(SimTK::State& s) const
+{
+    Super::extendInitStateFromProperties(s);
+    
+    // rest state for an input that has been at the default signal forever
+    for (int k = 0; k < (int)_padeStateNames.size(); ++k)
+    {
+        setStateVariableValue(s, _padeStateNames[k],
+                              k == 0 ? get_defaultControlSignal() : 0.0);
+    }
+}
+
+void Delay::computeStateVariableDerivatives(const SimTK::State& s) const
+{
+    Super::computeStateVariableDerivatives(s);
+    
+    if (!_usePade)
+    {
+        return;
+    }
+    
+    const int order = (int)_padeStateNames.size();
+    const double rate = 1.0/get_delay();
+    double signal = getInputSignal(s);
+    
+    // x_k' = x_{k+1}/tau, x_{N-1}' = (a_0*u - sum_k a_k*x_k)/tau
+    double last = _padeDenominator[0]*signal;
+    for (int k = 0; k < order; ++k)
+    {
+        double x = getStateVariableValue(s, _padeStateNames[k]);
+        last -= _padeDenominator[k]*x;
+        if (k > 0)
+        {
+            setStateVariableDerivativeValue(s, _padeStateNames[k-1], rate*x);
+        }
+    }
+    setStateVariableDerivativeValue(s, _padeStateNames[order-1], rate*last);
 }
 
 
@@ -105,6 +273,47 @@ void Delay::extendConnectToModel(Model &model)
     
 }
 
+void Delay::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    // an idle delay, e.g. of a circuit that uses a DelayBank instead, has no
+    // connected input
+    const Input<double>& input = getInput<double>("signal");
+    _signal.clear();
+    if (input.isConnected())
+    {
+        _signal.bind(input.getChannel());
+    }
+    
+    if (_usePade)
+    {
+        return;
+    }
+    
+    DelayHistory history;
+    history.reset(get_delay(), get_minimum_step_size(),
+                  get_history_tolerance(), _interpolation);
+    
+    // the update value is rebuilt whenever the input changes and is swapped
+    // into the State by the integrator only on accepted steps
+    const SimTK::Subsystem& subsys = getSystem().getDefaultSubsystem();
+    _historyIndex = subsys.allocateAutoUpdateDiscreteVariable(s,
+        SimTK::Stage::Acceleration, new SimTK::Value<DelayHistory>(history),
+        SimTK::Stage::Velocity);
+}
+
+void Delay::extendRealizeAcceleration(const SimTK::State& s) const
+{
+    Super::extendRealizeAcceleration(s);
+    
+    // an idle delay, e.g. of a circuit that uses a DelayBank instead
+    if (!_usePade && _signal.isBound())
+    {
+        getUpdatedHistory(s);
+    }
+}
+
 //=============================================================================
 // GET AND SET
 //=============================================================================
@@ -135,6 +344,149 @@ double Delay::getDefaultSignal() const
     return get_defaultControlSignal();
 }
 
+void Delay::setMinimumStepSize(double minimumStepSize)
+{
+    set_minimum_step_size(minimumStepSize);
+}
+double Delay::getMinimumStepSize() const
+{
+    return get_minimum_step_size();
+}
+
+void Delay::setHistoryTolerance(double historyTolerance)
+{
+    set_history_tolerance(historyTolerance);
+}
+double Delay::getHistoryTolerance() const
+{
+    return get_history_tolerance();
+}
+
+void Delay::setDelayMode(const std::string& delayMode)
+{
+    set_delay_mode(delayMode);
+}
+const std::string& Delay::getDelayMode() const
+{
+    return get_delay_mode();
+}
+
+void Delay::setPadeOrder(int padeOrder)
+{
+    set_pade_order(padeOrder);
+}
+int Delay::getPadeOrder() const
+{
+    return get_pade_order();
+}
+
+void Delay::setInterpolation(const std::string& interpolation)
+{
+    set_interpolation(interpolation);
+}
+const std::string& Delay::getInterpolation() const
+{
+    return get_interpolation();
+}
+
+void Delay::setLocalizeOnset(bool localizeOnset)
+{
+    set_localize_onset(localizeOnset);
+}
+bool Delay::getLocalizeOnset() const
+{
+    return get_localize_onset();
+}
+
+//-----------------------------------------------------------------------------
+// History
+//-----------------------------------------------------------------------------
+
+double Delay::getInputSignal(const SimTK::State& s) const
+{
+    // an idle delay holds the default signal
+    return _signal.isBound() ? _signal.getValue(s) : get_defaultControlSignal();
+}
+
+double Delay::getOnsetTime(const SimTK::State& s) const
+{
+    // an idle delay holds the default signal and never switches
+    if (_usePade || !_signal.isBound())
+    {
+        return SimTK::Infinity;
+    }
+    
+    // the first sample is taken at the time of the first committed step
+    const DelayHistory& history = getHistory(s);
+    double startTime = history.isEmpty() ? s.getTime() : history.getStartTime();
+    return startTime + get_delay();
+}
+
+const DelayHistory& Delay::getHistory(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    return SimTK::Value<DelayHistory>::downcast(
+        s.getDiscreteVariable(subsys, _historyIndex)).get();
+}
+
+const DelayHistory& Delay::getUpdatedHistory(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    
+    DelayHistory& update = SimTK::Value<DelayHistory>::updDowncast(
+        s.updDiscreteVarUpdateValue(subsys, _historyIndex)).upd();
+    
+    if (!s.isDiscreteVarUpdateValueRealized(subsys, _historyIndex))
+    {
+        double signal = getInputSignal(s);
+        update.prepareUpdate(getHistory(s), s.getTime(), signal);
+        s.markDiscreteVarUpdateValueRealized(subsys, _historyIndex);
+    }
+    
+    return update;
+}
+
+long long Delay::getNumSamplesCommitted(const SimTK::State& s) const
+{
+    if (_usePade)
+    {
+        return 0;
+    }
+    
+    // the pending sample of the committed history was taken on the last
+    // accepted step
+    const DelayHistory& history = getHistory(s);
+    return history.getNumCommitted() + (history.hasPending() ? 1 : 0);
+}
+
+long long Delay::getNumSamplesEvaluated(const SimTK::State& s) const
+{
+    if (_usePade)
+    {
+        return 0;
+    }
+    
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    const DelayHistory& update = SimTK::Value<DelayHistory>::downcast(
+        s.getDiscreteVarUpdateValue(subsys, _historyIndex)).get();
+    
+    return std::max(update.getNumEvaluated(),
+                    getHistory(s).getNumEvaluated());
+}
+
+double Delay::getCompactionRatio(const SimTK::State& s) const
+{
+    if (_usePade)
+    {
+        return 1.0;
+    }
+    
+    return getHistory(s).getLine().getCompactionRatio();
+}
+
 //=============================================================================
 // SIGNALS
 //=============================================================================
@@ -145,27 +497,55 @@ double Delay::getDefaultSignal() const
  * @param s         current state of the system
  */
 
-double Delay::getSignal(const SimTK::State& s) const
+double Delay::computeSignal(const SimTK::State& s) const
 {
-    double signal = getInputValue<double>(s, "signal");
+    if (_usePade)
+    {
+        double controlSignal = _padeFeedthrough*getInputSignal(s);
+        for (int k = 0; k < (int)_padeStateNames.size(); ++k)
+        {
+            controlSignal += _padeOutput[k]*getStateVariableValue(s, _padeStateNames[k]);
+        }
+        return controlSignal;
+    }
+    
     double time = s.getTime();
     double controlSignal = 0;
     double defaultSignal = get_defaultControlSignal();
     
-    const Muscle& musc = getMuscle();
-    
-    muscleHistory.addPoint(time, signal);
+    const DelayHistory& history = getUpdatedHistory(s);
     
-    if((time - get_delay()) < muscleHistory.getXValues()[0])
+    if((time - get_delay()) < history.getStartTime())
     {
         controlSignal = defaultSignal;
     }
     else
     {
-        controlSignal = muscleHistory.calcValue(SimTK::Vector(1,time-get_delay()));
+        controlSignal = history.getValue(time - get_delay());
     }
     
     return controlSignal;
 }
 
+double Delay::getSignal(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _signalCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _signalCV))
+    {
+        return getCacheVariableValue(s, _signalCV);
+    }
+    
+    ++counter.numComputed;
+    double controlSignal = computeSignal(s);
+    setCacheVariableValue(s, _signalCV, controlSignal);
+    return controlSignal;
+}
+
+OutputCounter Delay::getSignalCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _signalCountCV);
+}
+
 // time < tau return default control signal
@@ -28,11 +28,13 @@
 // INCLUDE
 //============================================================================
 #include "osimDelayDLL.h"
+#include "OutputCounter.h"
 #include "OpenSim/Simulation/Control/Controller.h"
 #include "OpenSim/Simulation/Model/Muscle.h"
-#include "OpenSim/Common/PiecewiseLinearFunction.h"
 #include "OpenSim/Simulation/Model/Model.h"
 #include "OpenSim/Simulation/Model/ModelComponent.h"
+#include "DelayLine.h"
+#include "SignalSource.h"
 
 
 
@@ -56,7 +58,7 @@ public:
 // INPUT
 //=============================================================================
     // Input the signal from the proprioceptors
-    OpenSim_DECLARE_INPUT(signal, double, SimTK::Stage::Position,
+    OpenSim_DECLARE_INPUT(signal, double, SimTK::Stage::Velocity,
         "The signal from the proprieceptors");
     
 //=============================================================================
@@ -66,6 +68,18 @@ public:
     
     OpenSim_DECLARE_PROPERTY(defaultControlSignal, double, "the default control signal to send while the signal has not yet gotten their delaied signal");
     
+    OpenSim_DECLARE_PROPERTY(minimum_step_size, double, "The smallest time step (seconds) the integrator is expected to take, used to size the signal history");
+    
+    OpenSim_DECLARE_PROPERTY(history_tolerance, double, "The largest interpolation error allowed when compacting the signal history; samples that linear interpolation can rebuild within it are dropped. 0 keeps every sample; must be 0 unless the interpolation is linear");
+    
+    OpenSim_DECLARE_PROPERTY(delay_mode, std::string, "How the delay is modelled: 'history' interpolates stored samples of the signal, 'pade' uses a rational Pade approximation of exp(-s*delay) with continuous states and keeps no history");
+    
+    OpenSim_DECLARE_PROPERTY(pade_order, int, "The order of the Pade approximation used when delay_mode is 'pade', between 1 and 10");
+    
+    OpenSim_DECLARE_PROPERTY(interpolation, std::string, "How the signal history is interpolated between samples: 'zero_order_hold', 'linear' or 'cubic_hermite'");
+    
+    OpenSim_DECLARE_PROPERTY(localize_onset, bool, "Whether the history mode schedules an event at the onset, the start of the history plus the delay, where the signal jumps from the default control signal to the delayed signal, so that the integrator stops there instead of rejecting steps across it");
+    
 //==============================================================================
 // SOCKETS
 //==============================================================================
@@ -75,7 +89,7 @@ public:
 // OUTPUTS
 //=============================================================================
     // we get our propriceptive afferents
-    OpenSim_DECLARE_OUTPUT(controlSignal, double, getSignal, SimTK::Stage::Position);
+    OpenSim_DECLARE_OUTPUT(controlSignal, double, getSignal, SimTK::Stage::Velocity);
     //
 //=============================================================================
 // METHODS
@@ -107,6 +121,24 @@ public:
     
     void setDefaultSignal(double defaultControlSignal);
     double getDefaultSignal() const;
+    
+    void setMinimumStepSize(double minimumStepSize);
+    double getMinimumStepSize() const;
+    
+    void setHistoryTolerance(double historyTolerance);
+    double getHistoryTolerance() const;
+    
+    void setDelayMode(const std::string& delayMode);
+    const std::string& getDelayMode() const;
+    
+    void setPadeOrder(int padeOrder);
+    int getPadeOrder() const;
+    
+    void setInterpolation(const std::string& interpolation);
+    const std::string& getInterpolation() const;
+    
+    void setLocalizeOnset(bool localizeOnset);
+    bool getLocalizeOnset() const;
           
 
 //--------------------------------------------------------------------------
@@ -116,18 +148,70 @@ public:
     Get quanitites of interest common to all spindles*/
     void setSignal(SimTK::State& s, double controlSignal) const;
     double getSignal(const SimTK::State& s) const;
+    // How often controlSignal was computed and read on the lineage of s
+    OutputCounter getSignalCounter(const SimTK::State& s) const;
+    
+    // The number of samples recorded on accepted steps, and the number taken
+    // at every evaluation including rejected trial steps
+    long long getNumSamplesCommitted(const SimTK::State& s) const;
+    long long getNumSamplesEvaluated(const SimTK::State& s) const;
+    
+    // The number of samples committed per sample kept in the history
+    double getCompactionRatio(const SimTK::State& s) const;
+    
+    // The time at which the signal switches from the default control signal
+    // to the delayed history, in history mode
+    double getOnsetTime(const SimTK::State& s) const;
     
         
 
 private:
+    // Evaluate the outputs, called once per realization
+    double computeSignal(const SimTK::State& s) const;
     // Connect properties to local pointers.  */
     void constructProperties();
     // ModelComponent interface to connect this component to its model
     void extendConnectToModel(Model& aModel) override;
+    // Check the delay properties and set up the Pade coefficients
+    void extendFinalizeFromProperties() override;
     // ModelComponent interface to add computational elemetns to the SimTK system
-    void addToSystem(SimTK::MultibodySystem& system) const;
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Start the Pade states at rest with the default control signal
+    void extendInitStateFromProperties(SimTK::State& s) const override;
+    // Pade state derivatives, driven by the input signal
+    void computeStateVariableDerivatives(const SimTK::State& s) const override;
+    // Allocate the signal history in the State
+    void extendRealizeTopology(SimTK::State& s) const override;
+    // Sample the signal on every step even when nothing reads the output
+    void extendRealizeAcceleration(const SimTK::State& s) const override;
+    
+    // The value of the input, or the default signal when it is idle
+    double getInputSignal(const SimTK::State& s) const;
+    
+    // The committed history of the State, and the history that will replace
+    // it if the current step is accepted
+    const DelayHistory& getHistory(const SimTK::State& s) const;
+    const DelayHistory& getUpdatedHistory(const SimTK::State& s) const;
+    
+    // Auto-update discrete variable holding the DelayHistory
+    mutable SimTK::DiscreteVariableIndex _historyIndex;
+    
+    // The input signal and cache entries, resolved once rather than looked
+    // up by name on every evaluation
+    mutable SignalSource _signal;
+    mutable CacheVariable<double> _signalCV;
+    mutable CacheVariable<OutputCounter> _signalCountCV;
+    
+    // Kernel of the history, parsed from the interpolation property
+    DelayLine::Interpolation _interpolation;
     
-    mutable PiecewiseLinearFunction muscleHistory;
+    // Pade mode: monic denominator coefficients of the approximation, the
+    // output weights of the states, the direct feedthrough and state names
+    bool _usePade;
+    std::vector<double> _padeDenominator;
+    std::vector<double> _padeOutput;
+    double _padeFeedthrough;
+    std::vector<std::string> _padeStateNames;
 
     
 protected:
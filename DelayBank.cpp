@@ -0,0 +1,315 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  DelayBank.cpp                               *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "DelayBank.h"
+#include <OpenSim/OpenSim.h>
+#include <algorithm>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DelayBank::DelayBank()
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+DelayBank::DelayBank(const std::string& name)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    constructProperties();
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+void DelayBank::constructProperties()
+{
+    constructProperty_minimum_step_size(1.0e-4);
+}
+
+void DelayBank::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+    
+    OPENSIM_THROW_IF_FRMOBJ(get_minimum_step_size() <= 0, InvalidPropertyValue, getName(), "The minimum step size must be positive");
+    
+    // the circuits register their channels again when they are connected
+    _sourcePaths.clear();
+    _sources.clear();
+    _channelNames.clear();
+    _channelIndices.clear();
+    _channelSources.clear();
+    _delays.clear();
+    _defaults.clear();
+    updOutput("controlSignal").clearChannels();
+}
+
+void DelayBank::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    _signalsCV = addCacheVariable("signals",
+        SimTK::Vector(getNumChannels(), 0.0), SimTK::Stage::Velocity);
+    // scratch space in the State, so that States of one model can be
+    // realized on several threads
+    _samplesCV = addCacheVariable("samples",
+        SimTK::Vector(getNumSources(), 0.0), SimTK::Stage::Topology);
+    _lookupTimesCV = addCacheVariable("lookup_times",
+        SimTK::Vector(getNumChannels(), 0.0), SimTK::Stage::Topology);
+}
+
+void DelayBank::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    const int numChannels = getNumChannels();
+    double maxDelay = 0;
+    for (double delay : _delays)
+    {
+        maxDelay = std::max(maxDelay, delay);
+    }
+    
+    DelayBankHistory history;
+    history.reset(getNumSources(), numChannels, maxDelay,
+                  get_minimum_step_size());
+    _sourceSignals.resize(getNumSources());
+    for (int k = 0; k < getNumSources(); ++k)
+    {
+        _sourceSignals[k].bind(*_sources[k]);
+    }
+    
+    // the update value is rebuilt whenever the inputs change and is swapped
+    // into the State by the integrator only on accepted steps
+    const SimTK::Subsystem& subsys = getSystem().getDefaultSubsystem();
+    _historyIndex = subsys.allocateAutoUpdateDiscreteVariable(s,
+        SimTK::Stage::Acceleration, new SimTK::Value<DelayBankHistory>(history),
+        SimTK::Stage::Velocity);
+}
+
+void DelayBank::extendRealizeAcceleration(const SimTK::State& s) const
+{
+    Super::extendRealizeAcceleration(s);
+    
+    if (getNumChannels() > 0)
+    {
+        getUpdatedHistory(s);
+    }
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+void DelayBank::setMinimumStepSize(double minimumStepSize)
+{
+    set_minimum_step_size(minimumStepSize);
+}
+double DelayBank::getMinimumStepSize() const
+{
+    return get_minimum_step_size();
+}
+
+//-----------------------------------------------------------------------------
+// Channels
+//-----------------------------------------------------------------------------
+
+int DelayBank::addChannel(const std::string& name,
+                          const AbstractOutput& source,
+                          double delay,
+                          double defaultSignal)
+{
+    // a single value output has exactly one, unnamed, channel
+    const Output<double>& output = Output<double>::downcast(source);
+    OPENSIM_THROW_IF_FRMOBJ(output.getChannels().size() != 1, Exception, "Channel '" + name + "' must name one channel of the list output " + source.getPathName());
+    return addChannel(name, *output.getChannels().begin()->second, delay,
+                      defaultSignal);
+}
+
+int DelayBank::addChannel(const std::string& name,
+                          const AbstractChannel& source,
+                          double delay,
+                          double defaultSignal)
+{
+    OPENSIM_THROW_IF_FRMOBJ(delay < 0, InvalidPropertyValue, getName(), "The delay of channel '" + name + "' cannot be negative");
+    
+    // channels delaying the same output share its stored signal
+    const std::string path = source.getPathName();
+    auto it = std::find(_sourcePaths.begin(), _sourcePaths.end(), path);
+    int sourceIndex = (int)(it - _sourcePaths.begin());
+    if (it == _sourcePaths.end())
+    {
+        _sourcePaths.push_back(path);
+        _sources.push_back(
+            SimTK::ReferencePtr<const Output<double>::Channel>(
+                &dynamic_cast<const Output<double>::Channel&>(source)));
+    }
+    
+    int index = getChannelIndex(name);
+    if (index < 0)
+    {
+        index = getNumChannels();
+        _channelNames.push_back(name);
+        _channelIndices[name] = index;
+        _channelSources.push_back(0);
+        _delays.push_back(0);
+        _defaults.push_back(0);
+        updOutput("controlSignal").addChannel(name);
+    }
+    
+    _channelSources[index] = sourceIndex;
+    _delays[index] = delay;
+    _defaults[index] = defaultSignal;
+    
+    return index;
+}
+
+int DelayBank::getNumChannels() const
+{
+    return (int)_channelNames.size();
+}
+
+int DelayBank::getChannelIndex(const std::string& name) const
+{
+    auto it = _channelIndices.find(name);
+    return it == _channelIndices.end() ? -1 : it->second;
+}
+
+int DelayBank::getNumSources() const
+{
+    return (int)_sources.size();
+}
+
+int DelayBank::getChannelSource(int index) const
+{
+    return _channelSources[index];
+}
+
+//-----------------------------------------------------------------------------
+// History
+//-----------------------------------------------------------------------------
+
+const DelayBankHistory& DelayBank::getHistory(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    return SimTK::Value<DelayBankHistory>::downcast(
+        s.getDiscreteVariable(subsys, _historyIndex)).get();
+}
+
+const DelayBankHistory& DelayBank::getUpdatedHistory(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    
+    DelayBankHistory& update = SimTK::Value<DelayBankHistory>::updDowncast(
+        s.updDiscreteVarUpdateValue(subsys, _historyIndex)).upd();
+    
+    if (!s.isDiscreteVarUpdateValueRealized(subsys, _historyIndex))
+    {
+        double* samples = updCacheVariableValue(s, _samplesCV).updContiguousScalarData();
+        for (int k = 0; k < getNumSources(); ++k)
+        {
+            samples[k] = _sourceSignals[k].getValue(s);
+        }
+        update.prepareUpdate(getHistory(s), s.getTime(), samples);
+        s.markDiscreteVarUpdateValueRealized(subsys, _historyIndex);
+    }
+    
+    return update;
+}
+
+//=============================================================================
+// SIGNALS
+//=============================================================================
+//_____________________________________________________________________________
+/**
+ * Compute the delayed signals of all channels in one pass
+ *
+ * @param s         current state of the system
+ */
+
+const SimTK::Vector& DelayBank::getSignals(const SimTK::State& s) const
+{
+    if (!isCacheVariableValid(s, _signalsCV))
+    {
+        SimTK::Vector& signals = updCacheVariableValue(s, _signalsCV);
+        const int numChannels = getNumChannels();
+        if (numChannels > 0)
+        {
+            const DelayBankHistory& history = getUpdatedHistory(s);
+            
+            double* lookupTimes = updCacheVariableValue(s, _lookupTimesCV).updContiguousScalarData();
+            double time = s.getTime();
+            for (int c = 0; c < numChannels; ++c)
+            {
+                lookupTimes[c] = time - _delays[c];
+            }
+            history.getValues(_channelSources.data(), lookupTimes,
+                              &signals[0]);
+            
+            // time < tau return default control signal
+            double startTime = history.getStartTime();
+            for (int c = 0; c < numChannels; ++c)
+            {
+                if (lookupTimes[c] < startTime)
+                {
+                    signals[c] = _defaults[c];
+                }
+            }
+        }
+        markCacheVariableValid(s, _signalsCV);
+    }
+    
+    return getCacheVariableValue(s, _signalsCV);
+}
+
+double DelayBank::getSignal(const SimTK::State& s, const std::string& name) const
+{
+    int index = getChannelIndex(name);
+    OPENSIM_THROW_IF_FRMOBJ(index < 0, Exception, "No delay bank channel '" + name + "'");
+    return getSignals(s)[index];
+}
+
+double DelayBank::getChannelSignal(const SimTK::State& s, int index) const
+{
+    return getSignals(s)[index];
+}
@@ -0,0 +1,188 @@
+#ifndef OPENSIM_DelayBank_H_
+#define OPENSIM_DelayBank_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: DelayBank.h                                  *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimDelayDLL.h"
+#include "OpenSim/Simulation/Model/Model.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+#include "DelayBankLine.h"
+#include "SignalSource.h"
+#include <map>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * DelayBank delays many signals of a model in one component. Each channel
+ * is registered with addChannel(), normally by a MuscleReflexCircuit while
+ * the model is connected, and has its own source output, delay and default
+ * signal.
+ *
+ * The bank is a registry of sources keyed by the path of the connected
+ * output. Channels that delay the same output, e.g. a short spinal loop and
+ * a long transcortical loop on one spindle, are taps on a single stored
+ * signal: each source is sampled and stored once, so memory and sampling
+ * cost grow with the number of distinct sources rather than with the number
+ * of channels.
+ *
+ * The samples of every source are kept in a single DelayBankHistory in the
+ * State, one contiguous row per sample time, and committed on accepted steps
+ * like the history of a Delay. All taps are interpolated together once per
+ * realization and cached, so reading the delayed signal
+ * of one channel after another costs a lookup in the cache. The delayed
+ * signals are exposed through the list output controlSignal, with one
+ * channel per registered signal.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API DelayBank : public ModelComponent {
+OpenSim_DECLARE_CONCRETE_OBJECT(DelayBank, ModelComponent);
+
+public:
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(minimum_step_size, double, "The smallest time step (seconds) the integrator is expected to take, used to size the signal history");
+    
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    // the delayed signal of every registered channel
+    OpenSim_DECLARE_LIST_OUTPUT(controlSignal, double, getSignal, SimTK::Stage::Velocity);
+    //
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DelayBank();
+    DelayBank(const std::string& name);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+    
+//--------------------------------------------------------------------------
+// DELAY BANK PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    void setMinimumStepSize(double minimumStepSize);
+    double getMinimumStepSize() const;
+    
+//--------------------------------------------------------------------------
+// CHANNELS
+//--------------------------------------------------------------------------
+    /** Register a channel that delays source by delay seconds and sends
+        defaultSignal until the delayed signal is available. Registering a
+        name again replaces that channel. Channels are dropped when the
+        properties are finalized, so they are registered while the model is
+        connected. Returns the index of the channel. */
+    int addChannel(const std::string& name,
+                   const AbstractOutput& source,
+                   double delay,
+                   double defaultSignal);
+    /** Register a channel that delays one channel of a list output, e.g. the
+        signal of a circuit evaluated by a ReflexCircuitSet. */
+    int addChannel(const std::string& name,
+                   const AbstractChannel& source,
+                   double delay,
+                   double defaultSignal);
+    
+    int getNumChannels() const;
+    /** Index of the channel called name, or -1. */
+    int getChannelIndex(const std::string& name) const;
+    /** Number of distinct source outputs stored for the channels. */
+    int getNumSources() const;
+    /** Index of the stored source read by the channel at index. */
+    int getChannelSource(int index) const;
+    
+//--------------------------------------------------------------------------
+// DELAY BANK STATE DEPENDENT ACCESSORS
+//--------------------------------------------------------------------------
+    /** The delayed signal of every channel, in channel order. */
+    const SimTK::Vector& getSignals(const SimTK::State& s) const;
+    /** The delayed signal of the channel called name. */
+    double getSignal(const SimTK::State& s, const std::string& name) const;
+    /** The delayed signal of the channel at index. */
+    double getChannelSignal(const SimTK::State& s, int index) const;
+    
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // Check the properties and drop the registered channels
+    void extendFinalizeFromProperties() override;
+    // Allocate the cache of delayed signals
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Allocate the history of all channels in the State
+    void extendRealizeTopology(SimTK::State& s) const override;
+    // Sample the channels on every step even when nothing reads the output
+    void extendRealizeAcceleration(const SimTK::State& s) const override;
+    
+    // The committed history of the State, and the history that will replace
+    // it if the current step is accepted
+    const DelayBankHistory& getHistory(const SimTK::State& s) const;
+    const DelayBankHistory& getUpdatedHistory(const SimTK::State& s) const;
+    
+    // Stored sources, one per distinct output path
+    std::vector<std::string> _sourcePaths;
+    std::vector<SimTK::ReferencePtr<const Output<double>::Channel> > _sources;
+    // The sources resolved into typed handles when the system is built
+    mutable std::vector<SignalSource> _sourceSignals;
+    
+    // Registered channels, each a tap on one stored source, with their
+    // index by name for the list output
+    std::vector<std::string> _channelNames;
+    std::map<std::string, int> _channelIndices;
+    std::vector<int> _channelSources;
+    std::vector<double> _delays;
+    std::vector<double> _defaults;
+    
+    // Auto-update discrete variable holding the DelayBankHistory
+    mutable SimTK::DiscreteVariableIndex _historyIndex;
+    mutable CacheVariable<SimTK::Vector> _signalsCV;
+    
+    // Scratch rows of each State for the sampled sources and the looked up
+    // channels
+    mutable CacheVariable<SimTK::Vector> _samplesCV;
+    mutable CacheVariable<SimTK::Vector> _lookupTimesCV;
+
+    
+protected:
+    //=========================================================================
+};  // END of class DelayBank
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_DelayBank_H_
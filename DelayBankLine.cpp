@@ -0,0 +1,414 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  DelayBankLine.cpp                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "DelayBankLine.h"
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DelayBankLine::DelayBankLine() :
+    _numChannels(0),
+    _head(0),
+    _size(0),
+    _maxDelay(0),
+    _startTime(0)
+{
+    reset(0, 0, 0, 1.0);
+}
+
+void DelayBankLine::reset(int numChannels, int numTaps, double maxDelay,
+                          double minStepSize)
+{
+    _numChannels = numChannels;
+    _maxDelay = maxDelay;
+
+    // one row per minimum step across the window, plus the bracketing row
+    // before the window and the newest row
+    int capacity = 2;
+    if (minStepSize > 0)
+    {
+        capacity += (int)std::ceil(maxDelay/minStepSize);
+    }
+
+    _times.assign(capacity, 0.0);
+    _values.assign(capacity*numChannels, 0.0);
+    _cursors.assign(numTaps, 0);
+    _low.assign(numTaps, 0);
+    _high.assign(numTaps, 0);
+    _weights.assign(numTaps, 0.0);
+    clear();
+}
+
+void DelayBankLine::clear()
+{
+    _head = 0;
+    _size = 0;
+    _startTime = 0;
+    std::fill(_cursors.begin(), _cursors.end(), 0);
+}
+
+//=============================================================================
+// SAMPLES
+//=============================================================================
+
+void DelayBankLine::push(double time, const double* values)
+{
+    // the integrator stepped back, forget the rows it threw away
+    while (_size > 0 && _times[slot(_size-1)] >= time)
+    {
+        --_size;
+    }
+
+    if (_size == 0)
+    {
+        _head = 0;
+        _startTime = time;
+    }
+    else if (_size == (int)_times.size())
+    {
+        grow();
+    }
+
+    int j = slot(_size);
+    _times[j] = time;
+    std::copy(values, values + _numChannels, _values.data() + j*_numChannels);
+    ++_size;
+
+    evict(time);
+}
+
+void DelayBankLine::findWeights(const int* channels,
+                                const double* times) const
+{
+    const int n = _numChannels;
+    const int numTaps = getNumTaps();
+    const int first = slot(0);
+    const int last = slot(_size-1);
+
+    // brackets and weights per tap, clamped at both ends of the line
+    for (int c = 0; c < numTaps; ++c)
+    {
+        double time = times[c];
+        int k = first;
+        int j = first;
+        double w = 0;
+        if (_size > 1 && time > _times[first])
+        {
+            if (time >= _times[last])
+            {
+                k = j = last;
+            }
+            else
+            {
+                int i = findBracket(c, time);
+                k = slot(i);
+                j = slot(i+1);
+                w = (time - _times[k])/(_times[j] - _times[k]);
+            }
+        }
+        _low[c] = k*n + channels[c];
+        _high[c] = j*n + channels[c];
+        _weights[c] = w;
+    }
+}
+
+void DelayBankLine::getValues(const int* channels, const double* times,
+                              double* values) const
+{
+    findWeights(channels, times);
+
+    // interpolate all taps in one pass
+    const int numTaps = getNumTaps();
+    const double* rows = _values.data();
+    int c = 0;
+#ifdef __AVX2__
+    for (; c + 4 <= numTaps; c += 4)
+    {
+        __m128i low = _mm_loadu_si128((const __m128i*)&_low[c]);
+        __m128i high = _mm_loadu_si128((const __m128i*)&_high[c]);
+        __m256d a = _mm256_i32gather_pd(rows, low, 8);
+        __m256d b = _mm256_i32gather_pd(rows, high, 8);
+        __m256d w = _mm256_loadu_pd(&_weights[c]);
+        _mm256_storeu_pd(values + c,
+            _mm256_add_pd(a, _mm256_mul_pd(w, _mm256_sub_pd(b, a))));
+    }
+#endif
+    for (; c < numTaps; ++c)
+    {
+        double a = rows[_low[c]];
+        values[c] = a + _weights[c]*(rows[_high[c]] - a);
+    }
+}
+
+void DelayBankLine::getValuesReference(const int* channels,
+                                       const double* times,
+                                       double* values) const
+{
+    findWeights(channels, times);
+
+    const int numTaps = getNumTaps();
+    const double* rows = _values.data();
+    for (int c = 0; c < numTaps; ++c)
+    {
+        double a = rows[_low[c]];
+        values[c] = a + _weights[c]*(rows[_high[c]] - a);
+    }
+}
+
+const char* DelayBankLine::getKernelName()
+{
+#ifdef __AVX2__
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+int DelayBankLine::findBracket(int tap, double time) const
+{
+    // callers guarantee times 0 < time < times size-1
+    int i = _cursors[tap];
+    if (i < 0 || i > _size-2 || _times[slot(i)] > time)
+    {
+        // the integrator stepped back past the cursor
+        int low = 0;
+        int high = (i < 0 || i > _size-2) ? _size-1 : i;
+        while (high - low > 1)
+        {
+            int mid = (low + high)/2;
+            if (_times[slot(mid)] <= time)
+            {
+                low = mid;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        i = low;
+    }
+    else
+    {
+        while (_times[slot(i+1)] <= time)
+        {
+            ++i;
+        }
+    }
+
+    _cursors[tap] = i;
+    return i;
+}
+
+void DelayBankLine::evict(double time)
+{
+    double horizon = time - _maxDelay;
+    int evicted = 0;
+    while (_size > 1 && _times[slot(1)] <= horizon)
+    {
+        _head = slot(1);
+        --_size;
+        ++evicted;
+    }
+    if (evicted > 0)
+    {
+        for (int& cursor : _cursors)
+        {
+            cursor -= evicted;
+        }
+    }
+}
+
+void DelayBankLine::grow()
+{
+    int capacity = (int)_times.size();
+    const int n = _numChannels;
+    vector<double> times(2*capacity);
+    vector<double> values(2*capacity*n);
+    for (int i = 0; i < _size; ++i)
+    {
+        int j = slot(i);
+        times[i] = _times[j];
+        std::copy(_values.data() + j*n, _values.data() + (j+1)*n,
+                  values.data() + i*n);
+    }
+    _times.swap(times);
+    _values.swap(values);
+    _head = 0;
+}
+
+
+//=============================================================================
+// DELAY BANK HISTORY
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DelayBankHistory::DelayBankHistory() :
+    _hasPending(false),
+    _pendingTime(0),
+    _numCommitted(0),
+    _numEvaluated(0)
+{
+}
+
+void DelayBankHistory::reset(int numChannels, int numTaps, double maxDelay,
+                             double minStepSize)
+{
+    _line.reset(numChannels, numTaps, maxDelay, minStepSize);
+    _pendingValues.assign(numChannels, 0.0);
+    _hasPending = false;
+    _numCommitted = 0;
+    _numEvaluated = 0;
+}
+
+void DelayBankHistory::prepareUpdate(const DelayBankHistory& committed,
+                                     double time, const double* values)
+{
+    long long numEvaluated = std::max(_numEvaluated, committed._numEvaluated);
+    long long numCommitted =
+        committed._numCommitted + (committed._hasPending ? 1 : 0);
+
+    // this is the history the integrator swapped out on the last step
+    if (_hasPending && _numCommitted + 1 == committed._numCommitted)
+    {
+        commitPending();
+    }
+
+    if (hasSameLine(committed))
+    {
+        // fold the row of the last accepted step
+        _hasPending = committed._hasPending;
+        _pendingTime = committed._pendingTime;
+        _pendingValues = committed._pendingValues;
+        commitPending();
+    }
+    else if (!(_numCommitted == numCommitted &&
+               (!committed._hasPending ||
+                (!_line.isEmpty() &&
+                 _line.getLastTime() == committed._pendingTime))))
+    {
+        // not an earlier trial of this step either, start from a copy
+        *this = committed;
+        commitPending();
+    }
+
+    _hasPending = true;
+    _pendingTime = time;
+    std::copy(values, values + _line.getNumChannels(), _pendingValues.begin());
+    _numEvaluated = numEvaluated + 1;
+}
+
+void DelayBankHistory::getValues(const int* channels, const double* times,
+                                 double* values) const
+{
+    const int numTaps = _line.getNumTaps();
+    if (!_hasPending)
+    {
+        _line.getValues(channels, times, values);
+        return;
+    }
+    if (_line.isEmpty())
+    {
+        for (int c = 0; c < numTaps; ++c)
+        {
+            values[c] = _pendingValues[channels[c]];
+        }
+        return;
+    }
+
+    _line.getValues(channels, times, values);
+
+    // only taps with a delay shorter than the last step reach past the line
+    // into the pending row
+    double lastTime = _line.getLastTime();
+    const double* lastValues = _line.getLastValues();
+    for (int c = 0; c < numTaps; ++c)
+    {
+        if (times[c] >= _pendingTime)
+        {
+            values[c] = _pendingValues[channels[c]];
+        }
+        else if (times[c] > lastTime)
+        {
+            int k = channels[c];
+            double w = (times[c] - lastTime)/(_pendingTime - lastTime);
+            values[c] = lastValues[k] + w*(_pendingValues[k] - lastValues[k]);
+        }
+    }
+}
+
+double DelayBankHistory::getStartTime() const
+{
+    return _line.isEmpty() ? _pendingTime : _line.getStartTime();
+}
+
+void DelayBankHistory::commitPending()
+{
+    if (_hasPending)
+    {
+        _line.push(_pendingTime, _pendingValues.data());
+        _hasPending = false;
+        ++_numCommitted;
+    }
+}
+
+bool DelayBankHistory::hasSameLine(const DelayBankHistory& other) const
+{
+    if (_numCommitted != other._numCommitted ||
+        _line.getSize() != other._line.getSize())
+    {
+        return false;
+    }
+    return _line.isEmpty() ||
+        (_line.getStartTime() == other._line.getStartTime() &&
+         _line.getLastTime() == other._line.getLastTime());
+}
+
+std::ostream& OpenSim::operator<<(std::ostream& out,
+                                  const DelayBankHistory& history)
+{
+    return out << "DelayBankHistory(channels="
+               << history.getLine().getNumChannels()
+               << ", taps=" << history.getLine().getNumTaps()
+               << ", rows=" << history.getLine().getSize()
+               << ", committed=" << history.getNumCommitted()
+               << ", evaluated=" << history.getNumEvaluated() << ")";
+}
@@ -0,0 +1,233 @@
+#ifndef OPENSIM_DelayBankLine_H_
+#define OPENSIM_DelayBankLine_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: DelayBankLine.h                              *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimDelayDLL.h"
+#include <iosfwd>
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * DelayBankLine is the multi-channel counterpart of DelayLine used by the
+ * DelayBank component. All channels are sampled at the same times, so the
+ * line keeps one ring of sample times and one row of channel values per
+ * sample, stored contiguously: a sample row is a single cache-friendly block
+ * and a lookup for every channel touches two rows per bracket.
+ *
+ * The rows are kept rather than one array per channel because a push is
+ * one row of all channels, written with a single copy, while the taps read
+ * their channels at times of their own, in brackets that differ from tap to
+ * tap: with an array per channel the push would become a strided write to
+ * every array and the lookups would gather all the same.
+ *
+ * The line is read through taps. Each tap reads one channel at its own time
+ * (t minus the delay of that tap), and any number of taps may read the same
+ * channel, so a signal is stored once however many delays read it. The
+ * brackets are found per tap with a cursor, as in DelayLine, and the values
+ * of all taps are then interpolated in one pass, gathering four taps at a
+ * time with AVX2 when the library is built for it (ENABLE_AVX2) and one at
+ * a time otherwise; getValuesReference() is the scalar pass the gather is
+ * checked against. The window is sized for the
+ * longest delay of the bank. Only linear interpolation is supported and the
+ * line is never compacted, since the channels share their sample times.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API DelayBankLine {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DelayBankLine();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Size the buffer for numChannels channels read by numTaps taps and a
+        window of length maxDelay sampled no faster than minStepSize, and
+        discard all stored samples. */
+    void reset(int numChannels, int numTaps, double maxDelay,
+               double minStepSize);
+    /** Discard all stored samples, keeping the capacity. */
+    void clear();
+
+//--------------------------------------------------------------------------
+// DELAY BANK LINE ACCESSORS
+//--------------------------------------------------------------------------
+    /** Append a sample row of getNumChannels() values. Any stored rows at or
+        after time are discarded first so that the integrator may step back
+        and re-sample. */
+    void push(double time, const double* values);
+
+    /** Linearly interpolate channel channels[k] at time times[k] for every
+        tap k and write the result to values[k]. Times outside the stored
+        samples are clamped. Must not be called on an empty line. */
+    void getValues(const int* channels, const double* times,
+                   double* values) const;
+    /** getValues() interpolated one tap at a time. */
+    void getValuesReference(const int* channels, const double* times,
+                            double* values) const;
+    /** Name of the kernel getValues() was built with, "avx2" or "scalar". */
+    static const char* getKernelName();
+
+    bool isEmpty() const { return _size == 0; }
+    int getSize() const { return _size; }
+    int getNumChannels() const { return _numChannels; }
+    int getNumTaps() const { return (int)_cursors.size(); }
+    int getCapacity() const { return (int)_times.size(); }
+    double getMaxDelay() const { return _maxDelay; }
+    /** Time and values of the newest stored row. Must not be called on an
+        empty line. */
+    double getLastTime() const { return _times[slot(_size-1)]; }
+    const double* getLastValues() const
+    {
+        return _values.data() + slot(_size-1)*_numChannels;
+    }
+    /** Time of the first row pushed since the last reset or clear. */
+    double getStartTime() const { return _startTime; }
+
+private:
+    // position in the storage arrays of the i-th oldest stored row
+    int slot(int i) const
+    {
+        int j = _head + i;
+        return j < (int)_times.size() ? j : j - (int)_times.size();
+    }
+    // drop rows that can no longer be reached by a lookup at t - maxDelay
+    void evict(double time);
+    // double the storage when the integrator steps below the minimum step
+    void grow();
+    // index i of the bracket of tap with times i <= time < times i+1
+    int findBracket(int tap, double time) const;
+    // gather indices and weights of every tap
+    void findWeights(const int* channels, const double* times) const;
+
+    std::vector<double> _times;
+    std::vector<double> _values;
+    int _numChannels;
+    int _head;
+    int _size;
+    double _maxDelay;
+    double _startTime;
+
+    // per tap bracket cursor and the gather indices and weights of the last
+    // lookup
+    mutable std::vector<int> _cursors;
+    mutable std::vector<int> _low;
+    mutable std::vector<int> _high;
+    mutable std::vector<double> _weights;
+
+};  // END of class DelayBankLine
+
+//=============================================================================
+//=============================================================================
+/**
+ * DelayBankHistory is the per-State record of a DelayBank: the line of
+ * committed rows plus one pending row taken at the current time of the
+ * State. It is committed on accepted steps exactly like DelayHistory, so
+ * the update held by the bank is brought up to date by folding rows rather
+ * than by copying the whole bank.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API DelayBankHistory {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DelayBankHistory();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Size the line for numChannels, numTaps, maxDelay and minStepSize and
+        discard all rows and counters. */
+    void reset(int numChannels, int numTaps, double maxDelay,
+               double minStepSize);
+
+//--------------------------------------------------------------------------
+// DELAY BANK HISTORY ACCESSORS
+//--------------------------------------------------------------------------
+    /** Make this history the successor of committed: its pending row is
+        folded into the line and (time, values) becomes the pending row. */
+    void prepareUpdate(const DelayBankHistory& committed,
+                       double time, const double* values);
+
+    /** Channel channels[k] at times[k] for every tap k, interpolated across
+        the line and the pending row, written to values[k]. Must not be
+        called on an empty history. */
+    void getValues(const int* channels, const double* times,
+                   double* values) const;
+
+    bool isEmpty() const { return _line.isEmpty() && !_hasPending; }
+    bool hasPending() const { return _hasPending; }
+    /** Time of the first row of the history. */
+    double getStartTime() const;
+
+    const DelayBankLine& getLine() const { return _line; }
+
+    /** Number of rows folded into the line, i.e. taken on accepted steps. */
+    long long getNumCommitted() const { return _numCommitted; }
+    /** Number of rows taken on this history's lineage, including stages and
+        trial steps that were thrown away. */
+    long long getNumEvaluated() const { return _numEvaluated; }
+
+private:
+    // move the pending row into the line
+    void commitPending();
+    // same committed rows as other, judged by count and end rows
+    bool hasSameLine(const DelayBankHistory& other) const;
+
+    DelayBankLine _line;
+    bool _hasPending;
+    double _pendingTime;
+    std::vector<double> _pendingValues;
+    long long _numCommitted;
+    long long _numEvaluated;
+
+};  // END of class DelayBankHistory
+
+// Needed to store a DelayBankHistory in a SimTK::Value
+OSIMDELAY_API std::ostream& operator<<(std::ostream& out,
+                                       const DelayBankHistory& history);
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_DelayBankLine_H_
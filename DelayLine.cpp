@@ -0,0 +1,399 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  DelayLine.cpp                               *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "DelayLine.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DelayLine::DelayLine() :
+    _head(0),
+    _size(0),
+    _delay(0),
+    _startTime(0),
+    _tolerance(0),
+    _slopeLow(0),
+    _slopeHigh(0),
+    _numPushed(0),
+    _numDropped(0),
+    _interpolation(Linear),
+    _cursor(0)
+{
+    reset(0, 1.0);
+}
+
+void DelayLine::reset(double delay, double minStepSize, double tolerance,
+                      Interpolation interpolation)
+{
+    _delay = delay;
+    // only linear interpolation of the kept samples stays within the
+    // tolerance of the dropped ones
+    _tolerance = interpolation == Linear ? tolerance : 0;
+    _interpolation = interpolation;
+
+    // one sample per minimum step across the window, plus the two samples
+    // before the window the cubic kernel needs and the newest sample
+    int capacity = 3;
+    if (minStepSize > 0)
+    {
+        capacity += (int)std::ceil(delay/minStepSize);
+    }
+
+    _times.assign(capacity, 0.0);
+    _values.assign(capacity, 0.0);
+    clear();
+}
+
+void DelayLine::clear()
+{
+    _head = 0;
+    _size = 0;
+    _startTime = 0;
+    _numPushed = 0;
+    _numDropped = 0;
+    _cursor = 0;
+    resetSlopeBounds();
+}
+
+double DelayLine::getCompactionRatio() const
+{
+    long long kept = _numPushed - _numDropped;
+    return kept > 0 ? (double)_numPushed/kept : 1.0;
+}
+
+//=============================================================================
+// SAMPLES
+//=============================================================================
+
+void DelayLine::push(double time, double value)
+{
+    // the integrator stepped back, forget the samples it threw away
+    if (_size > 0 && _times[slot(_size-1)] >= time)
+    {
+        while (_size > 0 && _times[slot(_size-1)] >= time)
+        {
+            --_size;
+        }
+        resetSlopeBounds();
+    }
+
+    ++_numPushed;
+    if (compact(time, value))
+    {
+        ++_numDropped;
+        evict(time);
+        return;
+    }
+    resetSlopeBounds();
+
+    if (_size == 0)
+    {
+        _head = 0;
+        _startTime = time;
+    }
+    else if (_size == (int)_times.size())
+    {
+        grow();
+    }
+
+    int j = slot(_size);
+    _times[j] = time;
+    _values[j] = value;
+    ++_size;
+
+    evict(time);
+}
+
+double DelayLine::getValue(double time) const
+{
+    int first = slot(0);
+    if (_size == 1 || time <= _times[first])
+    {
+        return _values[first];
+    }
+
+    int last = slot(_size-1);
+    if (time >= _times[last])
+    {
+        return _values[last];
+    }
+
+    return interpolate(findBracket(time), time);
+}
+
+int DelayLine::findBracket(double time) const
+{
+    // callers guarantee times 0 < time < times size-1
+    int i = _cursor;
+    if (i < 0 || i > _size-2 || _times[slot(i)] > time)
+    {
+        // the integrator stepped back past the cursor
+        int low = 0;
+        int high = (i < 0 || i > _size-2) ? _size-1 : i;
+        while (high - low > 1)
+        {
+            int mid = (low + high)/2;
+            if (_times[slot(mid)] <= time)
+            {
+                low = mid;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        i = low;
+    }
+    else
+    {
+        while (_times[slot(i+1)] <= time)
+        {
+            ++i;
+        }
+    }
+
+    _cursor = i;
+    return i;
+}
+
+double DelayLine::interpolate(int i, double time) const
+{
+    // the kernels are written once, for the compile time lookups
+    switch (_interpolation)
+    {
+        case ZeroOrderHold:
+            return interpolate<ZeroOrderHold>(i, time);
+        case CubicHermite:
+            return interpolate<CubicHermite>(i, time);
+        default:
+            return interpolate<Linear>(i, time);
+    }
+}
+
+void DelayLine::evict(double time)
+{
+    // the cubic kernel also needs the sample before the bracket
+    int keep = _interpolation == CubicHermite ? 2 : 1;
+    double horizon = time - _delay;
+    while (_size > keep && _times[slot(keep)] <= horizon)
+    {
+        _head = slot(1);
+        --_size;
+        --_cursor;
+    }
+    if (_size < 2)
+    {
+        resetSlopeBounds();
+    }
+}
+
+bool DelayLine::compact(double time, double value)
+{
+    if (_tolerance <= 0 || _size < 2)
+    {
+        return false;
+    }
+
+    int anchor = slot(_size-2);
+    int last = slot(_size-1);
+
+    // the provisional sample must stay within the tolerance of the segment
+    double dt = _times[last] - _times[anchor];
+    double low = std::max(_slopeLow,
+        (_values[last] - _tolerance - _values[anchor])/dt);
+    double high = std::min(_slopeHigh,
+        (_values[last] + _tolerance - _values[anchor])/dt);
+
+    double slope = (value - _values[anchor])/(time - _times[anchor]);
+    if (slope < low || slope > high)
+    {
+        return false;
+    }
+
+    _times[last] = time;
+    _values[last] = value;
+    _slopeLow = low;
+    _slopeHigh = high;
+    return true;
+}
+
+void DelayLine::resetSlopeBounds()
+{
+    _slopeLow = -numeric_limits<double>::infinity();
+    _slopeHigh = numeric_limits<double>::infinity();
+}
+
+void DelayLine::grow()
+{
+    int capacity = (int)_times.size();
+    vector<double> times(2*capacity);
+    vector<double> values(2*capacity);
+    for (int i = 0; i < _size; ++i)
+    {
+        times[i] = _times[slot(i)];
+        values[i] = _values[slot(i)];
+    }
+    _times.swap(times);
+    _values.swap(values);
+    _head = 0;
+}
+
+
+//=============================================================================
+// DELAY HISTORY
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DelayHistory::DelayHistory() :
+    _hasPending(false),
+    _pendingTime(0),
+    _pendingValue(0),
+    _numCommitted(0),
+    _numEvaluated(0)
+{
+}
+
+void DelayHistory::reset(double delay, double minStepSize, double tolerance,
+                         DelayLine::Interpolation interpolation)
+{
+    _line.reset(delay, minStepSize, tolerance, interpolation);
+    _hasPending = false;
+    _numCommitted = 0;
+    _numEvaluated = 0;
+}
+
+void DelayHistory::prepareUpdate(const DelayHistory& committed,
+                                 double time, double value)
+{
+    long long numEvaluated = std::max(_numEvaluated, committed._numEvaluated);
+    long long numCommitted =
+        committed._numCommitted + (committed._hasPending ? 1 : 0);
+
+    // this is the history the integrator swapped out on the last step
+    if (_hasPending && _numCommitted + 1 == committed._numCommitted)
+    {
+        commitPending();
+    }
+
+    if (hasSameLine(committed))
+    {
+        // fold the sample of the last accepted step
+        _hasPending = committed._hasPending;
+        _pendingTime = committed._pendingTime;
+        _pendingValue = committed._pendingValue;
+        commitPending();
+    }
+    else if (!(_numCommitted == numCommitted &&
+               (!committed._hasPending ||
+                (!_line.isEmpty() &&
+                 _line.getLastTime() == committed._pendingTime))))
+    {
+        // not an earlier trial of this step either, start from a copy
+        *this = committed;
+        commitPending();
+    }
+
+    _hasPending = true;
+    _pendingTime = time;
+    _pendingValue = value;
+    _numEvaluated = numEvaluated + 1;
+}
+
+double DelayHistory::getValue(double time) const
+{
+    if (!_hasPending)
+    {
+        return _line.getValue(time);
+    }
+    if (_line.isEmpty() || time >= _pendingTime)
+    {
+        return _pendingValue;
+    }
+
+    double lastTime = _line.getLastTime();
+    if (time <= lastTime)
+    {
+        return _line.getValue(time);
+    }
+
+    // only reached when the delay is shorter than the last step
+    double lastValue = _line.getLastValue();
+    if (_line.getInterpolation() == DelayLine::ZeroOrderHold)
+    {
+        return lastValue;
+    }
+    double w = (time - lastTime)/(_pendingTime - lastTime);
+    return lastValue + w*(_pendingValue - lastValue);
+}
+
+double DelayHistory::getStartTime() const
+{
+    return _line.isEmpty() ? _pendingTime : _line.getStartTime();
+}
+
+void DelayHistory::commitPending()
+{
+    if (_hasPending)
+    {
+        _line.push(_pendingTime, _pendingValue);
+        _hasPending = false;
+        ++_numCommitted;
+    }
+}
+
+bool DelayHistory::hasSameLine(const DelayHistory& other) const
+{
+    if (_numCommitted != other._numCommitted ||
+        _line.getSize() != other._line.getSize())
+    {
+        return false;
+    }
+    return _line.isEmpty() ||
+        (_line.getStartTime() == other._line.getStartTime() &&
+         _line.getLastTime() == other._line.getLastTime());
+}
+
+std::ostream& OpenSim::operator<<(std::ostream& out,
+                                  const DelayHistory& history)
+{
+    return out << "DelayHistory(samples=" << history.getLine().getSize()
+               << ", committed=" << history.getNumCommitted()
+               << ", evaluated=" << history.getNumEvaluated() << ")";
+}
@@ -0,0 +1,359 @@
+#ifndef OPENSIM_DelayLine_H_
+#define OPENSIM_DelayLine_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: DelayLine.h                                  *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimDelayDLL.h"
+#include <iosfwd>
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * DelayLine is a fixed-capacity ring buffer of (time, value) samples used by
+ * the Delay component to look up a signal at t - delay.
+ *
+ * The capacity is sized from the delay and the smallest step the integrator
+ * is expected to take, so a full delay window always fits. Samples that fall
+ * out of the delay window are evicted as new samples are pushed; only the
+ * newest sample at or before t - delay is kept as the left end of the
+ * interpolation bracket (and the one before it for the cubic kernel). Pushing and looking up are both O(1) for time
+ * marching forward. If the integrator ever steps below the expected minimum
+ * step the buffer doubles once rather than dropping samples inside the
+ * window.
+ *
+ * With a positive tolerance the line is compacted online with the swinging
+ * door method: the newest sample is provisional and is replaced by the next
+ * one whenever the segment from the sample before it to the new sample stays
+ * within the tolerance of every sample dropped since. Nearly collinear
+ * stretches of the signal then cost one stored sample instead of hundreds,
+ * and linear interpolation of the line is never off by more than the
+ * tolerance at a dropped sample. The bound holds for the linear kernel only:
+ * a zero-order hold or cubic rebuilt from the kept samples can be off by
+ * more, so compaction is used with the Linear kernel alone.
+ *
+ * Lookups keep a cursor on the last interpolation bracket. Queries are
+ * almost always monotone in time, so the next bracket is found by walking
+ * forward from the cursor in amortized O(1); a query before the cursor (the
+ * integrator backtracking) bisects the samples before it instead. The signal
+ * between samples is rebuilt with a zero-order hold, linear or cubic Hermite
+ * kernel.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API DelayLine {
+
+public:
+    /** Kernels used to rebuild the signal between stored samples. */
+    enum Interpolation {
+        ZeroOrderHold,  ///< hold the value of the sample at or before the time
+        Linear,         ///< straight line between the bracketing samples
+        CubicHermite    ///< cubic with finite difference slopes at the bracket
+    };
+
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DelayLine();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Size the buffer for a window of length delay sampled no faster than
+        minStepSize, and discard all stored samples. A positive tolerance
+        turns on compaction with the Linear kernel; it is ignored with the
+        other kernels, for which the tolerance is not a bound. */
+    void reset(double delay, double minStepSize, double tolerance = 0,
+               Interpolation interpolation = Linear);
+    /** Discard all stored samples, keeping the capacity. */
+    void clear();
+
+//--------------------------------------------------------------------------
+// DELAY LINE ACCESSORS
+//--------------------------------------------------------------------------
+    /** Append a sample. Any stored samples at or after time are discarded
+        first so that the integrator may step back and re-sample. */
+    void push(double time, double value);
+
+    /** Interpolate the stored signal at time with the kernel of the line.
+        Times before the oldest stored sample or after the newest one are
+        clamped. Must not be called on an empty line. */
+    double getValue(double time) const;
+    /** getValue() with kernel K fixed at compile time, so the kernel inlines
+        into the caller. K must be the kernel the line was reset with. */
+    template <Interpolation K>
+    double getValue(double time) const;
+
+    bool isEmpty() const { return _size == 0; }
+    int getSize() const { return _size; }
+    /** Time and value of the newest stored sample. Must not be called on an
+        empty line. */
+    double getLastTime() const { return _times[slot(_size-1)]; }
+    double getLastValue() const { return _values[slot(_size-1)]; }
+    int getCapacity() const { return (int)_times.size(); }
+    double getDelay() const { return _delay; }
+    /** Time of the first sample pushed since the last reset or clear. */
+    double getStartTime() const { return _startTime; }
+
+    double getTolerance() const { return _tolerance; }
+    Interpolation getInterpolation() const { return _interpolation; }
+    /** Number of samples pushed and number dropped by compaction since the
+        last reset or clear. */
+    long long getNumPushed() const { return _numPushed; }
+    long long getNumDropped() const { return _numDropped; }
+    /** Samples pushed per sample kept; 1 without compaction. */
+    double getCompactionRatio() const;
+
+private:
+    // position in the storage arrays of the i-th oldest stored sample
+    int slot(int i) const
+    {
+        int j = _head + i;
+        return j < (int)_times.size() ? j : j - (int)_times.size();
+    }
+    // drop samples that can no longer be reached by a lookup at t - delay
+    void evict(double time);
+    // replace the provisional newest sample if the tolerance allows it
+    bool compact(double time, double value);
+    // forget the slope bounds of the dropped samples
+    void resetSlopeBounds();
+    // double the storage when the integrator steps below the minimum step
+    void grow();
+    // index i of the bracket with times i <= time < times i+1, from the cursor
+    int findBracket(double time) const;
+    // apply the kernel on the bracket starting at index i
+    double interpolate(int i, double time) const;
+    template <Interpolation K>
+    double interpolate(int i, double time) const;
+
+    std::vector<double> _times;
+    std::vector<double> _values;
+    int _head;
+    int _size;
+    double _delay;
+    double _startTime;
+
+    // swinging door state: the slopes from the sample before the newest one
+    // that keep every dropped sample within the tolerance
+    double _tolerance;
+    double _slopeLow;
+    double _slopeHigh;
+    long long _numPushed;
+    long long _numDropped;
+
+    Interpolation _interpolation;
+    // index of the last bracket found, a hint for the next lookup
+    mutable int _cursor;
+
+};  // END of class DelayLine
+
+//=============================================================================
+//=============================================================================
+/**
+ * DelayHistory is the per-State record of a delayed signal. It holds the
+ * DelayLine of committed samples plus one pending sample taken at the current
+ * time of the State.
+ *
+ * Delay keeps the committed history in an auto-update discrete variable and
+ * builds the next history in its update cache: the pending sample of the
+ * committed history is folded into the line and the sample at the current
+ * time becomes the new pending sample. The integrator swaps the update into
+ * the State only when a step is accepted, so samples from error-estimate
+ * stages and rejected trial steps never enter the line.
+ *
+ * Rebuilding the update would mean copying the line on every evaluation. The
+ * update cache still holds the previous committed history or an earlier
+ * trial from this step, so prepareUpdate() brings it up to date with at most
+ * two folds and only copies the committed history when neither applies (for
+ * example after a State was restored from an older copy).
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API DelayHistory {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DelayHistory();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Size the line for delay and minStepSize, set its compaction
+        tolerance and kernel and discard all samples and counters. */
+    void reset(double delay, double minStepSize, double tolerance = 0,
+               DelayLine::Interpolation interpolation = DelayLine::Linear);
+
+//--------------------------------------------------------------------------
+// DELAY HISTORY ACCESSORS
+//--------------------------------------------------------------------------
+    /** Make this history the successor of committed: its pending sample is
+        folded into the line and (time, value) becomes the pending sample. */
+    void prepareUpdate(const DelayHistory& committed,
+                       double time, double value);
+
+    /** The signal at time, interpolated across the line and the pending
+        sample. Must not be called on an empty history. */
+    double getValue(double time) const;
+    /** getValue() with the kernel of the line fixed at compile time. */
+    template <DelayLine::Interpolation K>
+    double getValue(double time) const;
+
+    bool isEmpty() const { return _line.isEmpty() && !_hasPending; }
+    bool hasPending() const { return _hasPending; }
+    /** Time of the first sample of the history. */
+    double getStartTime() const;
+
+    const DelayLine& getLine() const { return _line; }
+
+    /** Number of samples folded into the line, i.e. taken on accepted
+        steps. */
+    long long getNumCommitted() const { return _numCommitted; }
+    /** Number of samples taken on this history's lineage, including stages
+        and trial steps that were thrown away. */
+    long long getNumEvaluated() const { return _numEvaluated; }
+
+private:
+    // move the pending sample into the line
+    void commitPending();
+    // same committed samples as other, judged by count and end samples
+    bool hasSameLine(const DelayHistory& other) const;
+
+    DelayLine _line;
+    bool _hasPending;
+    double _pendingTime;
+    double _pendingValue;
+    long long _numCommitted;
+    long long _numEvaluated;
+
+};  // END of class DelayHistory
+
+// Needed to store a DelayHistory in a SimTK::Value
+OSIMDELAY_API std::ostream& operator<<(std::ostream& out,
+                                       const DelayHistory& history);
+
+//=============================================================================
+// COMPILE TIME KERNELS
+//=============================================================================
+
+template <DelayLine::Interpolation K>
+inline double DelayLine::getValue(double time) const
+{
+    int first = slot(0);
+    if (_size == 1 || time <= _times[first])
+    {
+        return _values[first];
+    }
+
+    int last = slot(_size-1);
+    if (time >= _times[last])
+    {
+        return _values[last];
+    }
+
+    return interpolate<K>(findBracket(time), time);
+}
+
+template <DelayLine::Interpolation K>
+inline double DelayLine::interpolate(int i, double time) const
+{
+    int k = slot(i);
+    if (K == ZeroOrderHold)
+    {
+        return _values[k];
+    }
+
+    int j = slot(i+1);
+    double h = _times[j] - _times[k];
+    double s = (time - _times[k])/h;
+    if (K == Linear)
+    {
+        return _values[k] + s*(_values[j] - _values[k]);
+    }
+
+    // finite difference slopes at both ends of the bracket, one-sided at the
+    // ends of the line
+    double secant = (_values[j] - _values[k])/h;
+    double slopeK = secant;
+    if (i > 0)
+    {
+        int p = slot(i-1);
+        slopeK = (_values[j] - _values[p])/(_times[j] - _times[p]);
+    }
+    double slopeJ = secant;
+    if (i+2 < _size)
+    {
+        int n = slot(i+2);
+        slopeJ = (_values[n] - _values[k])/(_times[n] - _times[k]);
+    }
+
+    double s2 = s*s;
+    double s3 = s2*s;
+    return (2*s3 - 3*s2 + 1)*_values[k] + (s3 - 2*s2 + s)*h*slopeK
+         + (-2*s3 + 3*s2)*_values[j] + (s3 - s2)*h*slopeJ;
+}
+
+template <DelayLine::Interpolation K>
+inline double DelayHistory::getValue(double time) const
+{
+    if (!_hasPending)
+    {
+        return _line.getValue<K>(time);
+    }
+    if (_line.isEmpty() || time >= _pendingTime)
+    {
+        return _pendingValue;
+    }
+
+    double lastTime = _line.getLastTime();
+    if (time <= lastTime)
+    {
+        return _line.getValue<K>(time);
+    }
+
+    // only reached when the delay is shorter than the last step
+    double lastValue = _line.getLastValue();
+    if (K == DelayLine::ZeroOrderHold)
+    {
+        return lastValue;
+    }
+    double w = (time - lastTime)/(_pendingTime - lastTime);
+    return lastValue + w*(_pendingValue - lastValue);
+}
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_DelayLine_H_
@@ -0,0 +1,252 @@
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim:  DynamicSpindle.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "DynamicSpindle.h"
+#include <OpenSim/OpenSim.h>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+namespace {
+    
+    // in the order of SpindleDynamics::StateIndex
+    const char* stateNames[SpindleDynamics::NumStates] = {
+        "bag1_tension",
+        "bag1_tension_rate",
+        "bag2_tension",
+        "bag2_tension_rate",
+        "chain_tension",
+        "chain_tension_rate",
+        "bag1_activation",
+        "bag2_activation"
+    };
+    
+}
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+DynamicSpindle::DynamicSpindle()
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+DynamicSpindle::DynamicSpindle(const std::string& name,
+                               const Muscle& muscle,
+                               double dynamicDrive,
+                               double staticDrive)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    connectSocket_muscle(muscle);
+    
+    constructProperties();
+    set_dynamic_fusimotor_drive(dynamicDrive);
+    set_static_fusimotor_drive(staticDrive);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+
+void DynamicSpindle::constructProperties()
+{
+    constructProperty_dynamic_fusimotor_drive(0.0);
+    constructProperty_static_fusimotor_drive(0.0);
+}
+
+void DynamicSpindle::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+    
+    OPENSIM_THROW_IF_FRMOBJ(get_dynamic_fusimotor_drive() < 0, InvalidPropertyValue, getName(), "The fusimotor drive must not be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_static_fusimotor_drive() < 0, InvalidPropertyValue, getName(), "The fusimotor drive must not be negative");
+    
+    _dynamics.setFusimotorDrive(get_dynamic_fusimotor_drive(), get_static_fusimotor_drive());
+}
+
+void DynamicSpindle::extendConnectToModel(Model &model)
+{
+    Super::extendConnectToModel(model);
+    
+    _muscle.reset(&getMuscle());
+}
+
+void DynamicSpindle::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    for (int k = 0; k < SpindleDynamics::NumStates; ++k)
+    {
+        addStateVariable(stateNames[k]);
+    }
+}
+
+void DynamicSpindle::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    // the states are allocated by Component, so their indices are known
+    // from here on and the derivatives are kept in the cache variables it
+    // adds with them
+    for (int k = 0; k < SpindleDynamics::NumStates; ++k)
+    {
+        _stateIndices[k] = SimTK::ZIndex(getStateIndex(stateNames[k]));
+        _derivativeIndices[k] =
+            getCacheVariableIndex(std::string(stateNames[k]) + "_deriv");
+    }
+}
+
+void DynamicSpindle::extendInitStateFromProperties(SimTK::State& s) const
+{
+    Super::extendInitStateFromProperties(s);
+    
+    double y[SpindleDynamics::NumStates];
+    _dynamics.computeRestState(1.0, y);
+    for (int k = 0; k < SpindleDynamics::NumStates; ++k)
+    {
+        setStateVariableValue(s, stateNames[k], y[k]);
+    }
+}
+
+void DynamicSpindle::computeStateVariableDerivatives(const SimTK::State& s) const
+{
+    Super::computeStateVariableDerivatives(s);
+    
+    double y[SpindleDynamics::NumStates], dy[SpindleDynamics::NumStates];
+    getStates(s, y);
+    _dynamics.computeDerivatives(y, getNormalizedFiberLength(s),
+                                 getNormalizedFiberVelocity(s), dy);
+    
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    for (int k = 0; k < SpindleDynamics::NumStates; ++k)
+    {
+        SimTK::Value<double>::updDowncast(
+            s.updCacheEntry(subsys, _derivativeIndices[k])).upd() = dy[k];
+        s.markCacheValueRealized(subsys, _derivativeIndices[k]);
+    }
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+double DynamicSpindle::getDynamicFusimotorDrive() const
+{
+    return get_dynamic_fusimotor_drive();
+}
+void DynamicSpindle::setDynamicFusimotorDrive(double drive)
+{
+    set_dynamic_fusimotor_drive(drive);
+}
+
+double DynamicSpindle::getStaticFusimotorDrive() const
+{
+    return get_static_fusimotor_drive();
+}
+void DynamicSpindle::setStaticFusimotorDrive(double drive)
+{
+    set_static_fusimotor_drive(drive);
+}
+
+const Muscle& DynamicSpindle::getMuscle() const
+{
+    return getSocket<Muscle>("muscle").getConnectee();
+}
+
+const char* DynamicSpindle::getStateName(int index)
+{
+    return stateNames[index];
+}
+
+void DynamicSpindle::getStates(const SimTK::State& s, double* y) const
+{
+    const SimTK::Vector& z = getSystem().getDefaultSubsystem().getZ(s);
+    for (int k = 0; k < SpindleDynamics::NumStates; ++k)
+    {
+        y[k] = z[_stateIndices[k]];
+    }
+}
+
+double DynamicSpindle::getNormalizedFiberLength(const SimTK::State& s) const
+{
+    return _muscle->getFiberLength(s)/_muscle->getOptimalFiberLength();
+}
+
+double DynamicSpindle::getNormalizedFiberVelocity(const SimTK::State& s) const
+{
+    return _muscle->getFiberVelocity(s)/_muscle->getOptimalFiberLength();
+}
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+
+double DynamicSpindle::getPrimaryAfferent(const SimTK::State& s) const
+{
+    double y[SpindleDynamics::NumStates];
+    getStates(s, y);
+    return _dynamics.getPrimaryAfferent(y);
+}
+
+double DynamicSpindle::getSecondaryAfferent(const SimTK::State& s) const
+{
+    double y[SpindleDynamics::NumStates];
+    getStates(s, y);
+    return _dynamics.getSecondaryAfferent(y, getNormalizedFiberLength(s));
+}
+
+SimTK::Matrix DynamicSpindle::getStateJacobian(const SimTK::State& s) const
+{
+    const int n = SpindleDynamics::NumStates;
+    double y[n], jacobian[n*n];
+    getStates(s, y);
+    _dynamics.computeJacobian(y, getNormalizedFiberLength(s),
+                              getNormalizedFiberVelocity(s), jacobian);
+    
+    SimTK::Matrix J(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            J(i, j) = jacobian[i*n + j];
+        }
+    }
+    return J;
+}
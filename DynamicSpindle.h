@@ -0,0 +1,159 @@
+#ifndef OPENSIM_DynamicSpindle_H_
+#define OPENSIM_DynamicSpindle_H_
+/* -------------------------------------------------------------------------- *
+ *                         OpenSim: DynamicSpindle.h                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimSimpleSpindleDLL.h"
+#include "SpindleDynamics.h"
+#include "OpenSim/Simulation/Model/Muscle.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+#include <array>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * DynamicSpindle is a muscle spindle with intrafusal fibre dynamics and
+ * fusimotor drive, after Mileusnic et al. (2006); see SpindleDynamics for
+ * the equations. Where SimpleSpindle is a rectified function of the length
+ * and speed of the muscle, DynamicSpindle adds eight continuous states, the
+ * tension and tension rate of the bag1, bag2 and chain fibres and the
+ * dynamic and static fusimotor activations, driven by the normalized fiber
+ * length and velocity of the muscle.
+ *
+ * The primary (Ia) and secondary (II) afferents are published as firing
+ * rates. getStateJacobian() returns the Jacobian of the state derivatives
+ * in closed form, for integrators and analyses that need it.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMSIMPLESPINDLE_API DynamicSpindle : public ModelComponent {
+OpenSim_DECLARE_CONCRETE_OBJECT(DynamicSpindle, ModelComponent);
+
+public:
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(dynamic_fusimotor_drive, double,
+        "Dynamic (gamma dynamic) fusimotor drive, in pulses per second");
+    OpenSim_DECLARE_PROPERTY(static_fusimotor_drive, double,
+        "Static (gamma static) fusimotor drive, in pulses per second");
+
+//==============================================================================
+// SOCKETS
+//==============================================================================
+    OpenSim_DECLARE_SOCKET(muscle, Muscle, "The muscle that the spindle measures");
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    OpenSim_DECLARE_OUTPUT(primary_afferent, double, getPrimaryAfferent, SimTK::Stage::Position);
+    OpenSim_DECLARE_OUTPUT(secondary_afferent, double, getSecondaryAfferent, SimTK::Stage::Position);
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    DynamicSpindle();
+    DynamicSpindle(const std::string& name,
+                   const Muscle& muscle,
+                   double dynamicDrive,
+                   double staticDrive);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+//--------------------------------------------------------------------------
+// SPINDLE PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    double getDynamicFusimotorDrive() const;
+    void setDynamicFusimotorDrive(double drive);
+    double getStaticFusimotorDrive() const;
+    void setStaticFusimotorDrive(double drive);
+
+    // The muscle that is measured
+    const Muscle& getMuscle() const;
+
+//--------------------------------------------------------------------------
+// SPINDLE STATE DEPENDENT ACCESSORS
+//--------------------------------------------------------------------------
+    double getPrimaryAfferent(const SimTK::State& s) const;
+    double getSecondaryAfferent(const SimTK::State& s) const;
+
+    /** The Jacobian of the derivatives of the states of the spindle with
+        respect to those states, in the order of
+        SpindleDynamics::StateIndex. s must be realized to Velocity. */
+    SimTK::Matrix getStateJacobian(const SimTK::State& s) const;
+
+    /** The name of the state variable at a SpindleDynamics::StateIndex. */
+    static const char* getStateName(int index);
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // Set the fusimotor drive of the fibre equations
+    void extendFinalizeFromProperties() override;
+    // ModelComponent interface to connect this component to its model
+    void extendConnectToModel(Model& aModel) override;
+    // Add the fibre states
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Look up the indices of the fibre states and their derivatives
+    void extendRealizeTopology(SimTK::State& s) const override;
+    // Start the fibres at rest at the optimal fiber length
+    void extendInitStateFromProperties(SimTK::State& s) const override;
+    // Fibre dynamics
+    void computeStateVariableDerivatives(const SimTK::State& s) const override;
+
+    // Copy the fibre states out of s
+    void getStates(const SimTK::State& s, double* y) const;
+    // Normalized fiber length and velocity of the muscle
+    double getNormalizedFiberLength(const SimTK::State& s) const;
+    double getNormalizedFiberVelocity(const SimTK::State& s) const;
+
+    SimTK::ReferencePtr<const Muscle> _muscle;
+    SpindleDynamics _dynamics;
+    // Indices of the fibre states in the default subsystem and of the cache
+    // entries holding their derivatives, in SpindleDynamics::StateIndex order
+    mutable std::array<SimTK::ZIndex, SpindleDynamics::NumStates> _stateIndices;
+    mutable std::array<SimTK::CacheEntryIndex, SpindleDynamics::NumStates> _derivativeIndices;
+
+protected:
+
+
+    //=========================================================================
+};  // END of class DynamicSpindle
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_DynamicSpindle_H_
@@ -0,0 +1,149 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  EnsembleController.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "EnsembleController.h"
+#include <OpenSim/OpenSim.h>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+EnsembleController::EnsembleController()
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+EnsembleController::EnsembleController(const std::string& name,
+                                       double defaultExcitation)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    
+    constructProperties();
+    set_default_excitation(defaultExcitation);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+void EnsembleController::constructProperties()
+{
+    constructProperty_default_excitation(0.0);
+}
+
+void EnsembleController::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    // changed only between steps, by setExcitation(), which invalidates the
+    // controls
+    const SimTK::Subsystem& subsys = getSystem().getDefaultSubsystem();
+    _excitationIndex = subsys.allocateDiscreteVariable(s,
+        SimTK::Stage::Velocity, new SimTK::Value<double>(get_default_excitation()));
+    
+    // the controls of an actuator follow those of the actuators before it
+    // in the model
+    const Set<Actuator>& actuators = getModel().getActuators();
+    const Set<const Actuator>& driven = getActuatorSet();
+    _controlIndices.assign(driven.getSize(), -1);
+    for (int c = 0; c < driven.getSize(); ++c)
+    {
+        int index = 0;
+        for (int i = 0; i < actuators.getSize(); ++i)
+        {
+            if (&actuators[i] == &driven[c])
+            {
+                _controlIndices[c] = index;
+                break;
+            }
+            index += actuators[i].numControls();
+        }
+        
+        OPENSIM_THROW_IF_FRMOBJ(_controlIndices[c] < 0, Exception, "Actuator '" + driven[c].getName() + "' is not an actuator of the model");
+    }
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+void EnsembleController::setDefaultExcitation(double defaultExcitation)
+{
+    set_default_excitation(defaultExcitation);
+}
+double EnsembleController::getDefaultExcitation() const
+{
+    return get_default_excitation();
+}
+
+double EnsembleController::getExcitation(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    return SimTK::Value<double>::downcast(
+        s.getDiscreteVariable(subsys, _excitationIndex)).get();
+}
+
+void EnsembleController::setExcitation(SimTK::State& s, double excitation) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    SimTK::Value<double>::updDowncast(
+        s.updDiscreteVariable(subsys, _excitationIndex)).upd() = excitation;
+}
+
+//=============================================================================
+// CONTROL
+//=============================================================================
+//_____________________________________________________________________________
+/**
+ * Excite the actuators with the excitation held in the State
+ *
+ * @param s         current state of the system
+ * @param controls  the model controls vector to add to
+ */
+
+void EnsembleController::computeControls(const SimTK::State& s,
+                                         SimTK::Vector& controls) const
+{
+    const double excitation = getExcitation(s);
+    for (int c = 0; c < (int)_controlIndices.size(); ++c)
+    {
+        controls[_controlIndices[c]] += excitation;
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef OPENSIM_EnsembleController_H_
+#define OPENSIM_EnsembleController_H_
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim: EnsembleController.h                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimReflexControllerDLL.h"
+#include "OpenSim/Simulation/Control/Controller.h"
+#include "OpenSim/Simulation/Model/Model.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * EnsembleController excites its actuators with one excitation held in the
+ * State, for circuits that are evaluated outside the model, as when the
+ * reflex circuits of an ensemble of models are evaluated together in one
+ * pass. The excitation is a discrete variable that starts at
+ * default_excitation and is changed only by setExcitation(), between steps
+ * of the integrator, so it is held constant over each step. Controls from
+ * other controllers on the same actuators are added to, as with any
+ * Controller.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMREFLEXCONTROLLER_API EnsembleController : public Controller {
+OpenSim_DECLARE_CONCRETE_OBJECT(EnsembleController, Controller);
+
+public:
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(default_excitation, double, "The excitation sent to every actuator of the controller until it is set in the State");
+    
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    EnsembleController();
+    EnsembleController(const std::string& name,
+                       double defaultExcitation);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+    
+//--------------------------------------------------------------------------
+// ENSEMBLE CONTROLLER PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    void setDefaultExcitation(double defaultExcitation);
+    double getDefaultExcitation() const;
+    
+    /** The excitation held in s. */
+    double getExcitation(const SimTK::State& s) const;
+    /** Hold excitation in s; invalidates the Velocity stage. */
+    void setExcitation(SimTK::State& s, double excitation) const;
+    
+//--------------------------------------------------------------------------
+// CONTROLLER INTERFACE
+//--------------------------------------------------------------------------
+    /** Add the held excitation to the control of every actuator. */
+    void computeControls(const SimTK::State& s,
+                         SimTK::Vector& controls) const override;
+    
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // Allocate the excitation and find the controls vector index of every
+    // actuator
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    mutable SimTK::DiscreteVariableIndex _excitationIndex;
+    mutable std::vector<int> _controlIndices;
+
+    
+protected:
+    //=========================================================================
+};  // END of class EnsembleController
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_EnsembleController_H_
@@ -91,6 +91,16 @@ void GolgiTendon::extendConnectToModel(Model &model)
 {
     Super::extendConnectToModel(model);
     
+    _muscle.reset(&getMuscle());
+}
+
+void GolgiTendon::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    // outputs are computed once per realization and counted
+    _lengthCV = addCacheVariable("length", 0.0, SimTK::Stage::Position);
+    _lengthCountCV = addCacheVariable("length_count", OutputCounter(), SimTK::Stage::Topology);
 }
 
 //=============================================================================
@@ -116,7 +126,7 @@ const Muscle& GolgiTendon::getMuscle() const
  * @param s         current state of the system
  */
 
-double GolgiTendon::getTendonLength(const SimTK::State& s) const
+double GolgiTendon::computeTendonLength(const SimTK::State& s) const
 {
     double tendon_length = 0;
     double tendon_slack_length = 0;
@@ -124,7 +134,7 @@ double GolgiTendon::getTendonLength(const SimTK::State& s) const
     double golgiLength = 0;
     double t_o = 1;
     
-    const Muscle& musc = getMuscle();
+    const Muscle& musc = *_muscle;
     
     t_o = musc.getTendonSlackLength();
     tendon_length = musc.getTendonLength(s);
@@ -136,3 +146,37 @@ double GolgiTendon::getTendonLength(const SimTK::State& s) const
     return golgiLength;
 }
 
+double GolgiTendon::getTendonLength(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _lengthCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _lengthCV))
+    {
+        return getCacheVariableValue(s, _lengthCV);
+    }
+    
+    ++counter.numComputed;
+    double golgiLength = computeTendonLength(s);
+    setCacheVariableValue(s, _lengthCV, golgiLength);
+    return golgiLength;
+}
+
+OutputCounter GolgiTendon::getTendonLengthCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _lengthCountCV);
+}
+
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int GolgiTendon::getSignalIndex(const std::string& outputName,
+                                const std::string& channelName) const
+{
+    return outputName == "golgiLength" ? 0 : -1;
+}
+
+double GolgiTendon::getSignalValue(const SimTK::State& s, int index) const
+{
+    return getTendonLength(s);
+}
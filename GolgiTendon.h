@@ -28,6 +28,8 @@
 // INCLUDE
 //============================================================================
 #include "osimGolgiTendonDLL.h"
+#include "SignalSource.h"
+#include "OutputCounter.h"
 #include "OpenSim/Simulation/Control/Controller.h"
 #include "OpenSim/Simulation/Model/Muscle.h"
 
@@ -45,7 +47,7 @@ namespace OpenSim {
  *
  * @author  Ajay Seth
  */
-class OSIMGOLGITENDON_API GolgiTendon : public ModelComponent {
+class OSIMGOLGITENDON_API GolgiTendon : public ModelComponent, public SignalProvider {
 OpenSim_DECLARE_CONCRETE_OBJECT(GolgiTendon, ModelComponent);
 
 public:
@@ -95,13 +97,32 @@ public:
     Get quanitites of interest common to all spindles*/
     void setTendonLength(SimTK::State& s, double signal) const;
     double getTendonLength(const SimTK::State& s) const;
-        
+    // How often golgiLength was computed and read on the lineage of s
+    OutputCounter getTendonLengthCounter(const SimTK::State& s) const;
+
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
+
 
 private:
+    // Evaluate the outputs, called once per realization
+    double computeTendonLength(const SimTK::State& s) const;
     // Connect properties to local pointers.  */
     void constructProperties();
     // ModelComponent interface to connect this component to its model
     void extendConnectToModel(Model& aModel) override;
+    // Allocate the cached outputs and their counters
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    
+    // The muscle and cache entries, resolved once rather than looked up by
+    // name on every evaluation
+    SimTK::ReferencePtr<const Muscle> _muscle;
+    mutable CacheVariable<double> _lengthCV;
+    mutable CacheVariable<OutputCounter> _lengthCountCV;
 
     
 protected:
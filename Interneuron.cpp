@@ -44,14 +44,18 @@ using namespace SimTK;
 //=============================================================================
 //_____________________________________________________________________________
 /* Default constructor. */
-Interneuron::Interneuron()
+Interneuron::Interneuron() :
+    _activation(Step),
+    _idle(false)
 {
     constructProperties();
 }
 
 /* Convenience constructor. */
 Interneuron::Interneuron(const std::string& name,
-                         double threshold)
+                         double threshold) :
+    _activation(Step),
+    _idle(false)
 {
     OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
        
@@ -84,19 +88,128 @@ void Interneuron::constructProperties()
 {
     constructProperty_threshold(0.5);
     constructProperty_weights();
+    constructProperty_activation("step");
+    constructProperty_sharpness(100.0);
+    constructProperty_localize_threshold(true);
 }
 
 
 void Interneuron::extendConnectToModel(Model &model)
 {
     Super::extendConnectToModel(model);
+    
+    // the owner may edit the weights after they were finalized
+    packWeights();
+}
+
+//=============================================================================
+// THRESHOLD EVENT
+//=============================================================================
+
+namespace {
+    
+    // Witness of the step activation: changes sign where the weighted sum
+    // crosses the threshold, so the integrator locates the jump of the signal
+    // and restarts on the other side of it. Nothing in the State changes.
+    class ThresholdWitness : public SimTK::TriggeredEventHandler {
+    public:
+        ThresholdWitness(const Interneuron& interneuron) :
+            SimTK::TriggeredEventHandler(SimTK::Stage::Velocity),
+            _interneuron(interneuron)
+        {
+        }
+        
+        SimTK::Real getValue(const SimTK::State& s) const override
+        {
+            return _interneuron.getWeightedSum(s) - _interneuron.getThreshold();
+        }
+        
+        void handleEvent(SimTK::State& s, SimTK::Real accuracy,
+                         bool& shouldTerminate) const override
+        {
+            shouldTerminate = false;
+        }
+        
+    private:
+        const Interneuron& _interneuron;
+    };
+    
+}
+
+void Interneuron::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    // outputs are computed once per realization and counted
+    _signalCV = addCacheVariable("signal", 0.0, SimTK::Stage::Velocity);
+    _signalCountCV = addCacheVariable("signal_count", OutputCounter(), SimTK::Stage::Topology);
+    // each State has its own buffer of afferent values, so that States of
+    // one model can be realized on several threads
+    _valuesCV = addCacheVariable("afferent_values",
+        SimTK::Vector(_weightedSum.getPaddedSize(), 0.0), SimTK::Stage::Topology);
+    
+    // only the step has a discontinuity to locate, and only if the signal
+    // is computed here
+    if (_activation == Step && get_localize_threshold() && !_idle)
+    {
+        system.addEventHandler(new ThresholdWitness(*this));
+    }
 }
 
 void Interneuron::extendFinalizeFromProperties()
 {
     Super::extendFinalizeFromProperties();
     
-    //OPENSIM_THROW_IF(getProperty_weights()., <#EXCEPTION, ...#>)
+    OPENSIM_THROW_IF_FRMOBJ(get_sharpness() <= 0, InvalidPropertyValue, getName(), "The sharpness must be positive");
+    
+    const std::string& activation = get_activation();
+    if (activation == "step")
+    {
+        _activation = Step;
+    }
+    else if (activation == "logistic")
+    {
+        _activation = Logistic;
+    }
+    else if (activation == "softplus")
+    {
+        _activation = Softplus;
+    }
+    else
+    {
+        OPENSIM_THROW_FRMOBJ(InvalidPropertyValue, getName(), "The activation must be 'step', 'logistic' or 'softplus'");
+    }
+    
+    packWeights();
+}
+
+void Interneuron::packWeights()
+{
+    const auto& weights = getProperty_weights();
+    std::vector<double> packed(weights.size());
+    double total = 0;
+    for (int i = 0; i < weights.size(); ++i)
+    {
+        packed[i] = weights[i];
+        total += weights[i];
+        OPENSIM_THROW_IF_FRMOBJ(weights[i] < 0 || weights[i] > 1, InvalidPropertyValue, getName(), "The weights must be between 0 and 1");
+    }
+    OPENSIM_THROW_IF_FRMOBJ(total > 1 + SimTK::SignificantReal, InvalidPropertyValue, getName(), "The weights cannot sum to more than 1");
+    
+    _weightedSum.assign(packed.data(), (int)packed.size());
+}
+
+void Interneuron::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    const Input<double>& afferents = getInput<double>("afferents");
+    OPENSIM_THROW_IF_FRMOBJ((int)afferents.getNumConnectees() != _weightedSum.getSize(), InvalidPropertyValue, getName(), "There are " + std::to_string(_weightedSum.getSize()) + " weights for " + std::to_string(afferents.getNumConnectees()) + " afferents");
+    _afferents.resize(afferents.getNumConnectees());
+    for (int i = 0; i < (int)_afferents.size(); ++i)
+    {
+        _afferents[i].bind(afferents.getChannel(i));
+    }
 }
 
 //=============================================================================
@@ -118,7 +231,43 @@ void Interneuron::setThreshold(double threshold)
 }
 double Interneuron::getThreshold() const
 {
-    get_threshold();
+    return get_threshold();
+}
+
+void Interneuron::setActivation(const std::string& activation)
+{
+    set_activation(activation);
+}
+const std::string& Interneuron::getActivation() const
+{
+    return get_activation();
+}
+
+void Interneuron::setSharpness(double sharpness)
+{
+    set_sharpness(sharpness);
+}
+double Interneuron::getSharpness() const
+{
+    return get_sharpness();
+}
+
+void Interneuron::setLocalizeThreshold(bool localizeThreshold)
+{
+    set_localize_threshold(localizeThreshold);
+}
+bool Interneuron::getLocalizeThreshold() const
+{
+    return get_localize_threshold();
+}
+
+void Interneuron::setIdle(bool idle)
+{
+    _idle = idle;
+}
+bool Interneuron::isIdle() const
+{
+    return _idle;
 }
 
 //-----------------------------------------------------------------------------
@@ -138,28 +287,117 @@ double Interneuron::getThreshold() const
 // get all the different inputs individually to assign weights to them
 
 
-double Interneuron::getSignal(const SimTK::State& s) const
+double Interneuron::computeSignal(const SimTK::State& s) const
 {
+    return activate(getWeightedSum(s));
+}
+
+double Interneuron::getWeightedSum(const SimTK::State& s) const
+{
+    // read the afferents through their resolved sources into the buffer of
+    // the State, then take one multiply-add reduction over the packed weights
+    double* values = updCacheVariableValue(s, _valuesCV).updContiguousScalarData();
+    for(int i = 0; i < (int)_afferents.size(); i++)
+    {
+        values[i] = _afferents[i].getValue(s);
+    }
+    return _weightedSum.evaluate(values);
+}
+
+//=============================================================================
+// ACTIVATION
+//=============================================================================
+
+namespace {
     
-    auto inputs = getInput<double>("afferents").getVector(s);
-    double signal = 0;
-    double threshold = get_threshold();
-    const auto& weights = getProperty_weights();
+    // 1/(1 + exp(-x)), without overflowing exp for large |x|
+    double logistic(double x)
+    {
+        if (x >= 0)
+        {
+            return 1/(1 + std::exp(-x));
+        }
+        double e = std::exp(x);
+        return e/(1 + e);
+    }
     
-    for(int i = 0; i<inputs.size(); i++)
+    // log(1 + exp(x)), without overflowing exp for large x
+    double softplus(double x)
     {
-        inputs[i] = weights[i]*inputs[i];
+        return std::max(x, 0.0) + std::log1p(std::exp(-std::fabs(x)));
     }
     
-    if (inputs.sum() > threshold)
+}
+
+double Interneuron::activate(double sum) const
+{
+    double threshold = get_threshold();
+    double signal = 0;
+    
+    switch (_activation)
     {
-        signal = inputs.sum();
+        case Logistic:
+        {
+            // the step sum*H(sum - threshold), with H a logistic function
+            signal = sum*logistic(get_sharpness()*(sum - threshold));
+            break;
+        }
+        case Softplus:
+        {
+            // the step written as threshold*H(x) + max(x, 0), x the sum
+            // above the threshold, with H logistic and max softplus
+            double k = get_sharpness();
+            double x = k*(sum - threshold);
+            signal = threshold*logistic(x) + softplus(x)/k;
+            break;
+        }
+        default:
+        {
+            if (sum > threshold)
+            {
+                signal = sum;
+            }
+            else
+            {
+                signal = 0;
+            }
+        }
     }
-    else
+    
+    return signal;
+}
+
+double Interneuron::getSignal(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _signalCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _signalCV))
     {
-        signal = 0;
+        return getCacheVariableValue(s, _signalCV);
     }
     
+    ++counter.numComputed;
+    double signal = computeSignal(s);
+    setCacheVariableValue(s, _signalCV, signal);
     return signal;
 }
 
+OutputCounter Interneuron::getSignalCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _signalCountCV);
+}
+
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int Interneuron::getSignalIndex(const std::string& outputName,
+                                const std::string& channelName) const
+{
+    return outputName == "signal" ? 0 : -1;
+}
+
+double Interneuron::getSignalValue(const SimTK::State& s, int index) const
+{
+    return getSignal(s);
+}
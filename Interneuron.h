@@ -28,6 +28,9 @@
 // INCLUDE
 //============================================================================
 #include "osimInterneuronDLL.h"
+#include "OutputCounter.h"
+#include "SignalSource.h"
+#include "WeightedSum.h"
 #include "OpenSim/Simulation/Control/Controller.h"
 #include "OpenSim/Simulation/Model/Muscle.h"
 #include "OpenSim/Simulation/Model/Model.h"
@@ -48,7 +51,7 @@ namespace OpenSim {
  * @author  Hjalti Hilmarsson
  */
 
-class OSIMINTERNEURON_API Interneuron : public ModelComponent {
+class OSIMINTERNEURON_API Interneuron : public ModelComponent, public SignalProvider {
 OpenSim_DECLARE_CONCRETE_OBJECT(Interneuron, ModelComponent);
 
 public:
@@ -69,6 +72,12 @@ public:
     
     OpenSim_DECLARE_LIST_PROPERTY(weights, double, "The weights given to the input signals, can not sum to more than 1 and are between 0 and 1, ");
     
+    OpenSim_DECLARE_PROPERTY(activation, std::string, "How the weighted sum is gated by the threshold: 'step' sends the sum above the threshold and 0 below it, 'logistic' scales the sum by a logistic function of its distance to the threshold and 'softplus' adds the threshold, scaled by a logistic function, to a softplus ramp of the sum above it. The smooth modes have no discontinuity for the integrator to reject steps at");
+    
+    OpenSim_DECLARE_PROPERTY(sharpness, double, "The slope (per unit of the weighted sum) of the smooth activation modes at the threshold; the larger it is the closer they come to the step");
+    
+    OpenSim_DECLARE_PROPERTY(localize_threshold, bool, "Whether the step activation adds an event witness, the weighted sum minus the threshold, so that the integrator stops exactly where the sum crosses the threshold and restarts there instead of rejecting steps across it");
+    
 //==============================================================================
 // SOCKETS
 //==============================================================================
@@ -103,6 +112,25 @@ public:
     
     void setThreshold(double threshold);
     double getThreshold() const;
+    
+    void setActivation(const std::string& activation);
+    const std::string& getActivation() const;
+    
+    void setSharpness(double sharpness);
+    double getSharpness() const;
+    
+    void setLocalizeThreshold(bool localizeThreshold);
+    bool getLocalizeThreshold() const;
+    
+    /** Set by an owner that computes the signal of this interneuron
+        elsewhere, as MuscleReflexCircuit does with a ReflexCircuitSet. An
+        idle interneuron adds no threshold witness to the system. */
+    void setIdle(bool idle);
+    bool isIdle() const;
+    
+    /** The signal sent for a weighted sum of the afferents, by the activation
+        mode, threshold and sharpness of this interneuron. */
+    double activate(double sum) const;
 
 //--------------------------------------------------------------------------
 // Interneuron STATE DEPENDENT ACCESSORS
@@ -111,6 +139,10 @@ public:
     Get quanitites of interest common to all spindles*/
     void setSignal(SimTK::State& s, double signal) const;
     double getSignal(const SimTK::State& s) const;
+    // How often signal was computed and read on the lineage of s
+    OutputCounter getSignalCounter(const SimTK::State& s) const;
+    // The weighted sum of the afferents before it is gated by the threshold
+    double getWeightedSum(const SimTK::State& s) const;
    
     
 //--------------------------------------------------------------------------
@@ -130,12 +162,49 @@ public:
 
      */
 
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
+
+
 private:
+    // Evaluate the outputs, called once per realization
+    double computeSignal(const SimTK::State& s) const;
     // Connect properties to local pointers.  */
     void constructProperties();
     // ModelComponent interface to connect this component to its model
     void extendConnectToModel(Model& aModel) override;
+    // Allocate the cached outputs and their counters
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
         void extendFinalizeFromProperties() override;
+    // Resolve the afferent channels once the model is connected
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    // Check the weights and pack them into the aligned buffer
+    void packWeights();
+    
+    // Gating of the weighted sum, parsed from the activation property
+    enum Activation {
+        Step,
+        Logistic,
+        Softplus
+    };
+    Activation _activation;
+    // Whether the owner reads the signal elsewhere
+    bool _idle;
+    
+    // The afferents and cache entries, resolved once rather than looked up
+    // by name on every evaluation
+    mutable std::vector<SignalSource> _afferents;
+    // The checked weights
+    WeightedSum _weightedSum;
+    mutable CacheVariable<double> _signalCV;
+    mutable CacheVariable<OutputCounter> _signalCountCV;
+    // The afferent values of the last evaluation, padded for _weightedSum
+    mutable CacheVariable<SimTK::Vector> _valuesCV;
 
 protected:
     
@@ -0,0 +1,398 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  InterneuronNetwork.cpp                      *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "InterneuronNetwork.h"
+#include <OpenSim/OpenSim.h>
+#include <algorithm>
+#include <fstream>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+InterneuronNetwork::InterneuronNetwork() :
+    _spiking(false)
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+InterneuronNetwork::InterneuronNetwork(const std::string& name,
+                                       const std::string& weightsFile) :
+    _spiking(false)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    
+    constructProperties();
+    set_weights_file(weightsFile);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+
+void InterneuronNetwork::constructProperties()
+{
+    constructProperty_weights_file("");
+    constructProperty_mode("rate");
+    constructProperty_membrane_time_constant(0.01);
+    constructProperty_refractory_period(0.002);
+    constructProperty_spike_delay(0.02);
+    constructProperty_trace_time_constant(0.05);
+    constructProperty_drive_update_interval(0.001);
+}
+
+void InterneuronNetwork::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+    
+    OPENSIM_THROW_IF_FRMOBJ(get_mode() != "rate" && get_mode() != "spiking", InvalidPropertyValue, getName(), "The mode must be 'rate' or 'spiking'");
+    OPENSIM_THROW_IF_FRMOBJ(get_membrane_time_constant() <= 0, InvalidPropertyValue, getName(), "The membrane time constant must be positive");
+    OPENSIM_THROW_IF_FRMOBJ(get_refractory_period() < 0, InvalidPropertyValue, getName(), "The refractory period cannot be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_spike_delay() < 0, InvalidPropertyValue, getName(), "The spike delay cannot be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_trace_time_constant() <= 0, InvalidPropertyValue, getName(), "The trace time constant must be positive");
+    OPENSIM_THROW_IF_FRMOBJ(get_drive_update_interval() <= 0, InvalidPropertyValue, getName(), "The drive update interval must be positive");
+    _spiking = get_mode() == "spiking";
+    OPENSIM_THROW_IF_FRMOBJ(_spiking && get_refractory_period() <= 0, InvalidPropertyValue, getName(), "The refractory period must be positive in the spiking mode");
+    
+    // the weights are read once per value of the property; copies and
+    // clones carry the matrix along instead of reading the file again
+    const std::string& fileName = get_weights_file();
+    if (fileName != _weightsFile)
+    {
+        _weights.clear();
+        _weightsFile.clear();
+        if (!fileName.empty())
+        {
+            const std::string path = resolveWeightsFile();
+            std::ifstream file(path.c_str());
+            OPENSIM_THROW_IF_FRMOBJ(!file, InvalidPropertyValue, getName(), "Cannot open the weights file '" + path + "'");
+            
+            std::string message;
+            OPENSIM_THROW_IF_FRMOBJ(!_weights.read(file, message), InvalidPropertyValue, getName(), "In the weights file '" + path + "', " + message);
+        }
+        _weightsFile = fileName;
+    }
+    
+    updOutput("signal").clearChannels();
+    for (int i = 0; i < _weights.getNumNeurons(); ++i)
+    {
+        // a spiking neuron at rest is above a threshold of 0 or less
+        OPENSIM_THROW_IF_FRMOBJ(_spiking && _weights.getThreshold(i) <= 0, InvalidPropertyValue, getName(), "The threshold of neuron '" + _weights.getNeuronName(i) + "' must be positive in the spiking mode");
+        updOutput("signal").addChannel(_weights.getNeuronName(i));
+    }
+}
+
+std::string InterneuronNetwork::resolveWeightsFile() const
+{
+    // the document of the model this network was read with, if any
+    const Component* root = this;
+    while (root->hasOwner())
+    {
+        root = &root->getOwner();
+    }
+    const std::string directory =
+        IO::getParentDirectory(root->getDocumentFileName());
+    if (directory.empty())
+    {
+        return get_weights_file();
+    }
+    
+    return SimTK::Pathname::getAbsolutePathnameUsingSpecifiedWorkingDirectory(
+        directory, get_weights_file());
+}
+
+//=============================================================================
+// DRIVE UPDATE EVENT
+//=============================================================================
+
+namespace {
+    
+    // Brings the spiking layer up to date and sets its drives at its next
+    // spike or delivery, or once the drive update interval has passed since
+    // the last update, whichever comes first. Every delivery thus reaches
+    // the output at its own time, while the drives are sampled at least once
+    // per interval.
+    class SpikeUpdate : public SimTK::ScheduledEventHandler {
+    public:
+        SpikeUpdate(const InterneuronNetwork& network, double interval) :
+            _network(network),
+            _interval(interval)
+        {
+        }
+        
+        SimTK::Real getNextEventTime(const SimTK::State& s,
+                                     bool includeCurrentTime) const override
+        {
+            const SpikeScheduler& scheduler = _network.getSpikeScheduler(s);
+            return std::min(scheduler.getTime() + _interval,
+                            scheduler.getNextEventTime());
+        }
+        
+        void handleEvent(SimTK::State& s, SimTK::Real accuracy,
+                         bool& shouldTerminate) const override
+        {
+            shouldTerminate = false;
+            _network.updateSpikes(s);
+        }
+        
+    private:
+        const InterneuronNetwork& _network;
+        double _interval;
+    };
+    
+}
+
+void InterneuronNetwork::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    _signalsCV = addCacheVariable("signals",
+        SimTK::Vector(getNumNeurons(), 0.0), SimTK::Stage::Velocity);
+    // scratch space in the State, so that States of one model can be
+    // realized on several threads
+    const int numAfferents = (int)getInput<double>("afferents").getNumConnectees();
+    _afferentValuesCV = addCacheVariable("afferent_values",
+        SimTK::Vector(numAfferents, 0.0), SimTK::Stage::Topology);
+    
+    if (_spiking)
+    {
+        _drivesCV = addCacheVariable("drives",
+            SimTK::Vector(getNumNeurons(), 0.0), SimTK::Stage::Topology);
+        system.addEventHandler(new SpikeUpdate(*this, get_drive_update_interval()));
+    }
+}
+
+void InterneuronNetwork::extendInitStateFromProperties(SimTK::State& s) const
+{
+    Super::extendInitStateFromProperties(s);
+    
+    if (_spiking)
+    {
+        std::vector<double> thresholds(getNumNeurons());
+        for (int i = 0; i < getNumNeurons(); ++i)
+        {
+            thresholds[i] = _weights.getThreshold(i);
+        }
+        
+        updSpikeScheduler(s).reset(thresholds, s.getTime(),
+            get_membrane_time_constant(), get_refractory_period(),
+            get_spike_delay(), get_trace_time_constant());
+    }
+}
+
+void InterneuronNetwork::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    const Input<double>& afferents = getInput<double>("afferents");
+    OPENSIM_THROW_IF_FRMOBJ(_weights.getNumAfferents() > (int)afferents.getNumConnectees(), InvalidPropertyValue, getName(), "The weights reach afferent " + std::to_string(_weights.getNumAfferents() - 1) + " but only " + std::to_string(afferents.getNumConnectees()) + " afferents are connected");
+    
+    _afferents.resize(afferents.getNumConnectees());
+    for (int i = 0; i < (int)_afferents.size(); ++i)
+    {
+        _afferents[i].bind(afferents.getChannel(i));
+    }
+    
+    if (_spiking)
+    {
+        // changed only by the drive update events, which invalidate the
+        // signals
+        const SimTK::Subsystem& subsys = getSystem().getDefaultSubsystem();
+        _schedulerIndex = subsys.allocateDiscreteVariable(s,
+            SimTK::Stage::Velocity, new SimTK::Value<SpikeScheduler>());
+    }
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+void InterneuronNetwork::setWeightsFile(const std::string& weightsFile)
+{
+    set_weights_file(weightsFile);
+}
+const std::string& InterneuronNetwork::getWeightsFile() const
+{
+    return get_weights_file();
+}
+
+const SparseWeights& InterneuronNetwork::getWeights() const
+{
+    return _weights;
+}
+
+int InterneuronNetwork::getNumNeurons() const
+{
+    return _weights.getNumNeurons();
+}
+
+int InterneuronNetwork::getNeuronIndex(const std::string& name) const
+{
+    return _weights.getNeuronIndex(name);
+}
+
+//=============================================================================
+// SIGNALS
+//=============================================================================
+//_____________________________________________________________________________
+/**
+ * Compute the signals of all neurons in one sparse product
+ *
+ * @param s         current state of the system
+ */
+
+const SimTK::Vector& InterneuronNetwork::getSignals(const SimTK::State& s) const
+{
+    if (isCacheVariableValid(s, _signalsCV))
+    {
+        return getCacheVariableValue(s, _signalsCV);
+    }
+    
+    SimTK::Vector& signals = updCacheVariableValue(s, _signalsCV);
+    const int n = getNumNeurons();
+    if (n > 0 && _spiking)
+    {
+        // the spike traces, up to date as of the last drive update
+        const SpikeScheduler& scheduler = getSpikeScheduler(s);
+        double time = std::max(s.getTime(), scheduler.getTime());
+        for (int i = 0; i < n; ++i)
+        {
+            signals[i] = scheduler.getTrace(i, time);
+        }
+    }
+    else if (n > 0)
+    {
+        double* signal = &signals[0];
+        computeWeightedSums(s, signal);
+        
+        // the weighted sum when it exceeds the threshold
+        for (int i = 0; i < n; ++i)
+        {
+            double threshold = _weights.getThreshold(i);
+            signal[i] = signal[i] > threshold ? signal[i] : 0.0;
+        }
+    }
+    markCacheVariableValid(s, _signalsCV);
+    
+    return signals;
+}
+
+void InterneuronNetwork::computeWeightedSums(const SimTK::State& s,
+                                             double* sums) const
+{
+    // read every afferent once, the only calls into other components
+    double* values = updCacheVariableValue(s, _afferentValuesCV).updContiguousScalarData();
+    for (int i = 0; i < (int)_afferents.size(); ++i)
+    {
+        values[i] = _afferents[i].getValue(s);
+    }
+    
+    _weights.multiply(values, sums);
+}
+
+double InterneuronNetwork::getSignal(const SimTK::State& s,
+                                     const std::string& name) const
+{
+    int index = getNeuronIndex(name);
+    OPENSIM_THROW_IF_FRMOBJ(index < 0, Exception, "No neuron '" + name + "' in the network");
+    return getSignals(s)[index];
+}
+
+double InterneuronNetwork::getNeuronSignal(const SimTK::State& s, int index) const
+{
+    return getSignals(s)[index];
+}
+
+//=============================================================================
+// SPIKES
+//=============================================================================
+
+const SpikeScheduler& InterneuronNetwork::getSpikeScheduler(const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    return SimTK::Value<SpikeScheduler>::downcast(
+        s.getDiscreteVariable(subsys, _schedulerIndex)).get();
+}
+
+SpikeScheduler& InterneuronNetwork::updSpikeScheduler(SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+    return SimTK::Value<SpikeScheduler>::updDowncast(
+        s.updDiscreteVariable(subsys, _schedulerIndex)).upd();
+}
+
+void InterneuronNetwork::updateSpikes(SimTK::State& s) const
+{
+    // the drives read the afferents before the layer is touched, since
+    // changing it invalidates the Velocity stage
+    getSystem().realize(s, SimTK::Stage::Velocity);
+    double* drives = updCacheVariableValue(s, _drivesCV).updContiguousScalarData();
+    if (getNumNeurons() > 0)
+    {
+        computeWeightedSums(s, drives);
+    }
+    
+    SpikeScheduler& scheduler = updSpikeScheduler(s);
+    scheduler.advanceTo(s.getTime());
+    for (int i = 0; i < getNumNeurons(); ++i)
+    {
+        scheduler.setDrive(i, drives[i]);
+    }
+    // a new drive may fire a membrane left at its threshold right away, so
+    // that the next event of the layer is always after the time of s
+    scheduler.advanceTo(s.getTime());
+}
+
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int InterneuronNetwork::getSignalIndex(const std::string& outputName,
+                                       const std::string& channelName) const
+{
+    return outputName == "signal" ? getNeuronIndex(channelName) : -1;
+}
+
+double InterneuronNetwork::getSignalValue(const SimTK::State& s, int index) const
+{
+    return getNeuronSignal(s, index);
+}
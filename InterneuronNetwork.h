@@ -0,0 +1,203 @@
+#ifndef OPENSIM_InterneuronNetwork_H_
+#define OPENSIM_InterneuronNetwork_H_
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim: InterneuronNetwork.h                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimInterneuronDLL.h"
+#include "SignalSource.h"
+#include "SparseWeights.h"
+#include "SpikeScheduler.h"
+#include "OpenSim/Simulation/Model/Model.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * InterneuronNetwork is a layer of interneurons that share all afferents of
+ * a model. Each neuron sums the afferents through its row of a sparse weight
+ * matrix and sends the sum when it exceeds its threshold, like an
+ * Interneuron with the step activation. Negative weights inhibit, so one
+ * network can couple the motor pools of agonists and antagonists
+ * (reciprocal inhibition) or of muscles across joints.
+ *
+ * The afferents are connected to the afferents list input; their order is
+ * the column order of the matrix. The matrix is read from weights_file, in
+ * the format of SparseWeights, when the properties are finalized, and every
+ * neuron is published as a channel of the signal list output named after
+ * it, e.g. a Delay can connect to "network|signal:flexor_pool".
+ *
+ * Once per realization the network reads every afferent once, takes one
+ * sparse matrix-vector product over the non-zero weights and applies the
+ * thresholds. The signals of all neurons are cached together.
+ *
+ * In the 'spiking' mode the weighted sums instead drive a layer of leaky
+ * integrate-and-fire neurons run by a SpikeScheduler, which is kept in the
+ * State. A scheduled event at the next spike or delivery of the layer, or
+ * drive_update_interval after the last update if that comes first, reads
+ * the afferents, processes the spikes and deliveries that fell due at their
+ * exact times and sets the new drives. The drives are therefore held for at
+ * most drive_update_interval, and every delivery reaches the output at its
+ * own time. Nothing is evaluated per neuron at the integrator stages in
+ * between; the signal of a neuron is its spike trace, in spikes per second,
+ * decaying in closed form from the last delivery. The thresholds and the
+ * refractory period must be positive in this mode.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMINTERNEURON_API InterneuronNetwork : public ModelComponent, public SignalProvider {
+OpenSim_DECLARE_CONCRETE_OBJECT(InterneuronNetwork, ModelComponent);
+
+public:
+//=============================================================================
+// INPUT
+//=============================================================================
+    OpenSim_DECLARE_LIST_INPUT(afferents, double, SimTK::Stage::Velocity,
+        "The afferent signals of the network, in the column order of the weight matrix");
+
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(weights_file, std::string, "File of the sparse weight matrix, relative to the directory of the model file, or to the working directory if the model was not read from a file. One line per neuron: its name, its threshold and afferent:weight pairs, afferent being the index of the afferent in the afferents input");
+    
+    OpenSim_DECLARE_PROPERTY(mode, std::string, "How the neurons respond to their weighted sums: 'rate' sends the sum above the threshold, 'spiking' drives leaky integrate-and-fire neurons with it and sends their spike rate");
+    
+    OpenSim_DECLARE_PROPERTY(membrane_time_constant, double, "Time constant (seconds) of the membrane of the spiking neurons");
+    
+    OpenSim_DECLARE_PROPERTY(refractory_period, double, "Time (seconds) a spiking neuron is held at rest after it fires, positive in the spiking mode");
+    
+    OpenSim_DECLARE_PROPERTY(spike_delay, double, "Time (seconds) from a spike to its delivery to the output of the neuron");
+    
+    OpenSim_DECLARE_PROPERTY(trace_time_constant, double, "Time constant (seconds) of the decay of the spike trace that is sent as the signal of a spiking neuron");
+    
+    OpenSim_DECLARE_PROPERTY(drive_update_interval, double, "Longest time (seconds) the drives of the spiking neurons are held before they are updated. Spikes and deliveries are processed at their own times");
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    OpenSim_DECLARE_LIST_OUTPUT(signal, double, getSignal, SimTK::Stage::Velocity);
+    //
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    InterneuronNetwork();
+    InterneuronNetwork(const std::string& name,
+                       const std::string& weightsFile);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+//--------------------------------------------------------------------------
+// InterneuronNetwork PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    void setWeightsFile(const std::string& weightsFile);
+    const std::string& getWeightsFile() const;
+
+    /** The weight matrix read from weights_file. */
+    const SparseWeights& getWeights() const;
+
+    int getNumNeurons() const;
+    /** Index of the neuron called name, or -1. */
+    int getNeuronIndex(const std::string& name) const;
+
+//--------------------------------------------------------------------------
+// InterneuronNetwork STATE DEPENDENT ACCESSORS
+//--------------------------------------------------------------------------
+    /** The signals of all neurons, in row order. */
+    const SimTK::Vector& getSignals(const SimTK::State& s) const;
+
+    double getSignal(const SimTK::State& s, const std::string& name) const;
+    /** Signal of the neuron at index, without the lookup by name. */
+    double getNeuronSignal(const SimTK::State& s, int index) const;
+    
+    /** The spiking layer of s, in the spiking mode. */
+    const SpikeScheduler& getSpikeScheduler(const SimTK::State& s) const;
+    /** Process the spikes of the spiking layer up to the time of s and
+        drive it with the weighted sums of the afferents in s. */
+    void updateSpikes(SimTK::State& s) const;
+
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
+
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // Read the weights and add a signal channel per neuron
+    void extendFinalizeFromProperties() override;
+    // weights_file, relative to the directory of the model document
+    std::string resolveWeightsFile() const;
+    // Allocate the cache of neuron signals
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Start the spiking layer at rest at the time of s
+    void extendInitStateFromProperties(SimTK::State& s) const override;
+    // Resolve the afferent channels once the model is connected
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    // The weighted sums of the afferents of s, into sums
+    void computeWeightedSums(const SimTK::State& s, double* sums) const;
+    // The spiking layer of s, for writing
+    SpikeScheduler& updSpikeScheduler(SimTK::State& s) const;
+
+    SparseWeights _weights;
+    // The weights_file the weights were read from
+    std::string _weightsFile;
+    // The mode, parsed from the mode property
+    bool _spiking;
+    
+    // Discrete variable holding the SpikeScheduler in the spiking mode
+    mutable SimTK::DiscreteVariableIndex _schedulerIndex;
+    // The drives of the last update, scratch space of each State
+    mutable CacheVariable<SimTK::Vector> _drivesCV;
+
+    // The afferents, resolved once, and the values of the last evaluation
+    mutable std::vector<SignalSource> _afferents;
+    mutable CacheVariable<SimTK::Vector> _afferentValuesCV;
+    mutable CacheVariable<SimTK::Vector> _signalsCV;
+
+protected:
+
+
+    //=========================================================================
+};  // END of class InterneuronNetwork
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_InterneuronNetwork_H_
@@ -27,6 +27,7 @@
 // INCLUDES
 //=============================================================================
 #include "MuscleReflexCircuit.h"
+#include "ReflexCircuitSet.h"
 #include <OpenSim/OpenSim.h>
 
 
@@ -42,7 +43,9 @@ using namespace SimTK;
 //=============================================================================
 //_____________________________________________________________________________
 /* Default constructor. */
-MuscleReflexCircuit::MuscleReflexCircuit()
+MuscleReflexCircuit::MuscleReflexCircuit() :
+    _delayBankChannel(-1),
+    _circuitSetIndex(-1)
 {
     constructProperties();
 }
@@ -54,7 +57,9 @@ MuscleReflexCircuit::MuscleReflexCircuit(const std::string& name,
                                          const GolgiTendon& golgi,
                                          double threshold,
                                          double timeDelay,
-                                         double defaultControlSignal)
+                                         double defaultControlSignal) :
+    _delayBankChannel(-1),
+    _circuitSetIndex(-1)
 {
     OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
        
@@ -95,6 +100,16 @@ void MuscleReflexCircuit::constructProperties()
     constructProperty_timeDelay(0.1);
     constructProperty_threshold(0.5);
     constructProperty_weights();
+    
+    Delay delay;
+    delay.setName("delay");
+    constructProperty_Delay(delay);
+    constructProperty_delay_bank("");
+    constructProperty_circuit_set("");
+    
+    Interneuron interneuron;
+    interneuron.setName("interneuron");
+    constructProperty_Interneuron(interneuron);
 }
 
 
@@ -104,20 +119,102 @@ void MuscleReflexCircuit::extendConnectToModel(Model& model)
     
     // connect inputs to outputs here
     
-    const SimpleSpindle spindle = getSpindle();
-    const GolgiTendon golgi = getGolgi();
+    const SimpleSpindle& spindle = getSpindle();
+    const GolgiTendon& golgi = getGolgi();
      
     Interneuron& interneuron = updInterneuron();
     Delay& delay = updDelay();
     
-    // connect the interneuron inputs to the spindle and golgi outputs
+    // connect the interneuron inputs to the spindle and golgi outputs,
+    // dropping the connections of any earlier call
+    interneuron.updInput("afferents").disconnect();
     interneuron.updInput("afferents").connect(spindle.getOutput("spindle_length"));
     interneuron.updInput("afferents").connect(spindle.getOutput("spindle_speed"));
     interneuron.updInput("afferents").connect(golgi.getOutput("golgiLength"));
     
-    // Connect the delay component input to the interneuron output
-    delay.updInput("signal").connect(interneuron.getOutput("signal"));
+    delay.connectSocket_muscle(getMuscle());
+    
+    // the interneuron signal comes from the circuit set when there is one,
+    // and the Interneuron component is left idle
+    _circuitSet.reset();
+    _circuitSetIndex = -1;
+    if (!get_circuit_set().empty())
+    {
+        ReflexCircuitSet& set = model.updComponent<ReflexCircuitSet>(get_circuit_set());
+        _circuitSetIndex = set.addCircuit(*this);
+        _circuitSet.reset(&set);
+    }
+    interneuron.setIdle(!_circuitSet.empty());
+    
+    if (get_delay_bank().empty())
+    {
+        // Connect the delay component input to the interneuron output
+        if (!_circuitSet.empty())
+        {
+            delay.updInput("signal").connect(
+                _circuitSet->getOutput("signal").getChannel(getName()));
+        }
+        else
+        {
+            delay.updInput("signal").connect(interneuron.getOutput("signal"));
+        }
+        _delayBank.reset();
+        _delayBankChannel = -1;
+    }
+    else
+    {
+        // the bank delays the interneuron output and the delay component
+        // is left idle
+        delay.updInput("signal").disconnect();
+        DelayBank& bank = model.updComponent<DelayBank>(get_delay_bank());
+        if (!_circuitSet.empty())
+        {
+            _delayBankChannel = bank.addChannel(getName(),
+                _circuitSet->getOutput("signal").getChannel(getName()),
+                get_timeDelay(), get_defaultControlSignal());
+        }
+        else
+        {
+            _delayBankChannel = bank.addChannel(getName(),
+                interneuron.getOutput("signal"), get_timeDelay(),
+                get_defaultControlSignal());
+        }
+        _delayBank.reset(&bank);
+    }
+
+}
+
+void MuscleReflexCircuit::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    // outputs are computed once per realization and counted
+    _signalCV = addCacheVariable("signal", 0.0, SimTK::Stage::Velocity);
+    _signalCountCV = addCacheVariable("signal_count", OutputCounter(), SimTK::Stage::Topology);
+}
 
+void MuscleReflexCircuit::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    _spindle.reset(&getSpindle());
+    _golgi.reset(&getGolgi());
+    
+    // the batch of the set replaces the sensors and the interneuron, and the
+    // bank replaces the delay
+    _schedule.clear();
+    if (_circuitSet.empty())
+    {
+        _schedule.push_back(SpindleLengthStep);
+        _schedule.push_back(SpindleSpeedStep);
+        _schedule.push_back(TendonLengthStep);
+        _schedule.push_back(InterneuronStep);
+    }
+    else
+    {
+        _schedule.push_back(CircuitSetStep);
+    }
+    _schedule.push_back(_delayBank.empty() ? DelayStep : DelayBankStep);
 }
 
 void MuscleReflexCircuit::extendFinalizeFromProperties()
@@ -170,6 +267,24 @@ const Interneuron& MuscleReflexCircuit::getInterneuron() const
 {
     return get_Interneuron();
 }
+
+void MuscleReflexCircuit::setDelayBank(const std::string& delayBankPath)
+{
+    set_delay_bank(delayBankPath);
+}
+const std::string& MuscleReflexCircuit::getDelayBank() const
+{
+    return get_delay_bank();
+}
+
+void MuscleReflexCircuit::setCircuitSet(const std::string& circuitSetPath)
+{
+    set_circuit_set(circuitSetPath);
+}
+const std::string& MuscleReflexCircuit::getCircuitSet() const
+{
+    return get_circuit_set();
+}
 //-----------------------------------------------------------------------------
 // SOCKETS
 //-----------------------------------------------------------------------------
@@ -200,17 +315,63 @@ const GolgiTendon& MuscleReflexCircuit::getGolgi() const
  * @param s         current state of the system
  */
 
-double MuscleReflexCircuit::getMuscleSignal(const SimTK::State &s) const
+double MuscleReflexCircuit::computeMuscleSignal(const SimTK::State& s) const
 {
     double muscle_signal = 0;
-     
-    const Delay delay = getDelay();
     
-    muscle_signal = delay.getSignal(s);
+    // the last step of the schedule is the delayed signal
+    for (ScheduleStep step : _schedule)
+    {
+        switch (step)
+        {
+            case SpindleLengthStep:
+                muscle_signal = _spindle->getSpindleLength(s);
+                break;
+            case SpindleSpeedStep:
+                muscle_signal = _spindle->getSpindleSpeed(s);
+                break;
+            case TendonLengthStep:
+                muscle_signal = _golgi->getTendonLength(s);
+                break;
+            case InterneuronStep:
+                muscle_signal = get_Interneuron().getSignal(s);
+                break;
+            case CircuitSetStep:
+                muscle_signal = _circuitSet->getCircuitSignal(s, _circuitSetIndex);
+                break;
+            case DelayStep:
+                muscle_signal = get_Delay().getSignal(s);
+                break;
+            case DelayBankStep:
+                muscle_signal = _delayBank->getChannelSignal(s, _delayBankChannel);
+                break;
+        }
+    }
     
     return muscle_signal;
 
 }
 
+double MuscleReflexCircuit::getMuscleSignal(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _signalCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _signalCV))
+    {
+        return getCacheVariableValue(s, _signalCV);
+    }
+    
+    ++counter.numComputed;
+    double muscle_signal = computeMuscleSignal(s);
+    setCacheVariableValue(s, _signalCV, muscle_signal);
+    return muscle_signal;
+}
+
+OutputCounter MuscleReflexCircuit::getMuscleSignalCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _signalCountCV);
+}
+
 
 
@@ -28,16 +28,19 @@
 // INCLUDE
 //============================================================================
 #include "osimMuscleReflexCircuitDLL.h"
+#include "OutputCounter.h"
 #include "OpenSim/Simulation/Model/Muscle.h"
 #include "OpenSim/Simulation/Model/Model.h"
 #include "OpenSim/Simulation/Model/ModelComponent.h"
 #include "SimpleSpindle.h"
 #include "GolgiTendon.h"
 #include "Delay.h"
+#include "DelayBank.h"
 #include "Interneuron.h"
 
 namespace OpenSim {
 
+class ReflexCircuitSet;
 
 
 //=============================================================================
@@ -72,6 +75,10 @@ public:
     
     OpenSim_DECLARE_UNNAMED_PROPERTY(Delay, "The delay component that will delay the muscle signal");
     
+    OpenSim_DECLARE_PROPERTY(delay_bank, std::string, "Path to a DelayBank of the model that delays the muscle signal in place of the Delay component. Empty to use the Delay component");
+    
+    OpenSim_DECLARE_PROPERTY(circuit_set, std::string, "Path to a ReflexCircuitSet of the model that evaluates the sensors and interneuron of this circuit in a batch. Empty to use the Interneuron component");
+    
     OpenSim_DECLARE_UNNAMED_PROPERTY(Interneuron, "The interneuron component that takes in mucle sensor signals and sends an ouput signal if the muscle activation is large enough");
     
     /*
@@ -124,6 +131,12 @@ public:
     Interneuron& updInterneuron();
     const Interneuron& getInterneuron() const;
     
+    void setDelayBank(const std::string& delayBankPath);
+    const std::string& getDelayBank() const;
+    
+    void setCircuitSet(const std::string& circuitSetPath);
+    const std::string& getCircuitSet() const;
+    
     
 //--------------------------------------------------------------------------
 // Muscle Reflex Circuit Socket getters and setters
@@ -158,15 +171,49 @@ public:
     
     void setMuscleSignal(SimTK::State& s, double muscle_signal) const;
     double getMuscleSignal(const SimTK::State& s) const;
+    // How often muscle_signal was computed and read on the lineage of s
+    OutputCounter getMuscleSignalCounter(const SimTK::State& s) const;
     
 
 private:
+    // Evaluate the outputs, called once per realization
+    double computeMuscleSignal(const SimTK::State& s) const;
     // Connect properties to local pointers.  */
     void constructProperties();
     // ModelComponent interface to connect this component to its model
     void extendConnectToModel(Model& aModel) override;
+    // Allocate the cached outputs and their counters
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
     
     void extendFinalizeFromProperties() override;
+    // Compile the wiring of the circuit into the evaluation schedule
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    // The shared bank and the channel of this circuit when delay_bank is set
+    SimTK::ReferencePtr<const DelayBank> _delayBank;
+    int _delayBankChannel;
+    // The batch and the index of this circuit in it when circuit_set is set
+    SimTK::ReferencePtr<const ReflexCircuitSet> _circuitSet;
+    int _circuitSetIndex;
+    
+    // Evaluations of the circuit in topological order, sensors first. Each
+    // step finds its inputs cached by the steps before it, so running the
+    // schedule never recurses through inputs or looks anything up by name.
+    enum ScheduleStep {
+        SpindleLengthStep,
+        SpindleSpeedStep,
+        TendonLengthStep,
+        InterneuronStep,
+        CircuitSetStep,
+        DelayStep,
+        DelayBankStep
+    };
+    mutable std::vector<ScheduleStep> _schedule;
+    mutable SimTK::ReferencePtr<const SimpleSpindle> _spindle;
+    mutable SimTK::ReferencePtr<const GolgiTendon> _golgi;
+    
+    mutable CacheVariable<double> _signalCV;
+    mutable CacheVariable<OutputCounter> _signalCountCV;
     /*
     Set<const Interneuron> _interneuronSet;
     Set<const Delay> _delaySet;
@@ -0,0 +1,219 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  MuscleSensorBlock.cpp                       *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "MuscleSensorBlock.h"
+#include <OpenSim/OpenSim.h>
+#include <cmath>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+MuscleSensorBlock::MuscleSensorBlock() :
+    _constants{1, 1, 1}
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+MuscleSensorBlock::MuscleSensorBlock(const std::string& name,
+                                     const Muscle& muscle,
+                                     double restLength) :
+    _constants{1, 1, 1}
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    connectSocket_muscle(muscle);
+    
+    constructProperties();
+    set_normalized_rest_length(restLength);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+
+void MuscleSensorBlock::constructProperties()
+{
+    constructProperty_normalized_rest_length(1.0);
+}
+
+void MuscleSensorBlock::extendConnectToModel(Model &model)
+{
+    Super::extendConnectToModel(model);
+    
+    _muscle.reset(&getMuscle());
+}
+
+void MuscleSensorBlock::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    // the outputs of each stage are computed together once per realization
+    _lengthsCV = addCacheVariable("lengths", SimTK::Vec2(0), SimTK::Stage::Position);
+    _speedCV = addCacheVariable("speed", 0.0, SimTK::Stage::Velocity);
+}
+
+void MuscleSensorBlock::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    _constants = readConstants();
+}
+
+MuscleSensorBlock::MuscleConstants MuscleSensorBlock::readConstants() const
+{
+    const Muscle& muscle = *_muscle;
+    MuscleConstants constants;
+    constants.optimalFiberLength = muscle.getOptimalFiberLength();
+    constants.maxSpeed = muscle.getOptimalFiberLength()*muscle.getMaxContractionVelocity();
+    constants.tendonSlackLength = muscle.getTendonSlackLength();
+    return constants;
+}
+
+MuscleSensorBlock::MuscleConstants MuscleSensorBlock::getConstants() const
+{
+    // an edited muscle reads its new properties until the model is
+    // finalized again, and so does the block; the snapshot is left alone
+    // so that States can be realized on several threads
+    if (!_muscle->isObjectUpToDateWithProperties())
+    {
+        return readConstants();
+    }
+    return _constants;
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+double MuscleSensorBlock::getNormalizedRestLength() const
+{
+    return get_normalized_rest_length();
+}
+void MuscleSensorBlock::setNormalizedRestLength(double normalizedRestLength)
+{
+    set_normalized_rest_length(normalizedRestLength);
+}
+
+const Muscle& MuscleSensorBlock::getMuscle() const
+{
+    return getSocket<Muscle>("muscle").getConnectee();
+}
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+
+const SimTK::Vec2& MuscleSensorBlock::getLengths(const SimTK::State& s) const
+{
+    if (isCacheVariableValid(s, _lengthsCV))
+    {
+        return getCacheVariableValue(s, _lengthsCV);
+    }
+    
+    const MuscleConstants constants = getConstants();
+    const Muscle& muscle = *_muscle;
+    
+    // the spindle monitors the stretch of the muscle beyond its rest
+    // length, the Golgi tendon the stretch of the tendon beyond its slack
+    // length, both normalized
+    double stretch = muscle.getLength(s) - get_normalized_rest_length()*constants.optimalFiberLength;
+    double tendonStretch = muscle.getTendonLength(s) - constants.tendonSlackLength;
+    
+    SimTK::Vec2& lengths = updCacheVariableValue(s, _lengthsCV);
+    lengths[0] = 0.5*(std::fabs(stretch) + stretch)/constants.optimalFiberLength;
+    lengths[1] = 0.5*(std::fabs(tendonStretch) + tendonStretch)/constants.tendonSlackLength;
+    markCacheVariableValid(s, _lengthsCV);
+    
+    return lengths;
+}
+
+double MuscleSensorBlock::getSpindleLength(const SimTK::State& s) const
+{
+    return getLengths(s)[0];
+}
+
+double MuscleSensorBlock::getTendonLength(const SimTK::State& s) const
+{
+    return getLengths(s)[1];
+}
+
+double MuscleSensorBlock::getSpindleSpeed(const SimTK::State& s) const
+{
+    if (isCacheVariableValid(s, _speedCV))
+    {
+        return getCacheVariableValue(s, _speedCV);
+    }
+    
+    const double maxSpeed = getConstants().maxSpeed;
+    double speed = _muscle->getLengtheningSpeed(s);
+    double spindleSpeed = 0.5*(std::fabs(speed) + speed)/maxSpeed;
+    setCacheVariableValue(s, _speedCV, spindleSpeed);
+    
+    return spindleSpeed;
+}
+
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int MuscleSensorBlock::getSignalIndex(const std::string& outputName,
+                                      const std::string& channelName) const
+{
+    if (outputName == "spindle_length")
+        return 0;
+    if (outputName == "spindle_speed")
+        return 1;
+    if (outputName == "golgiLength")
+        return 2;
+    return -1;
+}
+
+double MuscleSensorBlock::getSignalValue(const SimTK::State& s, int index) const
+{
+    switch (index)
+    {
+        case 0:
+            return getSpindleLength(s);
+        case 1:
+            return getSpindleSpeed(s);
+        default:
+            return getTendonLength(s);
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef OPENSIM_MuscleSensorBlock_H_
+#define OPENSIM_MuscleSensorBlock_H_
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim: MuscleSensorBlock.h                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimSimpleSpindleDLL.h"
+#include "SignalSource.h"
+#include "OpenSim/Simulation/Model/Muscle.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * MuscleSensorBlock is a SimpleSpindle and a GolgiTendon on one muscle in a
+ * single component. It publishes the same outputs, spindle_length,
+ * spindle_speed and golgiLength, with the same values and stages, so that
+ * it can replace the pair wherever their outputs are connected.
+ *
+ * The pair resolves the muscle and reads its optimal fiber length, maximum
+ * contraction velocity and tendon slack length on every evaluation, each
+ * through its own output and cache entry. The block snapshots those
+ * constants when the system is built and reads them again only when the
+ * muscle's properties have changed since. At the Position stage it reads the
+ * path length and tendon length once and caches spindle_length and
+ * golgiLength together; at the Velocity stage it reads the lengthening speed
+ * of the path once for spindle_speed.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMSIMPLESPINDLE_API MuscleSensorBlock : public ModelComponent, public SignalProvider {
+OpenSim_DECLARE_CONCRETE_OBJECT(MuscleSensorBlock, ModelComponent);
+
+public:
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(normalized_rest_length, double,
+        "The intended rest length of the spindle");
+
+//==============================================================================
+// SOCKETS
+//==============================================================================
+    OpenSim_DECLARE_SOCKET(muscle, Muscle, "The muscle that the spindle and Golgi tendon measure");
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    OpenSim_DECLARE_OUTPUT(spindle_length, double, getSpindleLength, SimTK::Stage::Position);
+    OpenSim_DECLARE_OUTPUT(spindle_speed, double, getSpindleSpeed, SimTK::Stage::Velocity);
+    OpenSim_DECLARE_OUTPUT(golgiLength, double, getTendonLength, SimTK::Stage::Position);
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    MuscleSensorBlock();
+    MuscleSensorBlock(const std::string& name,
+                      const Muscle& muscle,
+                      double restLength);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+//--------------------------------------------------------------------------
+// SENSOR PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    double getNormalizedRestLength() const;
+    void setNormalizedRestLength(double normalizedRestLength);
+
+    // The muscle that is measured
+    const Muscle& getMuscle() const;
+
+//--------------------------------------------------------------------------
+// SENSOR STATE DEPENDENT ACCESSORS
+//--------------------------------------------------------------------------
+    double getSpindleLength(const SimTK::State& s) const;
+    double getSpindleSpeed(const SimTK::State& s) const;
+    double getTendonLength(const SimTK::State& s) const;
+
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
+
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // ModelComponent interface to connect this component to its model
+    void extendConnectToModel(Model& aModel) override;
+    // Allocate the cached outputs
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Snapshot the constants of the muscle
+    void extendRealizeTopology(SimTK::State& s) const override;
+
+    // Constants of the muscle
+    struct MuscleConstants {
+        double optimalFiberLength;
+        double maxSpeed;
+        double tendonSlackLength;
+    };
+    // Read the constants of the muscle
+    MuscleConstants readConstants() const;
+    // The snapshot, or the constants read again if the properties of the
+    // muscle changed since; the snapshot is never written while realizing
+    MuscleConstants getConstants() const;
+    // The spindle and Golgi lengths, computed together once per realization
+    const SimTK::Vec2& getLengths(const SimTK::State& s) const;
+
+    SimTK::ReferencePtr<const Muscle> _muscle;
+
+    // Snapshot of the constants of the muscle
+    mutable MuscleConstants _constants;
+
+    mutable CacheVariable<SimTK::Vec2> _lengthsCV;
+    mutable CacheVariable<double> _speedCV;
+
+protected:
+
+
+    //=========================================================================
+};  // END of class MuscleSensorBlock
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_MuscleSensorBlock_H_
@@ -0,0 +1,70 @@
+#ifndef OPENSIM_OutputCounter_H_
+#define OPENSIM_OutputCounter_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: OutputCounter.h                              *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include <ostream>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * OutputCounter records how often an output of a reflex component was read
+ * and how often it actually had to be computed. The components cache each
+ * output once per realization, so the difference is the work saved for
+ * reporters, analyses and controllers reading the same output.
+ *
+ * The counter lives in a cache variable of the State next to the cached
+ * output, so it follows the State through the integration and can be read
+ * from the final State of a run.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+struct OutputCounter {
+    OutputCounter() : numComputed(0), numRead(0) {}
+
+    long long numComputed;
+    long long numRead;
+};
+
+// Needed to store an OutputCounter in a SimTK::Value
+inline std::ostream& operator<<(std::ostream& out,
+                                const OutputCounter& counter)
+{
+    return out << "OutputCounter(computed=" << counter.numComputed
+               << ", read=" << counter.numRead << ")";
+}
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_OutputCounter_H_
@@ -0,0 +1,301 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  ReflexCircuitSet.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "ReflexCircuitSet.h"
+#include <OpenSim/OpenSim.h>
+#include <cmath>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+ReflexCircuitSet::ReflexCircuitSet()
+{
+}
+
+/* Convenience constructor. */
+ReflexCircuitSet::ReflexCircuitSet(const std::string& name)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+}
+
+//=============================================================================
+// SETUP
+//=============================================================================
+void ReflexCircuitSet::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+    
+    // the circuits register again when they are connected
+    _circuitNames.clear();
+    _circuitIndices.clear();
+    _circuits.clear();
+    updOutput("spindle_length").clearChannels();
+    updOutput("spindle_speed").clearChannels();
+    updOutput("golgiLength").clearChannels();
+    updOutput("signal").clearChannels();
+}
+
+void ReflexCircuitSet::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+    
+    _valuesCV = addCacheVariable("values",
+        SimTK::Vector(4*getNumCircuits(), 0.0), SimTK::Stage::Velocity);
+}
+
+void ReflexCircuitSet::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    const int n = getNumCircuits();
+    _spindleMuscles.resize(n);
+    _golgiMuscles.resize(n);
+    _restLength.resize(n);
+    _optimalFiberLength.resize(n);
+    _maxSpeed.resize(n);
+    _tendonSlackLength.resize(n);
+    _lengthWeight.resize(n);
+    _speedWeight.resize(n);
+    _golgiWeight.resize(n);
+    _threshold.resize(n);
+    _smoothInterneurons.resize(n);
+    
+    for (int c = 0; c < n; ++c)
+    {
+        const MuscleReflexCircuit& circuit = *_circuits[c];
+        const Muscle& spindleMuscle = circuit.getSpindle().getMuscle();
+        const Muscle& golgiMuscle = circuit.getGolgi().getMuscle();
+        
+        _spindleMuscles[c].reset(&spindleMuscle);
+        _golgiMuscles[c].reset(&golgiMuscle);
+        _restLength[c] = circuit.getSpindle().getNormalizedRestLength();
+        _optimalFiberLength[c] = spindleMuscle.getOptimalFiberLength();
+        _maxSpeed[c] = spindleMuscle.getOptimalFiberLength()*
+                       spindleMuscle.getMaxContractionVelocity();
+        _tendonSlackLength[c] = golgiMuscle.getTendonSlackLength();
+        _lengthWeight[c] = circuit.get_weights(0);
+        _speedWeight[c] = circuit.get_weights(1);
+        _golgiWeight[c] = circuit.get_weights(2);
+        _threshold[c] = circuit.get_threshold();
+        const Interneuron& interneuron = circuit.getInterneuron();
+        _smoothInterneurons[c] = interneuron.getActivation() == "step" ?
+                                 nullptr : &interneuron;
+    }
+}
+
+//=============================================================================
+// CIRCUITS
+//=============================================================================
+
+int ReflexCircuitSet::addCircuit(const MuscleReflexCircuit& circuit)
+{
+    OPENSIM_THROW_IF_FRMOBJ(circuit.getProperty_weights().size() != 3, InvalidPropertyValue, getName(), "Reflex circuit '" + circuit.getName() + "' needs three weights, for the spindle length, spindle speed and Golgi length");
+    
+    int index = getCircuitIndex(circuit.getName());
+    if (index < 0)
+    {
+        index = getNumCircuits();
+        _circuitNames.push_back(circuit.getName());
+        _circuitIndices[circuit.getName()] = index;
+        _circuits.push_back(SimTK::ReferencePtr<const MuscleReflexCircuit>());
+        updOutput("spindle_length").addChannel(circuit.getName());
+        updOutput("spindle_speed").addChannel(circuit.getName());
+        updOutput("golgiLength").addChannel(circuit.getName());
+        updOutput("signal").addChannel(circuit.getName());
+    }
+    _circuits[index].reset(&circuit);
+    
+    return index;
+}
+
+int ReflexCircuitSet::getNumCircuits() const
+{
+    return (int)_circuitNames.size();
+}
+
+int ReflexCircuitSet::getCircuitIndex(const std::string& name) const
+{
+    auto it = _circuitIndices.find(name);
+    return it == _circuitIndices.end() ? -1 : it->second;
+}
+
+const MuscleReflexCircuit& ReflexCircuitSet::getCircuit(int index) const
+{
+    return *_circuits[index];
+}
+
+//=============================================================================
+// SIGNALS
+//=============================================================================
+//_____________________________________________________________________________
+/**
+ * Compute the sensor and interneuron signals of all circuits in one pass
+ *
+ * @param s         current state of the system
+ */
+
+const SimTK::Vector& ReflexCircuitSet::getValues(const SimTK::State& s) const
+{
+    if (isCacheVariableValid(s, _valuesCV))
+    {
+        return getCacheVariableValue(s, _valuesCV);
+    }
+    
+    SimTK::Vector& values = updCacheVariableValue(s, _valuesCV);
+    const int n = getNumCircuits();
+    if (n > 0)
+    {
+        double* spindleLength = &values[0];
+        double* spindleSpeed = spindleLength + n;
+        double* golgiLength = spindleSpeed + n;
+        double* signal = golgiLength + n;
+        
+        // gather the muscle quantities, the only calls into other components
+        for (int c = 0; c < n; ++c)
+        {
+            spindleLength[c] = _spindleMuscles[c]->getLength(s);
+            spindleSpeed[c] = _spindleMuscles[c]->getLengtheningSpeed(s);
+            golgiLength[c] = _golgiMuscles[c]->getTendonLength(s);
+        }
+        
+        const double* restLength = _restLength.data();
+        const double* optimalFiberLength = _optimalFiberLength.data();
+        const double* maxSpeed = _maxSpeed.data();
+        const double* tendonSlackLength = _tendonSlackLength.data();
+        
+        // SimpleSpindle and GolgiTendon: the positive part of the stretch,
+        // normalized
+        for (int c = 0; c < n; ++c)
+        {
+            double stretch = spindleLength[c] - restLength[c]*optimalFiberLength[c];
+            spindleLength[c] = 0.5*(std::fabs(stretch) + stretch)/optimalFiberLength[c];
+        }
+        for (int c = 0; c < n; ++c)
+        {
+            double speed = spindleSpeed[c];
+            spindleSpeed[c] = 0.5*(std::fabs(speed) + speed)/maxSpeed[c];
+        }
+        for (int c = 0; c < n; ++c)
+        {
+            double length = golgiLength[c] - tendonSlackLength[c];
+            golgiLength[c] = 0.5*(std::fabs(length) + length)/tendonSlackLength[c];
+        }
+        
+        // Interneuron: the weighted sum when it exceeds the threshold
+        const double* lengthWeight = _lengthWeight.data();
+        const double* speedWeight = _speedWeight.data();
+        const double* golgiWeight = _golgiWeight.data();
+        const double* threshold = _threshold.data();
+        const Interneuron* const* smooth = _smoothInterneurons.data();
+        for (int c = 0; c < n; ++c)
+        {
+            double sum = lengthWeight[c]*spindleLength[c]
+                       + speedWeight[c]*spindleSpeed[c]
+                       + golgiWeight[c]*golgiLength[c];
+            signal[c] = smooth[c] ? smooth[c]->activate(sum)
+                                  : (sum > threshold[c] ? sum : 0.0);
+        }
+    }
+    markCacheVariableValid(s, _valuesCV);
+    
+    return values;
+}
+
+double ReflexCircuitSet::getValue(const SimTK::State& s, int block,
+                                  const std::string& name) const
+{
+    int index = getCircuitIndex(name);
+    OPENSIM_THROW_IF_FRMOBJ(index < 0, Exception, "No reflex circuit '" + name + "' in the set");
+    return getValues(s)[block*getNumCircuits() + index];
+}
+
+double ReflexCircuitSet::getSpindleLength(const SimTK::State& s, const std::string& name) const
+{
+    return getValue(s, 0, name);
+}
+
+double ReflexCircuitSet::getSpindleSpeed(const SimTK::State& s, const std::string& name) const
+{
+    return getValue(s, 1, name);
+}
+
+double ReflexCircuitSet::getTendonLength(const SimTK::State& s, const std::string& name) const
+{
+    return getValue(s, 2, name);
+}
+
+double ReflexCircuitSet::getSignal(const SimTK::State& s, const std::string& name) const
+{
+    return getValue(s, 3, name);
+}
+
+double ReflexCircuitSet::getCircuitSignal(const SimTK::State& s, int index) const
+{
+    return getValues(s)[3*getNumCircuits() + index];
+}
+
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int ReflexCircuitSet::getSignalIndex(const std::string& outputName,
+                                     const std::string& channelName) const
+{
+    // the list outputs are blocks of the values, in declaration order
+    int block = -1;
+    if (outputName == "spindle_length")
+        block = 0;
+    else if (outputName == "spindle_speed")
+        block = 1;
+    else if (outputName == "golgiLength")
+        block = 2;
+    else if (outputName == "signal")
+        block = 3;
+
+    int index = getCircuitIndex(channelName);
+    if (block < 0 || index < 0)
+        return -1;
+    return block*getNumCircuits() + index;
+}
+
+double ReflexCircuitSet::getSignalValue(const SimTK::State& s, int index) const
+{
+    return getValues(s)[index];
+}
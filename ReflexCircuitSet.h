@@ -0,0 +1,176 @@
+#ifndef OPENSIM_ReflexCircuitSet_H_
+#define OPENSIM_ReflexCircuitSet_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: ReflexCircuitSet.h                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimMuscleReflexCircuitDLL.h"
+#include "SignalSource.h"
+#include "OpenSim/Simulation/Model/Model.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+#include "MuscleReflexCircuit.h"
+#include <map>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * ReflexCircuitSet evaluates the sensors and interneurons of many
+ * MuscleReflexCircuits in one batch. A circuit joins the set by naming it
+ * in its circuit_set property; its delay then reads the interneuron signal
+ * from the set instead of from its own Interneuron.
+ *
+ * The parameters of all circuits (spindle rest length, optimal fiber
+ * length, maximum lengthening speed, tendon slack length, interneuron
+ * weights and threshold) are packed into contiguous arrays when the system
+ * is built. Once per realization the set gathers the fiber length,
+ * lengthening speed and tendon length of every muscle, then runs the
+ * spindle, Golgi tendon and interneuron equations as plain loops over the
+ * arrays, which the compiler vectorizes. Interneurons with a smooth
+ * activation are gated by their own activate(). The results are cached and
+ * published per circuit through the list outputs spindle_length,
+ * spindle_speed, golgiLength and signal, with one channel per circuit. All
+ * of them are available at the Velocity stage.
+ *
+ * The set evaluates the same equations as SimpleSpindle, GolgiTendon and an
+ * Interneuron with three afferents weighted in that order.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMMUSCLEREFLEXCIRCUIT_API ReflexCircuitSet : public ModelComponent, public SignalProvider {
+OpenSim_DECLARE_CONCRETE_OBJECT(ReflexCircuitSet, ModelComponent);
+
+public:
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    OpenSim_DECLARE_LIST_OUTPUT(spindle_length, double, getSpindleLength, SimTK::Stage::Velocity);
+    
+    OpenSim_DECLARE_LIST_OUTPUT(spindle_speed, double, getSpindleSpeed, SimTK::Stage::Velocity);
+    
+    OpenSim_DECLARE_LIST_OUTPUT(golgiLength, double, getTendonLength, SimTK::Stage::Velocity);
+    
+    OpenSim_DECLARE_LIST_OUTPUT(signal, double, getSignal, SimTK::Stage::Velocity);
+    //
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    ReflexCircuitSet();
+    ReflexCircuitSet(const std::string& name);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+    
+//--------------------------------------------------------------------------
+// CIRCUITS
+//--------------------------------------------------------------------------
+    /** Register circuit with the set, adding a channel named after it to
+        every output. Circuits are dropped when the properties are finalized,
+        so they register while the model is connected. Returns the index of
+        the circuit. */
+    int addCircuit(const MuscleReflexCircuit& circuit);
+    
+    int getNumCircuits() const;
+    /** Index of the circuit called name, or -1. */
+    int getCircuitIndex(const std::string& name) const;
+    const MuscleReflexCircuit& getCircuit(int index) const;
+    
+//--------------------------------------------------------------------------
+// REFLEX CIRCUIT SET STATE DEPENDENT ACCESSORS
+//--------------------------------------------------------------------------
+    /** The outputs of all circuits, in circuit order, as one vector of four
+        blocks: spindle length, spindle speed, Golgi length and interneuron
+        signal. */
+    const SimTK::Vector& getValues(const SimTK::State& s) const;
+    
+    double getSpindleLength(const SimTK::State& s, const std::string& name) const;
+    double getSpindleSpeed(const SimTK::State& s, const std::string& name) const;
+    double getTendonLength(const SimTK::State& s, const std::string& name) const;
+    double getSignal(const SimTK::State& s, const std::string& name) const;
+    /** Interneuron signal of the circuit at index, without the lookup by
+        name. */
+    double getCircuitSignal(const SimTK::State& s, int index) const;
+
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
+
+
+private:
+    // Drop the registered circuits
+    void extendFinalizeFromProperties() override;
+    // Allocate the cache of circuit outputs
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Pack the parameters of the circuits
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    // One block of getValues() for the circuit called name
+    double getValue(const SimTK::State& s, int block,
+                    const std::string& name) const;
+    
+    // Registered circuits, with their index by name for the list outputs
+    std::vector<std::string> _circuitNames;
+    std::map<std::string, int> _circuitIndices;
+    std::vector<SimTK::ReferencePtr<const MuscleReflexCircuit> > _circuits;
+    
+    // Packed parameters, one entry per circuit
+    mutable std::vector<SimTK::ReferencePtr<const Muscle> > _spindleMuscles;
+    mutable std::vector<SimTK::ReferencePtr<const Muscle> > _golgiMuscles;
+    mutable std::vector<double> _restLength;
+    mutable std::vector<double> _optimalFiberLength;
+    mutable std::vector<double> _maxSpeed;
+    mutable std::vector<double> _tendonSlackLength;
+    mutable std::vector<double> _lengthWeight;
+    mutable std::vector<double> _speedWeight;
+    mutable std::vector<double> _golgiWeight;
+    mutable std::vector<double> _threshold;
+    // The interneuron of each circuit with a smooth activation, null for
+    // the step
+    mutable std::vector<const Interneuron*> _smoothInterneurons;
+    
+    mutable CacheVariable<SimTK::Vector> _valuesCV;
+
+    
+protected:
+    //=========================================================================
+};  // END of class ReflexCircuitSet
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_ReflexCircuitSet_H_
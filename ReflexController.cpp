@@ -0,0 +1,175 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  ReflexController.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "ReflexController.h"
+#include <OpenSim/OpenSim.h>
+#include <algorithm>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+ReflexController::ReflexController()
+{
+    constructProperties();
+}
+
+/* Convenience constructor. */
+ReflexController::ReflexController(const std::string& name,
+                                   double baselineExcitation)
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+    
+    setName(name);
+    
+    constructProperties();
+    set_baseline_excitation(baselineExcitation);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+void ReflexController::constructProperties()
+{
+    constructProperty_baseline_excitation(0.0);
+}
+
+void ReflexController::extendConnectToModel(Model& model)
+{
+    Super::extendConnectToModel(model);
+    
+    // with actuators of its own the controller drives only the circuits of
+    // those muscles
+    const Set<const Actuator>& actuators = getActuatorSet();
+    _circuits.clear();
+    for (const MuscleReflexCircuit& circuit :
+         model.getComponentList<MuscleReflexCircuit>())
+    {
+        bool driven = actuators.getSize() == 0;
+        for (int i = 0; i < actuators.getSize() && !driven; ++i)
+        {
+            driven = &actuators[i] == &circuit.getMuscle();
+        }
+        if (driven)
+        {
+            _circuits.push_back(
+                SimTK::ReferencePtr<const MuscleReflexCircuit>(&circuit));
+        }
+    }
+}
+
+void ReflexController::extendRealizeTopology(SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+    
+    // the controls of an actuator follow those of the actuators before it
+    // in the model
+    const Set<Actuator>& actuators = getModel().getActuators();
+    _controlIndices.assign(_circuits.size(), -1);
+    for (int c = 0; c < (int)_circuits.size(); ++c)
+    {
+        const Muscle& muscle = _circuits[c]->getMuscle();
+        int index = 0;
+        for (int i = 0; i < actuators.getSize(); ++i)
+        {
+            if (&actuators[i] == &muscle)
+            {
+                _controlIndices[c] = index;
+                break;
+            }
+            index += actuators[i].numControls();
+        }
+        
+        OPENSIM_THROW_IF_FRMOBJ(_controlIndices[c] < 0, Exception, "The muscle of reflex circuit '" + _circuits[c]->getName() + "' is not an actuator of the model");
+    }
+    
+    // the baseline goes once to every muscle, however many circuits it has
+    _baselineIndices = _controlIndices;
+    std::sort(_baselineIndices.begin(), _baselineIndices.end());
+    _baselineIndices.erase(
+        std::unique(_baselineIndices.begin(), _baselineIndices.end()),
+        _baselineIndices.end());
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+void ReflexController::setBaselineExcitation(double baselineExcitation)
+{
+    set_baseline_excitation(baselineExcitation);
+}
+double ReflexController::getBaselineExcitation() const
+{
+    return get_baseline_excitation();
+}
+
+int ReflexController::getNumCircuits() const
+{
+    return (int)_circuits.size();
+}
+
+const MuscleReflexCircuit& ReflexController::getCircuit(int index) const
+{
+    return *_circuits[index];
+}
+
+//=============================================================================
+// CONTROL
+//=============================================================================
+//_____________________________________________________________________________
+/**
+ * Excite the circuit muscles with the baseline plus the reflex signal
+ *
+ * @param s         current state of the system
+ * @param controls  the model controls vector to add to
+ */
+
+void ReflexController::computeControls(const SimTK::State& s,
+                                       SimTK::Vector& controls) const
+{
+    const double baseline = get_baseline_excitation();
+    for (int index : _baselineIndices)
+    {
+        controls[index] += baseline;
+    }
+    for (int c = 0; c < (int)_circuits.size(); ++c)
+    {
+        controls[_controlIndices[c]] += _circuits[c]->getMuscleSignal(s);
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef OPENSIM_ReflexController_H_
+#define OPENSIM_ReflexController_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: ReflexController.h                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimReflexControllerDLL.h"
+#include "OpenSim/Simulation/Control/Controller.h"
+#include "OpenSim/Simulation/Model/Model.h"
+#include "MuscleReflexCircuit.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * ReflexController closes the reflex loop: it excites the muscle of every
+ * MuscleReflexCircuit in the model with the muscle_signal of the circuit,
+ * added to a baseline excitation. The baseline is added once per muscle, so
+ * a muscle with several circuits gets the sum of their signals plus one
+ * baseline. If actuators are given to the controller only the circuits of
+ * those muscles are driven; with none, the circuits of every muscle are.
+ *
+ * The circuits and the position of their muscle in the model controls
+ * vector are gathered once when the model is connected and its system is
+ * built, so computeControls() is a single pass over flat arrays that adds
+ * each circuit's signal directly into the controls vector, with no lookup
+ * of actuators by name and no per-actuator control functions. Controls from
+ * other controllers on the same muscles are added to, as with any
+ * Controller.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMREFLEXCONTROLLER_API ReflexController : public Controller {
+OpenSim_DECLARE_CONCRETE_OBJECT(ReflexController, Controller);
+
+public:
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(baseline_excitation, double, "The excitation sent to every reflex controlled muscle before the reflex signal is added");
+    
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    ReflexController();
+    ReflexController(const std::string& name,
+                     double baselineExcitation);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+    
+//--------------------------------------------------------------------------
+// REFLEX CONTROLLER PARAMETER ACCESSORS
+//--------------------------------------------------------------------------
+    void setBaselineExcitation(double baselineExcitation);
+    double getBaselineExcitation() const;
+    
+    /** Number of circuits driven by this controller. */
+    int getNumCircuits() const;
+    const MuscleReflexCircuit& getCircuit(int index) const;
+    
+//--------------------------------------------------------------------------
+// CONTROLLER INTERFACE
+//--------------------------------------------------------------------------
+    /** Add the baseline excitation to the control of every driven muscle
+        and the muscle_signal of every circuit to that of its muscle. */
+    void computeControls(const SimTK::State& s,
+                         SimTK::Vector& controls) const override;
+    
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+    // Gather the reflex circuits of the model
+    void extendConnectToModel(Model& model) override;
+    // Find the controls vector index of every circuit muscle and of every
+    // muscle that gets the baseline
+    void extendRealizeTopology(SimTK::State& s) const override;
+    
+    // The circuits and the index of the control of their muscle
+    std::vector<SimTK::ReferencePtr<const MuscleReflexCircuit> > _circuits;
+    mutable std::vector<int> _controlIndices;
+    mutable std::vector<int> _baselineIndices;
+
+    
+protected:
+    //=========================================================================
+};  // END of class ReflexController
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_ReflexController_H_
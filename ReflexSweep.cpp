@@ -0,0 +1,1153 @@
+/* -------------------------------------------------------------------------- *
+ *                         OpenSim:  ReflexSweep.cpp                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "ReflexSweep.h"
+#include "CircuitEnsemble.h"
+#include "EnsembleController.h"
+#include "TugOfWarModel.h"
+#include <OpenSim/OpenSim.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define REFLEXSWEEP_PROCESSES
+#endif
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+namespace {
+    
+    // weights are written as w1,w2,w3
+    bool parseWeights(const std::string& field, std::vector<double>& weights)
+    {
+        weights.clear();
+        std::istringstream values(field);
+        std::string value;
+        while (std::getline(values, value, ','))
+        {
+            std::istringstream number(value);
+            double weight;
+            if (!(number >> weight) || !(number >> std::ws).eof())
+            {
+                return false;
+            }
+            weights.push_back(weight);
+        }
+        return !weights.empty();
+    }
+    
+    std::string formatWeights(const std::vector<double>& weights)
+    {
+        std::ostringstream out;
+        for (int i = 0; i < (int)weights.size(); ++i)
+        {
+            out << (i > 0 ? "," : "") << weights[i];
+        }
+        return out.str();
+    }
+    
+    bool readNumbers(const std::vector<std::string>& fields, double* x, int n)
+    {
+        if ((int)fields.size() != n + 1)
+        {
+            return false;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            std::istringstream number(fields[i + 1]);
+            if (!(number >> x[i]) || !(number >> std::ws).eof())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool hasNaN(const SimTK::Vector& y)
+    {
+        for (int i = 0; i < y.size(); ++i)
+        {
+            if (SimTK::isNaN(y[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // why a run at s, with the block at x and the excitation saturated for
+    // saturatedTime, ends early after elapsed seconds, or an empty string
+    std::string checkAbortCriteria(const ReflexAbortCriteria& criteria,
+                                   const SimTK::State& s, double x,
+                                   double saturatedTime, double elapsed)
+    {
+        std::ostringstream reason;
+        if (criteria.abortOnNaN && hasNaN(s.getY()))
+        {
+            reason << "NaN state";
+        }
+        else if (x < criteria.minPosition || x > criteria.maxPosition)
+        {
+            reason << "position " << x << " outside [" << criteria.minPosition
+                   << ", " << criteria.maxPosition << "]";
+        }
+        else if (saturatedTime > criteria.maxSaturationTime)
+        {
+            reason << "excitation at or above " << criteria.saturationLevel
+                   << " for " << saturatedTime << " s";
+        }
+        else if (elapsed > criteria.maxWallTime)
+        {
+            reason << "wall time above " << criteria.maxWallTime << " s";
+        }
+        return reason.str();
+    }
+    
+    // the values of an abort line, a criterion and its arguments
+    bool readAbortCriterion(const std::vector<std::string>& values,
+                            ReflexAbortCriteria& criteria)
+    {
+        double x[2];
+        const std::string criterion = values.empty() ? "" : values[0];
+        if (criterion == "position" && readNumbers(values, x, 2) && x[0] <= x[1])
+        {
+            criteria.minPosition = x[0];
+            criteria.maxPosition = x[1];
+        }
+        else if (criterion == "saturation" && readNumbers(values, x, 2))
+        {
+            criteria.saturationLevel = x[0];
+            criteria.maxSaturationTime = x[1];
+        }
+        else if (criterion == "nan" && values.size() == 2 &&
+                 (values[1] == "on" || values[1] == "off"))
+        {
+            criteria.abortOnNaN = values[1] == "on";
+        }
+        else if (criterion == "wall_time" && readNumbers(values, x, 1))
+        {
+            criteria.maxWallTime = x[0];
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+    
+#ifdef REFLEXSWEEP_PROCESSES
+    
+    // A result file has one line per run, the index of the point and the
+    // fields of its result, tab separated and written at full precision
+    void writeResultLine(std::ostream& out, int index,
+                         const ReflexSweepResult& result)
+    {
+        const ReflexParameters& p = result.parameters;
+        std::ostringstream weights;
+        weights.precision(17);
+        for (int i = 0; i < (int)p.weights.size(); ++i)
+        {
+            weights << (i > 0 ? "," : "") << p.weights[i];
+        }
+        std::string abortReason = result.abortReason;
+        std::replace(abortReason.begin(), abortReason.end(), '\t', ' ');
+        std::replace(abortReason.begin(), abortReason.end(), '\n', ' ');
+        std::string error = result.error;
+        std::replace(error.begin(), error.end(), '\t', ' ');
+        std::replace(error.begin(), error.end(), '\n', ' ');
+        
+        out.precision(17);
+        out << index << "\t" << p.threshold << "\t" << p.timeDelay << "\t"
+            << p.defaultControlSignal << "\t" << weights.str() << "\t"
+            << result.steps << "\t" << result.wallTime << "\t"
+            << result.endTime << "\t" << result.finalPosition << "\t"
+            << result.peakSignal << "\t" << result.meanSignal << "\t"
+            << abortReason << "\t" << error << "\n";
+    }
+    
+    // Numbers written by a worker; nan is read back as well
+    bool parseNumber(const std::string& field, double& x)
+    {
+        char* end = nullptr;
+        x = std::strtod(field.c_str(), &end);
+        return !field.empty() && *end == '\0';
+    }
+    
+    // false for a line cut short by a worker that was killed
+    bool readResultLine(const std::string& line, int& index,
+                        ReflexSweepResult& result)
+    {
+        std::vector<std::string> fields;
+        std::istringstream in(line);
+        std::string field;
+        while (std::getline(in, field, '\t'))
+        {
+            fields.push_back(field);
+        }
+        // getline drops a last empty field
+        if (fields.size() == 12)
+        {
+            fields.push_back("");
+        }
+        
+        ReflexParameters& p = result.parameters;
+        double number, steps;
+        if (fields.size() != 13 ||
+            !parseNumber(fields[0], number) ||
+            !parseNumber(fields[1], p.threshold) ||
+            !parseNumber(fields[2], p.timeDelay) ||
+            !parseNumber(fields[3], p.defaultControlSignal) ||
+            !parseWeights(fields[4], p.weights) ||
+            !parseNumber(fields[5], steps) ||
+            !parseNumber(fields[6], result.wallTime) ||
+            !parseNumber(fields[7], result.endTime) ||
+            !parseNumber(fields[8], result.finalPosition) ||
+            !parseNumber(fields[9], result.peakSignal) ||
+            !parseNumber(fields[10], result.meanSignal))
+        {
+            return false;
+        }
+        index = (int)number;
+        result.steps = (int)steps;
+        result.abortReason = fields[11];
+        result.error = fields[12];
+        return true;
+    }
+    
+    // Read or write all of n bytes, false on end of file or error
+    bool readAll(int fd, void* data, size_t n)
+    {
+        char* p = (char*)data;
+        while (n > 0)
+        {
+            ssize_t k = ::read(fd, p, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            p += k;
+            n -= k;
+        }
+        return true;
+    }
+    
+    bool writeAll(int fd, const void* data, size_t n)
+    {
+        const char* p = (const char*)data;
+        while (n > 0)
+        {
+            ssize_t k = ::write(fd, p, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            p += k;
+            n -= k;
+        }
+        return true;
+    }
+    
+#endif
+    
+}
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor, only the NaN check. */
+ReflexAbortCriteria::ReflexAbortCriteria() :
+    minPosition(-SimTK::Infinity),
+    maxPosition(SimTK::Infinity),
+    saturationLevel(1.0),
+    maxSaturationTime(SimTK::Infinity),
+    abortOnNaN(true),
+    maxWallTime(SimTK::Infinity)
+{
+}
+
+//_____________________________________________________________________________
+/* Default constructor. */
+ReflexSweep::ReflexSweep() :
+    _finalTime(10.0),
+    _accuracy(1.0e-6),
+    _reportInterval(0.01)
+{
+}
+
+ReflexParameters ReflexSweep::getDefaultParameters()
+{
+    ReflexParameters parameters;
+    parameters.threshold = 0.1;
+    parameters.timeDelay = 0.1;
+    parameters.defaultControlSignal = 0.5;
+    parameters.weights = {0.4, 0.4, 0.2};
+    return parameters;
+}
+
+//=============================================================================
+// POINTS
+//=============================================================================
+
+void ReflexSweep::clear()
+{
+    _points.clear();
+}
+
+void ReflexSweep::addPoint(const ReflexParameters& parameters)
+{
+    _points.push_back(parameters);
+}
+
+void ReflexSweep::addGrid(const std::vector<double>& thresholds,
+                          const std::vector<double>& timeDelays,
+                          const std::vector<double>& defaultControlSignals,
+                          const std::vector<std::vector<double> >& weights)
+{
+    ReflexParameters parameters;
+    for (const std::vector<double>& w : weights)
+    {
+        parameters.weights = w;
+        for (double signal : defaultControlSignals)
+        {
+            parameters.defaultControlSignal = signal;
+            for (double delay : timeDelays)
+            {
+                parameters.timeDelay = delay;
+                for (double threshold : thresholds)
+                {
+                    parameters.threshold = threshold;
+                    _points.push_back(parameters);
+                }
+            }
+        }
+    }
+}
+
+bool ReflexSweep::read(std::istream& in, std::string& message)
+{
+    clear();
+    _criteria = ReflexAbortCriteria();
+    
+    const ReflexParameters defaults = getDefaultParameters();
+    std::vector<double> thresholds, timeDelays, signals;
+    std::vector<std::vector<double> > weights;
+    std::vector<ReflexParameters> points;
+    bool isGrid = false;
+    
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+        
+        std::ostringstream where;
+        where << "line " << lineNumber << ": ";
+        
+        std::vector<std::string> values;
+        std::string value;
+        while (fields >> value)
+        {
+            values.push_back(value);
+        }
+        
+        if (keyword == "point")
+        {
+            ReflexParameters point;
+            std::istringstream numbers(values.size() == 4 ?
+                values[0] + " " + values[1] + " " + values[2] : "");
+            if (!(numbers >> point.threshold >> point.timeDelay
+                          >> point.defaultControlSignal) ||
+                !parseWeights(values[3], point.weights))
+            {
+                message = where.str() + "a point is threshold, timeDelay, "
+                          "defaultControlSignal and comma separated weights";
+                return false;
+            }
+            points.push_back(point);
+            continue;
+        }
+        
+        if (keyword == "abort")
+        {
+            if (!readAbortCriterion(values, _criteria))
+            {
+                message = where.str() + "an abort line is 'position min max', "
+                          "'saturation level time', 'nan on|off' or "
+                          "'wall_time seconds'";
+                return false;
+            }
+            continue;
+        }
+        
+        if (keyword == "weights")
+        {
+            for (const std::string& field : values)
+            {
+                std::vector<double> w;
+                if (!parseWeights(field, w))
+                {
+                    message = where.str() + "'" + field + "' is not a list of weights";
+                    return false;
+                }
+                weights.push_back(w);
+            }
+        }
+        else
+        {
+            std::vector<double>* grid =
+                keyword == "threshold" ? &thresholds :
+                keyword == "timeDelay" ? &timeDelays :
+                keyword == "defaultControlSignal" ? &signals : nullptr;
+            if (!grid)
+            {
+                message = where.str() + "unknown keyword '" + keyword + "'";
+                return false;
+            }
+            for (const std::string& field : values)
+            {
+                std::istringstream number(field);
+                double x;
+                if (!(number >> x) || !(number >> std::ws).eof())
+                {
+                    message = where.str() + "'" + field + "' is not a number";
+                    return false;
+                }
+                grid->push_back(x);
+            }
+        }
+        if (values.empty())
+        {
+            message = where.str() + "'" + keyword + "' has no values";
+            return false;
+        }
+        isGrid = true;
+    }
+    
+    if (isGrid)
+    {
+        if (thresholds.empty()) thresholds.push_back(defaults.threshold);
+        if (timeDelays.empty()) timeDelays.push_back(defaults.timeDelay);
+        if (signals.empty()) signals.push_back(defaults.defaultControlSignal);
+        if (weights.empty()) weights.push_back(defaults.weights);
+        addGrid(thresholds, timeDelays, signals, weights);
+    }
+    _points.insert(_points.end(), points.begin(), points.end());
+    return true;
+}
+
+//=============================================================================
+// RUN
+//=============================================================================
+
+ReflexSweepResult ReflexSweep::simulate(const ReflexParameters& parameters) const
+{
+    ReflexSweepResult result;
+    result.parameters = parameters;
+    result.steps = 0;
+    result.wallTime = 0;
+    result.endTime = 0;
+    result.finalPosition = SimTK::NaN;
+    result.peakSignal = SimTK::NaN;
+    result.meanSignal = SimTK::NaN;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try {
+        Model model;
+        buildTugOfWarModel(model, ReflexExcitation);
+        
+        MuscleReflexCircuit& circuit =
+            model.updComponent<MuscleReflexCircuit>("reflex_circuit");
+        circuit.set_threshold(parameters.threshold);
+        circuit.set_timeDelay(parameters.timeDelay);
+        circuit.set_defaultControlSignal(parameters.defaultControlSignal);
+        circuit.updProperty_weights().clear();
+        for (double weight : parameters.weights)
+        {
+            circuit.append_weights(weight);
+        }
+        
+        SimTK::State& si = initializeTugOfWarState(model);
+        const MuscleReflexCircuit& reflex =
+            model.getComponent<MuscleReflexCircuit>("reflex_circuit");
+        const Muscle& muscle = model.getComponent<Muscle>("original1");
+        const Coordinate& position = model.getCoordinateSet()[5];
+        
+        Manager manager(model);
+        manager.setIntegratorAccuracy(_accuracy);
+        si.setTime(0.0);
+        manager.initialize(si);
+        
+        // sample the signal of the circuit and check the abort criteria
+        // every report interval
+        const ReflexAbortCriteria& criteria = _criteria;
+        const int numSamples = std::max(1, (int)std::ceil(_finalTime/_reportInterval - 1e-9));
+        double peak = -SimTK::Infinity, sum = 0;
+        double saturatedTime = 0;
+        int k = 1;
+        for (; k <= numSamples; ++k)
+        {
+            const SimTK::State& s = manager.integrate(std::min(k*_reportInterval, _finalTime));
+            model.realizeVelocity(s);
+            double signal = reflex.getMuscleSignal(s);
+            peak = std::max(peak, signal);
+            sum += signal;
+            
+            saturatedTime = muscle.getExcitation(s) >= criteria.saturationLevel ?
+                            saturatedTime + _reportInterval : 0;
+            double elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            result.abortReason = checkAbortCriteria(criteria, s,
+                position.getValue(s), saturatedTime, elapsed);
+            if (!result.abortReason.empty())
+            {
+                break;
+            }
+        }
+        
+        const SimTK::State& s = manager.getState();
+        result.steps = manager.getIntegrator().getNumStepsTaken();
+        result.endTime = s.getTime();
+        result.finalPosition = position.getValue(s);
+        result.peakSignal = peak;
+        result.meanSignal = sum/std::min(k, numSamples);
+    }
+    catch (const std::exception& ex) {
+        result.error = ex.what();
+    }
+    result.wallTime = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    return result;
+}
+
+std::vector<ReflexSweepResult> ReflexSweep::run(int numThreads) const
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    numThreads = std::max(1, std::min(numThreads, getNumPoints()));
+    
+    // the workers take the next point until none is left, and each writes
+    // only the result of the points it took
+    std::vector<ReflexSweepResult> results(_points.size());
+    std::atomic<int> next(0);
+    auto work = [&]()
+    {
+        for (int i = next++; i < getNumPoints(); i = next++)
+        {
+            results[i] = simulate(_points[i]);
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (int t = 1; t < numThreads; ++t)
+    {
+        workers.push_back(std::thread(work));
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    
+    return results;
+}
+
+//=============================================================================
+// PROCESSES
+//=============================================================================
+
+#ifdef REFLEXSWEEP_PROCESSES
+
+namespace {
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    // A worker process, the pipes to and from it and the point it runs
+    struct Worker {
+        pid_t pid;
+        int toWorker;
+        int fromWorker;
+        int point;
+        int attempt;
+        Clock::time_point started;
+    };
+    
+    // A point waiting for a worker, and the number of times it failed
+    struct Task {
+        int point;
+        int attempt;
+    };
+    
+    // The result of a point whose worker gave none
+    ReflexSweepResult failedResult(const ReflexParameters& parameters,
+                                   double wallTime, const std::string& error)
+    {
+        ReflexSweepResult result;
+        result.parameters = parameters;
+        result.steps = 0;
+        result.wallTime = wallTime;
+        result.endTime = 0;
+        result.finalPosition = SimTK::NaN;
+        result.peakSignal = SimTK::NaN;
+        result.meanSignal = SimTK::NaN;
+        result.error = error;
+        return result;
+    }
+    
+}
+
+std::vector<ReflexSweepResult> ReflexSweep::runProcesses(int numWorkers,
+    double timeout, int maxAttempts, const std::string& directory) const
+{
+    if (numWorkers <= 0)
+    {
+        numWorkers = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    numWorkers = std::max(1, std::min(numWorkers, getNumPoints()));
+    maxAttempts = std::max(1, maxAttempts);
+    
+    std::vector<ReflexSweepResult> results(_points.size());
+    std::vector<bool> failed(_points.size(), false);
+    std::vector<std::string> files;
+    std::deque<Task> pending;
+    for (int i = 0; i < getNumPoints(); ++i)
+    {
+        Task task = {i, 0};
+        pending.push_back(task);
+    }
+    
+    std::vector<Worker> workers(numWorkers);
+    for (Worker& worker : workers)
+    {
+        worker.pid = 0;
+        worker.toWorker = -1;
+        worker.fromWorker = -1;
+        worker.point = -1;
+        worker.attempt = 0;
+    }
+    int busy = 0;
+    
+    // a write to a worker that died fails instead of killing the coordinator
+    void (*previousHandler)(int) = std::signal(SIGPIPE, SIG_IGN);
+    
+    // a worker reads point indices from its pipe until it is closed, appends
+    // each result to a file of its own and sends the index back when done
+    auto spawn = [&](Worker& worker)
+    {
+        int down[2], up[2];
+        OPENSIM_THROW_IF(pipe(down) != 0, Exception, "Cannot create the pipes of a sweep worker");
+        if (pipe(up) != 0)
+        {
+            close(down[0]);
+            close(down[1]);
+            OPENSIM_THROW(Exception, "Cannot create the pipes of a sweep worker");
+        }
+        // named after the coordinator, so that sweeps running at the same
+        // time in one directory do not share files
+        std::ostringstream file;
+        file << directory << "/reflexSweep_" << getpid() << "_worker"
+             << files.size() << ".tsv";
+        files.push_back(file.str());
+        std::remove(file.str().c_str());
+        
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(down[0]);
+            close(down[1]);
+            close(up[0]);
+            close(up[1]);
+            OPENSIM_THROW(Exception, "Cannot fork a sweep worker");
+        }
+        if (pid == 0)
+        {
+            // the pipes of the other workers must close when the
+            // coordinator closes them
+            close(down[1]);
+            close(up[0]);
+            for (const Worker& other : workers)
+            {
+                if (other.toWorker >= 0) close(other.toWorker);
+                if (other.fromWorker >= 0) close(other.fromWorker);
+            }
+            
+            // leave without the destructors and exit handlers of the
+            // coordinator
+            try {
+                std::ofstream out(file.str().c_str(), std::ios::app);
+                int point;
+                while (readAll(down[0], &point, sizeof(point)))
+                {
+                    writeResultLine(out, point, simulate(_points[point]));
+                    out.flush();
+                    if (!writeAll(up[1], &point, sizeof(point)))
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        
+        close(down[0]);
+        close(up[1]);
+        worker.pid = pid;
+        worker.toWorker = down[1];
+        worker.fromWorker = up[0];
+        worker.point = -1;
+        worker.attempt = 0;
+    };
+    
+    auto stop = [&](Worker& worker, bool kill)
+    {
+        close(worker.toWorker);
+        close(worker.fromWorker);
+        if (kill)
+        {
+            ::kill(worker.pid, SIGKILL);
+        }
+        int status = 0;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+        worker.pid = 0;
+        worker.toWorker = -1;
+        worker.fromWorker = -1;
+        return status;
+    };
+    
+    // a failed point is run again on a fresh worker, up to maxAttempts
+    auto fail = [&](Worker& worker, const std::string& reason)
+    {
+        Task task = {worker.point, worker.attempt + 1};
+        if (task.attempt < maxAttempts)
+        {
+            pending.push_front(task);
+        }
+        else
+        {
+            results[worker.point] = failedResult(_points[worker.point],
+                std::chrono::duration<double>(Clock::now() - worker.started).count(),
+                reason);
+            failed[worker.point] = true;
+        }
+        spawn(worker);
+    };
+    
+    try {
+        for (Worker& worker : workers)
+        {
+            spawn(worker);
+        }
+        
+        while (!pending.empty() || busy > 0)
+        {
+            for (Worker& worker : workers)
+            {
+                if (worker.point < 0 && !pending.empty())
+                {
+                    Task task = pending.front();
+                    pending.pop_front();
+                    worker.point = task.point;
+                    worker.attempt = task.attempt;
+                    worker.started = Clock::now();
+                    ++busy;
+                    if (!writeAll(worker.toWorker, &task.point, sizeof(task.point)))
+                    {
+                        --busy;
+                        stop(worker, true);
+                        fail(worker, "the worker exited before the run");
+                        worker.point = -1;
+                    }
+                }
+            }
+            
+            // wait for a worker to finish, at most until the next timeout
+            std::vector<pollfd> fds;
+            std::vector<Worker*> owners;
+            double wait = timeout;
+            for (Worker& worker : workers)
+            {
+                if (worker.point >= 0)
+                {
+                    pollfd fd = {worker.fromWorker, POLLIN, 0};
+                    fds.push_back(fd);
+                    owners.push_back(&worker);
+                    wait = std::min(wait, timeout - std::chrono::duration<double>(
+                        Clock::now() - worker.started).count());
+                }
+            }
+            if (fds.empty())
+            {
+                continue;
+            }
+            int ready = poll(fds.data(), fds.size(),
+                             timeout > 0 ? (int)std::ceil(1000*std::max(wait, 0.0)) : -1);
+            OPENSIM_THROW_IF(ready < 0 && errno != EINTR, Exception, "Waiting for the sweep workers failed");
+            
+            for (int k = 0; k < (int)fds.size(); ++k)
+            {
+                Worker& worker = *owners[k];
+                double elapsed = std::chrono::duration<double>(
+                    Clock::now() - worker.started).count();
+                int point;
+                if (fds[k].revents != 0)
+                {
+                    --busy;
+                    if (readAll(worker.fromWorker, &point, sizeof(point)))
+                    {
+                        worker.point = -1;
+                        continue;
+                    }
+                    // the worker died in the middle of the run
+                    int status = stop(worker, false);
+                    std::ostringstream reason;
+                    if (WIFSIGNALED(status))
+                    {
+                        reason << "the worker was killed by signal " << WTERMSIG(status);
+                    }
+                    else
+                    {
+                        reason << "the worker exited with status " << WEXITSTATUS(status);
+                    }
+                    fail(worker, reason.str());
+                    worker.point = -1;
+                }
+                else if (timeout > 0 && elapsed >= timeout)
+                {
+                    --busy;
+                    stop(worker, true);
+                    std::ostringstream reason;
+                    reason << "timed out after " << timeout << " s";
+                    fail(worker, reason.str());
+                    worker.point = -1;
+                }
+            }
+        }
+        
+        // closing the pipes lets the idle workers leave their loop
+        for (Worker& worker : workers)
+        {
+            if (worker.pid > 0)
+            {
+                stop(worker, false);
+            }
+        }
+    }
+    catch (...) {
+        for (Worker& worker : workers)
+        {
+            if (worker.pid > 0)
+            {
+                stop(worker, true);
+            }
+        }
+        std::signal(SIGPIPE, previousHandler);
+        throw;
+    }
+    std::signal(SIGPIPE, previousHandler);
+    
+    // merge the result files of the workers; a point that was retried after
+    // its worker died has no line from the attempts that failed
+    std::vector<bool> merged(failed);
+    for (const std::string& file : files)
+    {
+        std::ifstream in(file.c_str());
+        std::string line;
+        while (std::getline(in, line))
+        {
+            int index;
+            ReflexSweepResult result;
+            if (readResultLine(line, index, result) &&
+                index >= 0 && index < getNumPoints() && !merged[index])
+            {
+                results[index] = result;
+                merged[index] = true;
+            }
+        }
+        in.close();
+        std::remove(file.c_str());
+    }
+    
+    for (int i = 0; i < getNumPoints(); ++i)
+    {
+        if (!merged[i])
+        {
+            results[i] = failedResult(_points[i], 0, "no result was written");
+        }
+    }
+    
+    return results;
+}
+
+#else
+
+std::vector<ReflexSweepResult> ReflexSweep::runProcesses(int numWorkers,
+    double timeout, int maxAttempts, const std::string& directory) const
+{
+    OPENSIM_THROW(Exception, "Sweeps in worker processes need fork() and are not supported on this platform");
+}
+
+#endif
+
+//=============================================================================
+// ENSEMBLE
+//=============================================================================
+
+namespace {
+    
+    // One point of an ensemble run: its model, the integrator that steps
+    // it, the statistics of its signal and its share of the wall time
+    struct EnsembleMember {
+        Model model;
+        std::unique_ptr<SimTK::RungeKuttaMersonIntegrator> integrator;
+        std::unique_ptr<SimTK::TimeStepper> stepper;
+        const SimpleSpindle* spindle;
+        const GolgiTendon* golgi;
+        const EnsembleController* controller;
+        const Muscle* muscle;
+        const Coordinate* position;
+        bool running;
+        double peak;
+        double sum;
+        int numSamples;
+        double saturatedTime;
+        double wallTime;
+    };
+    
+}
+
+std::vector<ReflexSweepResult> ReflexSweep::runEnsemble(double stepSize) const
+{
+    OPENSIM_THROW_IF(stepSize <= 0, Exception, "The step of an ensemble run must be positive");
+    
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    
+    const int K = getNumPoints();
+    std::vector<ReflexSweepResult> results(K);
+    std::vector<std::unique_ptr<EnsembleMember> > members;
+    for (int k = 0; k < K; ++k)
+    {
+        ReflexSweepResult& result = results[k];
+        result.parameters = _points[k];
+        result.steps = 0;
+        result.endTime = 0;
+        result.finalPosition = SimTK::NaN;
+        result.peakSignal = SimTK::NaN;
+        result.meanSignal = SimTK::NaN;
+        
+        members.push_back(std::unique_ptr<EnsembleMember>(new EnsembleMember()));
+        EnsembleMember& member = *members.back();
+        member.running = false;
+        member.peak = -SimTK::Infinity;
+        member.sum = 0;
+        member.numSamples = 0;
+        member.saturatedTime = 0;
+        member.wallTime = 0;
+        try {
+            // the circuit of the point is evaluated by the ensemble, the
+            // model only holds the excitation it computes
+            buildTugOfWarModel(member.model, EnsembleExcitation);
+            SimTK::State& si = initializeTugOfWarState(member.model);
+            si.setTime(0.0);
+            
+            Model& model = member.model;
+            member.spindle = &model.getComponent<SimpleSpindle>("muscle_spindle");
+            member.golgi = &model.getComponent<GolgiTendon>("muscle_golgi");
+            member.controller =
+                &model.getComponent<EnsembleController>("ensemble_controller");
+            member.muscle = &model.getComponent<Muscle>("original1");
+            member.position = &model.getCoordinateSet()[5];
+            
+            member.integrator.reset(new SimTK::RungeKuttaMersonIntegrator(
+                model.getMultibodySystem()));
+            member.integrator->setFixedStepSize(stepSize);
+            member.stepper.reset(new SimTK::TimeStepper(
+                model.getMultibodySystem(), *member.integrator));
+            member.stepper->initialize(si);
+            member.running = true;
+        }
+        catch (const std::exception& ex) {
+            result.error = ex.what();
+        }
+    }
+    
+    CircuitEnsemble circuits;
+    circuits.assign(_points, stepSize);
+    double* spindleLengths = circuits.updSpindleLengths();
+    double* spindleSpeeds = circuits.updSpindleSpeeds();
+    double* tendonLengths = circuits.updTendonLengths();
+    const double* muscleSignals = circuits.getMuscleSignals();
+    
+    // the signals are sampled and the abort criteria checked every report
+    // interval, rounded to a whole number of steps
+    const ReflexAbortCriteria& criteria = _criteria;
+    const int numSteps = std::max(1, (int)std::ceil(_finalTime/stepSize - 1e-9));
+    const int reportSteps = std::max(1, (int)std::floor(_reportInterval/stepSize + 1e-9));
+    Clock::time_point lastReport = start;
+    for (int n = 0; ; ++n)
+    {
+        // nothing is left to step once every member has stopped
+        int numRunning = 0;
+        for (int k = 0; k < K; ++k)
+        {
+            numRunning += members[k]->running ? 1 : 0;
+        }
+        if (numRunning == 0) break;
+        
+        // the afferents of every member at the time of the sample
+        for (int k = 0; k < K; ++k)
+        {
+            EnsembleMember& member = *members[k];
+            if (!member.running) continue;
+            try {
+                const SimTK::State& s = member.stepper->getState();
+                member.model.realizeVelocity(s);
+                spindleLengths[k] = member.spindle->getSpindleLength(s);
+                spindleSpeeds[k] = member.spindle->getSpindleSpeed(s);
+                tendonLengths[k] = member.golgi->getTendonLength(s);
+            }
+            catch (const std::exception& ex) {
+                results[k].error = ex.what();
+                member.running = false;
+            }
+        }
+        circuits.step();
+        
+        if (n > 0 && (n % reportSteps == 0 || n == numSteps))
+        {
+            // the wall time of the interval is shared by the members that
+            // ran through it, so that wall_time bounds the time of a run
+            // as it does when the points run one at a time
+            Clock::time_point now = Clock::now();
+            double share = std::chrono::duration<double>(
+                now - lastReport).count()/numRunning;
+            lastReport = now;
+            for (int k = 0; k < K; ++k)
+            {
+                EnsembleMember& member = *members[k];
+                if (!member.running) continue;
+                member.wallTime += share;
+                const SimTK::State& s = member.stepper->getState();
+                member.peak = std::max(member.peak, muscleSignals[k]);
+                member.sum += muscleSignals[k];
+                ++member.numSamples;
+                
+                member.saturatedTime =
+                    member.muscle->getExcitation(s) >= criteria.saturationLevel ?
+                    member.saturatedTime + reportSteps*stepSize : 0;
+                results[k].abortReason = checkAbortCriteria(criteria, s,
+                    member.position->getValue(s), member.saturatedTime,
+                    member.wallTime);
+                member.running = results[k].abortReason.empty();
+            }
+        }
+        if (n == numSteps) break;
+        
+        // the excitation of every member is held over the next step, the
+        // baseline of the ReflexController plus the delayed signal
+        for (int k = 0; k < K; ++k)
+        {
+            EnsembleMember& member = *members[k];
+            if (!member.running) continue;
+            try {
+                SimTK::Integrator& integrator = member.stepper->updIntegrator();
+                member.controller->setExcitation(integrator.updAdvancedState(),
+                    member.controller->getDefaultExcitation() + muscleSignals[k]);
+                integrator.reinitialize(SimTK::Stage::Velocity, false);
+                member.stepper->stepTo(std::min((n + 1)*stepSize, _finalTime));
+            }
+            catch (const std::exception& ex) {
+                results[k].error = ex.what();
+                member.running = false;
+            }
+        }
+    }
+    
+    for (int k = 0; k < K; ++k)
+    {
+        EnsembleMember& member = *members[k];
+        ReflexSweepResult& result = results[k];
+        result.wallTime = member.wallTime;
+        if (!member.stepper) continue;
+        const SimTK::State& s = member.stepper->getState();
+        result.steps = member.integrator->getNumStepsTaken();
+        result.endTime = s.getTime();
+        result.finalPosition = member.position->getValue(s);
+        if (member.numSamples > 0)
+        {
+            result.peakSignal = member.peak;
+            result.meanSignal = member.sum/member.numSamples;
+        }
+    }
+    
+    return results;
+}
+
+void ReflexSweep::writeTable(std::ostream& out,
+                             const std::vector<ReflexSweepResult>& results)
+{
+    out << "threshold\ttimeDelay\tdefaultControlSignal\tweights\tsteps\t"
+        << "wall (s)\tend time\tfinal position\tpeak signal\tmean signal\t"
+        << "abort\terror\n";
+    for (const ReflexSweepResult& result : results)
+    {
+        const ReflexParameters& p = result.parameters;
+        out << p.threshold << "\t" << p.timeDelay << "\t"
+            << p.defaultControlSignal << "\t" << formatWeights(p.weights)
+            << "\t" << result.steps << "\t" << result.wallTime << "\t"
+            << result.endTime << "\t" << result.finalPosition << "\t"
+            << result.peakSignal << "\t" << result.meanSignal << "\t"
+            << result.abortReason << "\t" << result.error << "\n";
+    }
+}
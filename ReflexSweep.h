@@ -0,0 +1,230 @@
+#ifndef OPENSIM_ReflexSweep_H_
+#define OPENSIM_ReflexSweep_H_
+/* -------------------------------------------------------------------------- *
+ *                           OpenSim: ReflexSweep.h                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimMuscleReflexCircuitDLL.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+
+namespace OpenSim {
+
+/** One property set of the MuscleReflexCircuit of the tug-of-war model. */
+struct OSIMMUSCLEREFLEXCIRCUIT_API ReflexParameters {
+    double threshold;
+    double timeDelay;
+    double defaultControlSignal;
+    std::vector<double> weights;
+};
+
+/** Conditions that end a tug-of-war run early, checked every report
+    interval: the block position outside [minPosition, maxPosition], the
+    excitation of original1 at or above saturationLevel for longer than
+    maxSaturationTime, a NaN in the states, or a wall time above
+    maxWallTime. The defaults turn off all but the NaN check. */
+struct OSIMMUSCLEREFLEXCIRCUIT_API ReflexAbortCriteria {
+    ReflexAbortCriteria();
+    double minPosition;
+    double maxPosition;
+    double saturationLevel;
+    double maxSaturationTime;
+    bool abortOnNaN;
+    double maxWallTime;
+};
+
+/** Summary of one tug-of-war run. The signal statistics are sampled every
+    report interval up to endTime, which is before the final time if the
+    run was aborted for abortReason. error is empty unless the run threw. */
+struct OSIMMUSCLEREFLEXCIRCUIT_API ReflexSweepResult {
+    ReflexParameters parameters;
+    int steps;
+    double wallTime;
+    double endTime;
+    double finalPosition;
+    double peakSignal;
+    double meanSignal;
+    std::string abortReason;
+    std::string error;
+};
+
+//=============================================================================
+//=============================================================================
+/**
+ * ReflexSweep runs the tug-of-war model of mainSimulation.cpp, original1
+ * driven by its reflex circuit, for every point of a set of
+ * MuscleReflexCircuit property sets, on a pool of threads.
+ *
+ * Each point is an independent simulation: a worker builds its own Model
+ * and State for it, so the workers share nothing but the index of the next
+ * point to run and their own slot of the results. The results come back in
+ * the order of the points, whatever the number of threads.
+ *
+ * A run that makes OpenSim crash or hang would take the whole pool down
+ * with it. runProcesses() runs the points in worker processes instead,
+ * handed out one at a time over pipes by the calling process, which kills
+ * runs that exceed a timeout and retries or records the points whose
+ * worker died.
+ *
+ * The points differ only in the parameters of the circuit, so
+ * runEnsemble() instead advances one model per point in lockstep on a
+ * single thread, all at the same fixed step, and evaluates the circuits of
+ * all points together in a CircuitEnsemble between steps.
+ *
+ * The points are read from a text file of keyword lines. The lines
+ *
+ *     threshold 0.05 0.1 0.2
+ *     timeDelay 0.05 0.1
+ *     defaultControlSignal 0.5
+ *     weights 0.4,0.4,0.2 0.6,0.2,0.2
+ *
+ * span a grid over the product of the values; a parameter without a line
+ * keeps its value of mainSimulation.cpp. A line
+ *
+ *     point 0.1 0.1 0.5 0.4,0.4,0.2
+ *
+ * adds one point with threshold, time delay, default control signal and
+ * weights, after the grid. The lines
+ *
+ *     abort position -0.25 0.25
+ *     abort saturation 1.0 0.5
+ *     abort nan off
+ *     abort wall_time 30
+ *
+ * set the ReflexAbortCriteria of the sweep: the range of the block
+ * position, the saturated excitation level and the time it may last, the
+ * NaN check (on or off) and the wall time budget of a run in seconds. Blank
+ * lines and lines starting with '#' are skipped.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMMUSCLEREFLEXCIRCUIT_API ReflexSweep {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no points, 10 s runs at an accuracy of 1e-6. */
+    ReflexSweep();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** The property set of mainSimulation.cpp. */
+    static ReflexParameters getDefaultParameters();
+
+    /** Drop all points. */
+    void clear();
+    void addPoint(const ReflexParameters& parameters);
+    /** Add the product of the values, threshold varying fastest. */
+    void addGrid(const std::vector<double>& thresholds,
+                 const std::vector<double>& timeDelays,
+                 const std::vector<double>& defaultControlSignals,
+                 const std::vector<std::vector<double> >& weights);
+
+    /** Replace the points and abort criteria with those of a sweep file.
+        Returns false, with the line and reason in message, if the file is
+        malformed. */
+    bool read(std::istream& in, std::string& message);
+
+//--------------------------------------------------------------------------
+// SWEEP ACCESSORS
+//--------------------------------------------------------------------------
+    int getNumPoints() const { return (int)_points.size(); }
+    const ReflexParameters& getPoint(int index) const { return _points[index]; }
+
+    double getFinalTime() const { return _finalTime; }
+    void setFinalTime(double finalTime) { _finalTime = finalTime; }
+    double getAccuracy() const { return _accuracy; }
+    void setAccuracy(double accuracy) { _accuracy = accuracy; }
+    double getReportInterval() const { return _reportInterval; }
+    void setReportInterval(double reportInterval) { _reportInterval = reportInterval; }
+
+    /** Conditions checked every report interval that end a run early. */
+    const ReflexAbortCriteria& getAbortCriteria() const { return _criteria; }
+    void setAbortCriteria(const ReflexAbortCriteria& criteria) { _criteria = criteria; }
+
+//--------------------------------------------------------------------------
+// RUN
+//--------------------------------------------------------------------------
+    /** Run one point on a model and State of its own. */
+    ReflexSweepResult simulate(const ReflexParameters& parameters) const;
+
+    /** Run every point on numThreads workers, or on one per hardware thread
+        if numThreads is not positive. */
+    std::vector<ReflexSweepResult> run(int numThreads) const;
+
+    /** Run every point in numWorkers worker processes, or in one per
+        hardware thread if numWorkers is not positive, so that a run that
+        crashes or hangs takes down only its own worker. A run that takes
+        longer than timeout seconds (none if not positive) is killed. A point
+        whose worker died or was killed is run again in a new worker, up to
+        maxAttempts times, and then reported with the reason in its error.
+        Each worker appends its results to a file of its own in directory,
+        named after the process id of the caller so that concurrent sweeps
+        can share the directory; the files are merged into the results and
+        removed. Needs fork(). */
+    std::vector<ReflexSweepResult> runProcesses(int numWorkers,
+                                                double timeout,
+                                                int maxAttempts,
+                                                const std::string& directory = ".") const;
+
+    /** Run every point in lockstep on the calling thread. Each point has a
+        model of its own, with the circuit left out and original1 excited
+        by an EnsembleController, advanced by a fixed step of stepSize of a
+        Runge-Kutta-Merson integrator. Between steps the afferents of all
+        models are sampled, the circuits of all points are evaluated at
+        once by a CircuitEnsemble and the excitation of each model, the
+        baseline of 0.5 plus its delayed signal, is held over the next
+        step. The signals are sampled and the abort criteria checked every
+        report interval, rounded down to a whole number of steps, and the
+        run ends early once every point has stopped. The accuracy is not
+        used. The wall time of a result is its share of the ensemble's: the
+        time of each report interval divided evenly among the points still
+        running in it, and the wall_time criterion applies to that share. */
+    std::vector<ReflexSweepResult> runEnsemble(double stepSize) const;
+
+    /** Write the results as a tab separated table with a header line. */
+    static void writeTable(std::ostream& out,
+                           const std::vector<ReflexSweepResult>& results);
+
+private:
+    std::vector<ReflexParameters> _points;
+    double _finalTime;
+    double _accuracy;
+    double _reportInterval;
+    ReflexAbortCriteria _criteria;
+
+};  // END of class ReflexSweep
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_ReflexSweep_H_
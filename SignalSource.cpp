@@ -0,0 +1,72 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  SignalSource.cpp                            *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "SignalSource.h"
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+SignalSource::SignalSource()
+{
+    clear();
+}
+
+void SignalSource::clear()
+{
+    _provider = nullptr;
+    _index = -1;
+    _channel = nullptr;
+}
+
+void SignalSource::bind(const Output<double>::Channel& channel)
+{
+    clear();
+    _channel = &channel;
+
+    const AbstractOutput& output = channel.getOutput();
+    const SignalProvider* provider =
+        dynamic_cast<const SignalProvider*>(&output.getOwner());
+    if (!provider)
+        return;
+
+    int index = provider->getSignalIndex(output.getName(),
+                                         channel.getChannelName());
+    if (index >= 0)
+    {
+        _provider = provider;
+        _index = index;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef OPENSIM_SignalSource_H_
+#define OPENSIM_SignalSource_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: SignalSource.h                               *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimDelayDLL.h"
+#include "OpenSim/Common/ComponentOutput.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * SignalProvider is implemented by the components whose outputs a
+ * SignalSource reads through a typed getter rather than through the output
+ * channel. A component names the signals it provides by an index once, when
+ * the source is bound, and returns the value of an index in a State on
+ * every read, so a new component needs no change to SignalSource.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API SignalProvider {
+
+public:
+    virtual ~SignalProvider() {}
+
+    /** Index of the signal read by output outputName of this component,
+        channel channelName (empty for a single value output), or -1 if the
+        output is not provided. */
+    virtual int getSignalIndex(const std::string& outputName,
+                               const std::string& channelName) const = 0;
+    /** Value of the signal at index in s. */
+    virtual double getSignalValue(const SimTK::State& s, int index) const = 0;
+
+};  // END of class SignalProvider
+
+//=============================================================================
+//=============================================================================
+/**
+ * SignalSource is a typed handle on the output channel that feeds an input
+ * of a reflex component.
+ *
+ * Reading an input by name looks the input up in a map and then calls the
+ * output through a std::function on every evaluation. A SignalSource is
+ * bound once, when the system is built. If the output belongs to a
+ * SignalProvider that provides it, the source keeps the provider and the
+ * index of the signal and reads it with a single virtual call. Any other
+ * output is read through its channel.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMDELAY_API SignalSource {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, an unbound source. */
+    SignalSource();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Resolve channel into the getter of the component that owns it. The
+        channel must outlive the binding. */
+    void bind(const Output<double>::Channel& channel);
+    /** Forget the bound channel. */
+    void clear();
+
+//--------------------------------------------------------------------------
+// SIGNAL SOURCE ACCESSORS
+//--------------------------------------------------------------------------
+    bool isBound() const { return _channel != nullptr; }
+    /** Whether the source reads a SignalProvider rather than the channel. */
+    bool isProvided() const { return _provider != nullptr; }
+
+    /** The value of the bound channel in s. Must not be called unbound. */
+    double getValue(const SimTK::State& s) const
+    {
+        return _provider ? _provider->getSignalValue(s, _index) :
+                           _channel->getValue(s);
+    }
+
+private:
+    const SignalProvider* _provider;
+    int _index;
+    const Output<double>::Channel* _channel;
+
+};  // END of class SignalSource
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_SignalSource_H_
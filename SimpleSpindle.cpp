@@ -93,15 +93,26 @@ void SimpleSpindle::constructProperties()
 void SimpleSpindle::extendConnectToModel(Model &model)
 {
     Super::extendConnectToModel(model);
+    
+    _muscle.reset(&getMuscle());
+}
 
+void SimpleSpindle::extendAddToSystem(SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
     
+    // outputs are computed once per realization and counted
+    _lengthCV = addCacheVariable("length", 0.0, SimTK::Stage::Position);
+    _speedCV = addCacheVariable("speed", 0.0, SimTK::Stage::Velocity);
+    _lengthCountCV = addCacheVariable("length_count", OutputCounter(), SimTK::Stage::Topology);
+    _speedCountCV = addCacheVariable("speed_count", OutputCounter(), SimTK::Stage::Topology);
 }
 
 //=============================================================================
 // OUTPUTS
 //=============================================================================
 
-double SimpleSpindle::getSpindleLength(const SimTK::State& s) const
+double SimpleSpindle::computeSpindleLength(const SimTK::State& s) const
 {
     
     double spindle_length = 0;
@@ -114,7 +125,7 @@ double SimpleSpindle::getSpindleLength(const SimTK::State& s) const
     double stretch = 0;
  
 
-    const Muscle& musc = getMuscle();
+    const Muscle& musc = *_muscle;
     // get optimal fiber length and muscle length
     f_o = musc.getOptimalFiberLength();
     length = musc.getLength(s);
@@ -126,7 +137,28 @@ double SimpleSpindle::getSpindleLength(const SimTK::State& s) const
     return spindle_length;
 }
 
-double SimpleSpindle::getSpindleSpeed(const SimTK::State& s) const
+double SimpleSpindle::getSpindleLength(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _lengthCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _lengthCV))
+    {
+        return getCacheVariableValue(s, _lengthCV);
+    }
+    
+    ++counter.numComputed;
+    double spindle_length = computeSpindleLength(s);
+    setCacheVariableValue(s, _lengthCV, spindle_length);
+    return spindle_length;
+}
+
+OutputCounter SimpleSpindle::getSpindleLengthCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _lengthCountCV);
+}
+
+double SimpleSpindle::computeSpindleSpeed(const SimTK::State& s) const
 {
     double spindle_speed = 0;
     double f_o = 1;
@@ -134,7 +166,7 @@ double SimpleSpindle::getSpindleSpeed(const SimTK::State& s) const
     // muscle speed
     double speed = 0;
     // get a reference to the muscle
-    const Muscle& musc = getMuscle();
+    const Muscle& musc = *_muscle;
     // get optimal fiber length
     f_o = musc.getOptimalFiberLength();
     // muscle lengthening speed
@@ -149,6 +181,27 @@ double SimpleSpindle::getSpindleSpeed(const SimTK::State& s) const
     return spindle_speed;
 }
 
+double SimpleSpindle::getSpindleSpeed(const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _speedCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _speedCV))
+    {
+        return getCacheVariableValue(s, _speedCV);
+    }
+    
+    ++counter.numComputed;
+    double spindle_speed = computeSpindleSpeed(s);
+    setCacheVariableValue(s, _speedCV, spindle_speed);
+    return spindle_speed;
+}
+
+OutputCounter SimpleSpindle::getSpindleSpeedCounter(const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _speedCountCV);
+}
+
 //=============================================================================
 // GET AND SET
 //=============================================================================
@@ -161,5 +214,20 @@ const Muscle& SimpleSpindle::getMuscle() const
     return getSocket<Muscle>("muscle").getConnectee();
 }
 
+//=============================================================================
+// SIGNAL PROVIDER
+//=============================================================================
+int SimpleSpindle::getSignalIndex(const std::string& outputName,
+                                  const std::string& channelName) const
+{
+    if (outputName == "spindle_length")
+        return 0;
+    if (outputName == "spindle_speed")
+        return 1;
+    return -1;
+}
 
-
+double SimpleSpindle::getSignalValue(const SimTK::State& s, int index) const
+{
+    return index == 0 ? getSpindleLength(s) : getSpindleSpeed(s);
+}
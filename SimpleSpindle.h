@@ -28,6 +28,8 @@
 // INCLUDE
 //============================================================================
 #include "osimSimpleSpindleDLL.h"
+#include "SignalSource.h"
+#include "OutputCounter.h"
 #include "OpenSim/Simulation/Model/Muscle.h"
 #include "OpenSim/Simulation/Model/ModelComponent.h"
 #include "OpenSim/Simulation/Control/Controller.h"
@@ -49,7 +51,7 @@ namespace OpenSim {
  *
  * @author  Ajay Seth
  */
-class OSIMSIMPLESPINDLE_API SimpleSpindle : public ModelComponent {
+class OSIMSIMPLESPINDLE_API SimpleSpindle : public ModelComponent, public SignalProvider {
 OpenSim_DECLARE_CONCRETE_OBJECT(SimpleSpindle, ModelComponent);
 
 public:
@@ -108,17 +110,40 @@ public:
     Get quanitites of interest common to all spindles*/
     void setSpindleLength(SimTK::State& s, double spindle_length) const;
     double getSpindleLength(const SimTK::State& s) const;
+    // How often spindle_length was computed and read on the lineage of s
+    OutputCounter getSpindleLengthCounter(const SimTK::State& s) const;
     
     void setSpindleSpeed(SimTK::State& s, double spindle_velocity) const;
     double getSpindleSpeed(const SimTK::State& s) const;
-    
+    // How often spindle_speed was computed and read on the lineage of s
+    OutputCounter getSpindleSpeedCounter(const SimTK::State& s) const;
+
+//--------------------------------------------------------------------------
+// SIGNAL PROVIDER
+//--------------------------------------------------------------------------
+    int getSignalIndex(const std::string& outputName,
+                       const std::string& channelName) const override;
+    double getSignalValue(const SimTK::State& s, int index) const override;
 
 
 private:
+    // Evaluate the outputs, called once per realization
+    double computeSpindleLength(const SimTK::State& s) const;
+    double computeSpindleSpeed(const SimTK::State& s) const;
     // Connect properties to local pointers.  */
     void constructProperties();
     // ModelComponent interface to connect this component to its model
     void extendConnectToModel(Model& aModel) override;
+    // Allocate the cached outputs and their counters
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    
+    // The muscle and cache entries, resolved once rather than looked up by
+    // name on every evaluation
+    SimTK::ReferencePtr<const Muscle> _muscle;
+    mutable CacheVariable<double> _lengthCV;
+    mutable CacheVariable<double> _speedCV;
+    mutable CacheVariable<OutputCounter> _lengthCountCV;
+    mutable CacheVariable<OutputCounter> _speedCountCV;
 
     
 protected:
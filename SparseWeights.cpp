@@ -0,0 +1,184 @@
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim:  SparseWeights.cpp                         *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "SparseWeights.h"
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+SparseWeights::SparseWeights()
+{
+    clear();
+}
+
+void SparseWeights::clear()
+{
+    _names.clear();
+    _thresholds.clear();
+    _indices.clear();
+    _rowStart.assign(1, 0);
+    _columns.clear();
+    _weights.clear();
+    _numAfferents = 0;
+}
+
+int SparseWeights::addNeuron(const std::string& name, double threshold)
+{
+    int index = getNumNeurons();
+    _names.push_back(name);
+    _thresholds.push_back(threshold);
+    _indices[name] = index;
+    _rowStart.push_back((int)_weights.size());
+    return index;
+}
+
+void SparseWeights::addWeight(int afferent, double weight)
+{
+    _columns.push_back(afferent);
+    _weights.push_back(weight);
+    _rowStart.back() = (int)_weights.size();
+    _numAfferents = std::max(_numAfferents, afferent + 1);
+}
+
+//=============================================================================
+// WEIGHTS
+//=============================================================================
+
+int SparseWeights::getNeuronIndex(const std::string& name) const
+{
+    auto it = _indices.find(name);
+    return it == _indices.end() ? -1 : it->second;
+}
+
+void SparseWeights::multiply(const double* afferents, double* sums) const
+{
+    const int* rowStart = _rowStart.data();
+    const int* columns = _columns.data();
+    const double* weights = _weights.data();
+    const int n = getNumNeurons();
+    for (int i = 0; i < n; ++i)
+    {
+        double sum = 0;
+        for (int k = rowStart[i]; k < rowStart[i+1]; ++k)
+        {
+            sum += weights[k]*afferents[columns[k]];
+        }
+        sums[i] = sum;
+    }
+}
+
+//=============================================================================
+// FILE
+//=============================================================================
+
+bool SparseWeights::read(std::istream& in, std::string& message)
+{
+    clear();
+    
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#')
+        {
+            continue;
+        }
+        
+        std::ostringstream where;
+        where << "line " << lineNumber << ": ";
+        
+        double threshold;
+        if (!(fields >> threshold))
+        {
+            message = where.str() + "neuron '" + name + "' has no threshold";
+            clear();
+            return false;
+        }
+        if (getNeuronIndex(name) >= 0)
+        {
+            message = where.str() + "neuron '" + name + "' is listed twice";
+            clear();
+            return false;
+        }
+        addNeuron(name, threshold);
+        
+        std::string entry;
+        while (fields >> entry)
+        {
+            std::istringstream pair(entry);
+            int afferent;
+            char colon;
+            double weight;
+            if (!(pair >> afferent >> colon >> weight) || colon != ':' ||
+                afferent < 0 || pair.peek() != std::char_traits<char>::eof())
+            {
+                message = where.str() + "'" + entry +
+                          "' is not an afferent:weight pair";
+                clear();
+                return false;
+            }
+            addWeight(afferent, weight);
+        }
+    }
+    
+    return true;
+}
+
+void SparseWeights::write(std::ostream& out) const
+{
+    std::streamsize precision = out.precision();
+    out.precision(std::numeric_limits<double>::max_digits10);
+    
+    for (int i = 0; i < getNumNeurons(); ++i)
+    {
+        out << _names[i] << " " << _thresholds[i];
+        for (int k = _rowStart[i]; k < _rowStart[i+1]; ++k)
+        {
+            out << " " << _columns[k] << ":" << _weights[k];
+        }
+        out << "\n";
+    }
+    
+    out.precision(precision);
+}
@@ -0,0 +1,123 @@
+#ifndef OPENSIM_SparseWeights_H_
+#define OPENSIM_SparseWeights_H_
+/* -------------------------------------------------------------------------- *
+ *                          OpenSim: SparseWeights.h                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimInterneuronDLL.h"
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * SparseWeights is the weight matrix of an InterneuronNetwork in compressed
+ * sparse row (CSR) form: one row per neuron, with its name and threshold,
+ * and one column per afferent. Only the non-zero weights are stored, row
+ * after row, so the weighted sums of all neurons are one sparse
+ * matrix-vector product whose cost is proportional to the number of
+ * non-zero weights.
+ *
+ * The matrix is built a row at a time: addNeuron() starts a row and
+ * addWeight() appends to the last one. It is read from and written to a
+ * text file with one line per neuron,
+ *
+ *     name threshold afferent:weight afferent:weight ...
+ *
+ * where afferent is the index of the afferent in the order the afferents are
+ * connected. Blank lines and lines starting with '#' are skipped. Weights
+ * may be negative, for inhibition.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMINTERNEURON_API SparseWeights {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no neurons. */
+    SparseWeights();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Drop all neurons and weights. */
+    void clear();
+
+    /** Start the row of a new neuron and return its index. The name must not
+        be taken yet. */
+    int addNeuron(const std::string& name, double threshold);
+    /** Append the weight of afferent to the row of the last neuron. */
+    void addWeight(int afferent, double weight);
+
+//--------------------------------------------------------------------------
+// SPARSE WEIGHTS ACCESSORS
+//--------------------------------------------------------------------------
+    int getNumNeurons() const { return (int)_names.size(); }
+    /** One more than the largest afferent index with a weight. */
+    int getNumAfferents() const { return _numAfferents; }
+    int getNumNonZeros() const { return (int)_weights.size(); }
+
+    const std::string& getNeuronName(int neuron) const { return _names[neuron]; }
+    double getThreshold(int neuron) const { return _thresholds[neuron]; }
+    /** Index of the neuron called name, or -1. */
+    int getNeuronIndex(const std::string& name) const;
+
+    /** Weighted sums of all neurons: sums[i] is the sum over the row of
+        neuron i of weight times afferents[column]. */
+    void multiply(const double* afferents, double* sums) const;
+
+    /** Replace the matrix by the one read from in. Returns false and leaves
+        the matrix empty on a malformed line, with the reason in message. */
+    bool read(std::istream& in, std::string& message);
+    /** Write the matrix in the format read() reads, without loss. */
+    void write(std::ostream& out) const;
+
+private:
+    std::vector<std::string> _names;
+    std::vector<double> _thresholds;
+    std::map<std::string, int> _indices;
+
+    // CSR arrays: the row of neuron i is [_rowStart[i], _rowStart[i+1])
+    std::vector<int> _rowStart;
+    std::vector<int> _columns;
+    std::vector<double> _weights;
+    int _numAfferents;
+
+};  // END of class SparseWeights
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_SparseWeights_H_
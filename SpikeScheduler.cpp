@@ -0,0 +1,272 @@
+/* -------------------------------------------------------------------------- *
+ *                        OpenSim:  SpikeScheduler.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "SpikeScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <utility>
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+SpikeScheduler::SpikeScheduler()
+{
+    reset(std::vector<double>(), 0, 0.01, 0.002, 0.02, 0.05);
+}
+
+void SpikeScheduler::reset(const std::vector<double>& thresholds, double time,
+                           double membraneTimeConstant, double refractoryPeriod,
+                           double spikeDelay, double traceTimeConstant)
+{
+    const int n = (int)thresholds.size();
+    _thresholds = thresholds;
+    _membraneTimeConstant = membraneTimeConstant;
+    _refractoryPeriod = refractoryPeriod;
+    _spikeDelay = spikeDelay;
+    _traceTimeConstant = traceTimeConstant;
+    
+    _drive.assign(n, 0.0);
+    _potential.assign(n, 0.0);
+    _updateTime.assign(n, time);
+    _refractoryEnd.assign(n, time);
+    _version.assign(n, 0);
+    _predicted.assign(n, 0);
+    _trace.assign(n, 0.0);
+    _traceTime.assign(n, time);
+    
+    _queue = std::priority_queue<Event, std::vector<Event>, Later>();
+    _numQueuedStale = 0;
+    _time = time;
+    
+    _numSpikes = 0;
+    _numDeliveries = 0;
+    _numStale = 0;
+}
+
+//=============================================================================
+// EVENTS
+//=============================================================================
+
+void SpikeScheduler::setDrive(int neuron, double drive)
+{
+    if (drive == _drive[neuron])
+    {
+        return;
+    }
+    
+    updatePotential(neuron, _time);
+    _drive[neuron] = drive;
+    
+    // the queued prediction, if any, no longer holds
+    ++_version[neuron];
+    if (_predicted[neuron])
+    {
+        _predicted[neuron] = 0;
+        ++_numQueuedStale;
+    }
+    predict(neuron);
+    
+    if (2*_numQueuedStale > (int)_queue.size())
+    {
+        purge();
+    }
+}
+
+void SpikeScheduler::advanceTo(double time)
+{
+    while (!_queue.empty() && _queue.top().time <= time)
+    {
+        Event event = _queue.top();
+        _queue.pop();
+        
+        if (event.version < 0)
+        {
+            deliver(event.neuron, event.time);
+        }
+        else if (event.version == _version[event.neuron])
+        {
+            _predicted[event.neuron] = 0;
+            fire(event.neuron, event.time);
+        }
+        else
+        {
+            --_numQueuedStale;
+            ++_numStale;
+        }
+    }
+    
+    _time = std::max(_time, time);
+}
+
+double SpikeScheduler::getNextEventTime() const
+{
+    return _queue.empty() ? std::numeric_limits<double>::infinity()
+                          : _queue.top().time;
+}
+
+void SpikeScheduler::updatePotential(int neuron, double time)
+{
+    // held at rest through the refractory period
+    double start = _updateTime[neuron];
+    double v = _potential[neuron];
+    if (start < _refractoryEnd[neuron])
+    {
+        start = _refractoryEnd[neuron];
+        v = 0;
+    }
+    
+    if (time > start)
+    {
+        double drive = _drive[neuron];
+        v = drive + (v - drive)*std::exp(-(time - start)/_membraneTimeConstant);
+    }
+    
+    _potential[neuron] = v;
+    _updateTime[neuron] = time;
+}
+
+void SpikeScheduler::predict(int neuron)
+{
+    double start = std::max(_updateTime[neuron], _refractoryEnd[neuron]);
+    double v = _updateTime[neuron] < _refractoryEnd[neuron] ? 0.0
+                                                             : _potential[neuron];
+    double drive = _drive[neuron];
+    double threshold = _thresholds[neuron];
+    
+    // v approaches the drive, so it only rises to a threshold below it. A
+    // membrane left at the threshold by rounding fires at once, and one
+    // above a threshold it no longer rises to decays without firing
+    if (drive <= threshold)
+    {
+        return;
+    }
+    
+    Event event;
+    event.time = start;
+    if (v < threshold)
+    {
+        event.time += _membraneTimeConstant*std::log((drive - v)/(drive - threshold));
+    }
+    event.neuron = neuron;
+    event.version = _version[neuron];
+    _queue.push(event);
+    _predicted[neuron] = 1;
+}
+
+void SpikeScheduler::fire(int neuron, double time)
+{
+    ++_numSpikes;
+    
+    _potential[neuron] = 0;
+    _updateTime[neuron] = time;
+    _refractoryEnd[neuron] = time + _refractoryPeriod;
+    
+    Event delivery;
+    delivery.time = time + _spikeDelay;
+    delivery.neuron = neuron;
+    delivery.version = -1;
+    _queue.push(delivery);
+    
+    predict(neuron);
+}
+
+void SpikeScheduler::deliver(int neuron, double time)
+{
+    ++_numDeliveries;
+    
+    _trace[neuron] = getTrace(neuron, time) + 1/_traceTimeConstant;
+    _traceTime[neuron] = time;
+}
+
+void SpikeScheduler::purge()
+{
+    std::vector<Event> live;
+    live.reserve(_queue.size() - _numQueuedStale);
+    while (!_queue.empty())
+    {
+        const Event& event = _queue.top();
+        if (event.version < 0 || event.version == _version[event.neuron])
+        {
+            live.push_back(event);
+        }
+        else
+        {
+            ++_numStale;
+        }
+        _queue.pop();
+    }
+    
+    _queue = std::priority_queue<Event, std::vector<Event>, Later>(
+        Later(), std::move(live));
+    _numQueuedStale = 0;
+}
+
+//=============================================================================
+// OUTPUT
+//=============================================================================
+
+double SpikeScheduler::getTrace(int neuron, double time) const
+{
+    return _trace[neuron]*
+           std::exp(-(time - _traceTime[neuron])/_traceTimeConstant);
+}
+
+double SpikeScheduler::getPotential(int neuron) const
+{
+    double start = _updateTime[neuron];
+    double v = _potential[neuron];
+    if (start < _refractoryEnd[neuron])
+    {
+        if (_time <= _refractoryEnd[neuron])
+        {
+            return 0;
+        }
+        start = _refractoryEnd[neuron];
+        v = 0;
+    }
+    double drive = _drive[neuron];
+    return drive + (v - drive)*std::exp(-(_time - start)/_membraneTimeConstant);
+}
+
+std::ostream& OpenSim::operator<<(std::ostream& out,
+                                  const SpikeScheduler& scheduler)
+{
+    return out << "SpikeScheduler(neurons=" << scheduler.getNumNeurons()
+               << ", spikes=" << scheduler.getNumSpikes()
+               << ", queued=" << scheduler.getQueueSize() << ")";
+}
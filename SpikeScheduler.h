@@ -0,0 +1,178 @@
+#ifndef OPENSIM_SpikeScheduler_H_
+#define OPENSIM_SpikeScheduler_H_
+/* -------------------------------------------------------------------------- *
+ *                         OpenSim: SpikeScheduler.h                          *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimInterneuronDLL.h"
+#include <iosfwd>
+#include <queue>
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * SpikeScheduler runs a layer of leaky integrate-and-fire neurons event by
+ * event. Each neuron integrates a drive, the rate-coded weighted sum of its
+ * afferents, held constant until it is set again:
+ *
+ *     v' = (drive - v)/membraneTimeConstant,
+ *
+ * fires when v rises to its threshold, is reset to 0 and held there for the
+ * refractory period. A neuron only fires while its drive is above its
+ * threshold, so the thresholds and the refractory period must be positive
+ * for a neuron at rest to stay silent and for its rate to be bounded.
+ * Every spike is delivered to the output of the neuron after the spike
+ * delay, where it adds 1/traceTimeConstant to an exponentially decaying
+ * trace, an estimate of the firing rate in spikes per second.
+ *
+ * Between events the membrane and the trace are solved in closed form, so
+ * nothing is integrated. The time of the next spike of each neuron follows
+ * from its drive and is put in a time-ordered priority queue together with
+ * the pending deliveries. advanceTo() pops and processes the events that
+ * fall due, in time order and at their exact times. A neuron only does work
+ * when it spikes, receives a delivery or has its drive changed, so the cost
+ * is proportional to the number of spikes rather than to the neurons times
+ * the evaluations.
+ *
+ * Setting a drive replaces the predicted spike of the neuron. The old entry
+ * is left in the queue, marked stale by a version number and dropped when
+ * it is popped; the queue is rebuilt once more than half of it is stale.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMINTERNEURON_API SpikeScheduler {
+
+public:
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no neurons. */
+    SpikeScheduler();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Rest all neurons, with the given thresholds, at time with no drive,
+        and drop all events and counters. */
+    void reset(const std::vector<double>& thresholds, double time,
+               double membraneTimeConstant, double refractoryPeriod,
+               double spikeDelay, double traceTimeConstant);
+
+//--------------------------------------------------------------------------
+// SPIKE SCHEDULER ACCESSORS
+//--------------------------------------------------------------------------
+    /** Drive neuron with drive from getTime() on. Call advanceTo() first to
+        process the events up to the time of the change. */
+    void setDrive(int neuron, double drive);
+    /** Process every event at or before time, in time order. */
+    void advanceTo(double time);
+
+    int getNumNeurons() const { return (int)_thresholds.size(); }
+    double getTime() const { return _time; }
+    double getDrive(int neuron) const { return _drive[neuron]; }
+    /** Time of the next event in the queue, infinite when it is empty. */
+    double getNextEventTime() const;
+
+    /** The output trace of neuron at time, no earlier than getTime(). Only
+        the deliveries processed by advanceTo() are included. */
+    double getTrace(int neuron, double time) const;
+    /** The membrane potential of neuron at getTime(). */
+    double getPotential(int neuron) const;
+
+    long long getNumSpikes() const { return _numSpikes; }
+    long long getNumDeliveries() const { return _numDeliveries; }
+    /** Stale predictions popped or purged from the queue. */
+    long long getNumStale() const { return _numStale; }
+    int getQueueSize() const { return (int)_queue.size(); }
+
+private:
+    // A predicted spike of a neuron (version >= 0), valid while the version
+    // of the neuron is unchanged, or the delivery of a spike (version -1)
+    struct Event {
+        double time;
+        int neuron;
+        int version;
+    };
+    // orders the queue with the earliest event on top
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const
+        {
+            return a.time > b.time;
+        }
+    };
+
+    // bring the membrane of neuron from its last update to time
+    void updatePotential(int neuron, double time);
+    // queue the next spike of neuron, if its drive is above the threshold
+    void predict(int neuron);
+    // process one event popped from the queue
+    void fire(int neuron, double time);
+    void deliver(int neuron, double time);
+    // drop the stale predictions from the queue
+    void purge();
+
+    std::vector<double> _thresholds;
+    double _membraneTimeConstant;
+    double _refractoryPeriod;
+    double _spikeDelay;
+    double _traceTimeConstant;
+
+    // Per neuron: the drive, the membrane at its last update, the end of
+    // the refractory period, the version of its prediction and whether it
+    // is queued, and the trace at the last delivery
+    std::vector<double> _drive;
+    std::vector<double> _potential;
+    std::vector<double> _updateTime;
+    std::vector<double> _refractoryEnd;
+    std::vector<int> _version;
+    std::vector<char> _predicted;
+    std::vector<double> _trace;
+    std::vector<double> _traceTime;
+
+    std::priority_queue<Event, std::vector<Event>, Later> _queue;
+    int _numQueuedStale;
+    double _time;
+
+    long long _numSpikes;
+    long long _numDeliveries;
+    long long _numStale;
+
+};  // END of class SpikeScheduler
+
+// Needed to store a SpikeScheduler in a SimTK::Value
+OSIMINTERNEURON_API std::ostream& operator<<(std::ostream& out,
+                                             const SpikeScheduler& scheduler);
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_SpikeScheduler_H_
@@ -0,0 +1,243 @@
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim:  SpindleDynamics.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "SpindleDynamics.h"
+#include <algorithm>
+#include <cmath>
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// PARAMETERS
+//=============================================================================
+
+namespace {
+    
+    // Intrafusal fibre parameters of Mileusnic et al. (2006), Table 1
+    struct Fibre {
+        double KSR;             // sensory region stiffness
+        double KPR;             // polar region stiffness
+        double M;               // mass
+        double beta0;           // passive viscosity
+        double betaActive;      // viscosity per unit of fusimotor activation
+        double gammaActive;     // force per unit of fusimotor activation
+        double L0SR;            // sensory region rest length
+        double L0PR;            // polar region rest length
+        double R;               // fascicle length below which force is 0
+        double primaryGain;     // Ia firing per unit of stretch
+        double secondaryGain;   // II firing per unit of stretch
+    };
+    
+    const Fibre bag1 = {10.4649, 0.15, 0.0002, 0.0605, 0.2592, 0.0289,
+                        0.04, 0.76, 0.46, 20000, 0};
+    const Fibre bag2 = {10.4649, 0.15, 0.0002, 0.0822, -0.046, 0.0636,
+                        0.04, 0.76, 0.46, 10000, 7250};
+    const Fibre chain = {10.4649, 0.15, 0.0002, 0.0822, -0.069, 0.0954,
+                         0.04, 0.76, 0.46, 10000, 7250};
+    
+    // sensory region threshold length, polar region threshold length
+    const double LNSR0 = 0.0423;
+    const double LNPR0 = 0.89;
+    // secondary afferent: share of the sensory region and its length
+    const double X = 0.7;
+    const double Lsecondary = 0.04;
+    // partial occlusion of the weaker primary afferent
+    const double S = 0.156;
+    
+    // activation dynamics: drive frequency of half activation, exponent,
+    // and time constants of bag1 and bag2
+    const double bag1Frequency = 60, bag2Frequency = 60, chainFrequency = 90;
+    const double exponent = 2;
+    const double bag1TimeConstant = 0.149, bag2TimeConstant = 0.205;
+    
+    double settledActivation(double drive, double frequency)
+    {
+        double d = std::pow(drive, exponent);
+        return d/(d + std::pow(frequency, exponent));
+    }
+    
+    // T'' of a fibre, the tension rate derivative
+    double tensionAcceleration(const Fibre& f, double T, double Td,
+                               double activation, double x, double v)
+    {
+        double u = T/f.KSR;
+        double w = Td/f.KSR;
+        double beta = f.beta0 + f.betaActive*activation;
+        double gamma = f.gammaActive*activation;
+        double D = x - f.L0SR - u - f.R;
+        double E = x - f.L0SR - u - f.L0PR;
+        return f.KSR/f.M*(beta*(v - w)*D + f.KPR*E + gamma - T);
+    }
+    
+    // the row of T'' in the Jacobian: its derivatives by T, T' and the
+    // activation
+    void tensionAccelerationGradient(const Fibre& f, double T, double Td,
+                                     double activation, double x, double v,
+                                     double& dT, double& dTd, double& dA)
+    {
+        double k = f.KSR/f.M;
+        double u = T/f.KSR;
+        double w = Td/f.KSR;
+        double beta = f.beta0 + f.betaActive*activation;
+        double D = x - f.L0SR - u - f.R;
+        dT = k*(-beta*(v - w)/f.KSR - f.KPR/f.KSR - 1);
+        dTd = -k*beta*D/f.KSR;
+        dA = k*(f.betaActive*(v - w)*D + f.gammaActive);
+    }
+    
+    double restTension(const Fibre& f, double activation, double x)
+    {
+        return (f.KPR*(x - f.L0SR - f.L0PR) + f.gammaActive*activation)/
+               (1 + f.KPR/f.KSR);
+    }
+    
+    double sensoryStretch(const Fibre& f, double T)
+    {
+        return T/f.KSR - (LNSR0 - f.L0SR);
+    }
+    
+}
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+SpindleDynamics::SpindleDynamics()
+{
+    setFusimotorDrive(0, 0);
+}
+
+void SpindleDynamics::setFusimotorDrive(double dynamicDrive, double staticDrive)
+{
+    _dynamicDrive = dynamicDrive;
+    _staticDrive = staticDrive;
+    _chainActivation = settledActivation(staticDrive, chainFrequency);
+}
+
+//=============================================================================
+// SPINDLE DYNAMICS
+//=============================================================================
+
+void SpindleDynamics::computeRestState(double length, double* y) const
+{
+    double a1 = settledActivation(_dynamicDrive, bag1Frequency);
+    double a2 = settledActivation(_staticDrive, bag2Frequency);
+    
+    y[Bag1Tension] = restTension(bag1, a1, length);
+    y[Bag1TensionRate] = 0;
+    y[Bag2Tension] = restTension(bag2, a2, length);
+    y[Bag2TensionRate] = 0;
+    y[ChainTension] = restTension(chain, _chainActivation, length);
+    y[ChainTensionRate] = 0;
+    y[Bag1Activation] = a1;
+    y[Bag2Activation] = a2;
+}
+
+void SpindleDynamics::computeDerivatives(const double* y, double length,
+                                         double speed, double* dy) const
+{
+    dy[Bag1Tension] = y[Bag1TensionRate];
+    dy[Bag1TensionRate] = tensionAcceleration(bag1, y[Bag1Tension],
+        y[Bag1TensionRate], y[Bag1Activation], length, speed);
+    dy[Bag2Tension] = y[Bag2TensionRate];
+    dy[Bag2TensionRate] = tensionAcceleration(bag2, y[Bag2Tension],
+        y[Bag2TensionRate], y[Bag2Activation], length, speed);
+    dy[ChainTension] = y[ChainTensionRate];
+    dy[ChainTensionRate] = tensionAcceleration(chain, y[ChainTension],
+        y[ChainTensionRate], _chainActivation, length, speed);
+    
+    dy[Bag1Activation] = (settledActivation(_dynamicDrive, bag1Frequency) -
+                          y[Bag1Activation])/bag1TimeConstant;
+    dy[Bag2Activation] = (settledActivation(_staticDrive, bag2Frequency) -
+                          y[Bag2Activation])/bag2TimeConstant;
+}
+
+void SpindleDynamics::computeJacobian(const double* y, double length,
+                                      double speed, double* jacobian) const
+{
+    std::fill(jacobian, jacobian + NumStates*NumStates, 0.0);
+    double* row;
+    double dA;
+    
+    jacobian[Bag1Tension*NumStates + Bag1TensionRate] = 1;
+    row = jacobian + Bag1TensionRate*NumStates;
+    tensionAccelerationGradient(bag1, y[Bag1Tension], y[Bag1TensionRate],
+        y[Bag1Activation], length, speed,
+        row[Bag1Tension], row[Bag1TensionRate], dA);
+    row[Bag1Activation] = dA;
+    
+    jacobian[Bag2Tension*NumStates + Bag2TensionRate] = 1;
+    row = jacobian + Bag2TensionRate*NumStates;
+    tensionAccelerationGradient(bag2, y[Bag2Tension], y[Bag2TensionRate],
+        y[Bag2Activation], length, speed,
+        row[Bag2Tension], row[Bag2TensionRate], dA);
+    row[Bag2Activation] = dA;
+    
+    // the chain activation is not a state
+    jacobian[ChainTension*NumStates + ChainTensionRate] = 1;
+    row = jacobian + ChainTensionRate*NumStates;
+    tensionAccelerationGradient(chain, y[ChainTension], y[ChainTensionRate],
+        _chainActivation, length, speed,
+        row[ChainTension], row[ChainTensionRate], dA);
+    
+    jacobian[Bag1Activation*NumStates + Bag1Activation] = -1/bag1TimeConstant;
+    jacobian[Bag2Activation*NumStates + Bag2Activation] = -1/bag2TimeConstant;
+}
+
+//=============================================================================
+// AFFERENTS
+//=============================================================================
+
+double SpindleDynamics::getPrimaryAfferent(const double* y) const
+{
+    double r1 = bag1.primaryGain*std::max(sensoryStretch(bag1, y[Bag1Tension]), 0.0);
+    double r2 = bag2.primaryGain*std::max(sensoryStretch(bag2, y[Bag2Tension]), 0.0)
+              + chain.primaryGain*std::max(sensoryStretch(chain, y[ChainTension]), 0.0);
+    return std::max(r1, r2) + S*std::min(r1, r2);
+}
+
+double SpindleDynamics::getSecondaryAfferent(const double* y, double length) const
+{
+    double rate = 0;
+    const Fibre* fibres[] = {&bag2, &chain};
+    const double tensions[] = {y[Bag2Tension], y[ChainTension]};
+    for (int i = 0; i < 2; ++i)
+    {
+        const Fibre& f = *fibres[i];
+        double T = tensions[i];
+        double polarStretch = length - T/f.KSR - f.L0SR - LNPR0;
+        rate += f.secondaryGain*(X*Lsecondary/f.L0SR*sensoryStretch(f, T) +
+                                 (1 - X)*Lsecondary/f.L0PR*polarStretch);
+    }
+    return std::max(rate, 0.0);
+}
@@ -0,0 +1,132 @@
+#ifndef OPENSIM_SpindleDynamics_H_
+#define OPENSIM_SpindleDynamics_H_
+/* -------------------------------------------------------------------------- *
+ *                         OpenSim: SpindleDynamics.h                         *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimSimpleSpindleDLL.h"
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * SpindleDynamics holds the equations of the intrafusal fibres of a muscle
+ * spindle in the style of Mileusnic et al. (2006), J Neurophysiol 96:1772.
+ * The bag1, bag2 and chain fibres each have a sensory region of stiffness
+ * K_SR in series with a polar region of stiffness K_PR and fusimotor
+ * dependent viscosity beta and force Gamma. The tension T of the sensory
+ * region of each fibre follows
+ *
+ *     T'' = K_SR/M [beta (v - T'/K_SR)(x - L0_SR - T/K_SR - R)
+ *                   + K_PR (x - L0_SR - T/K_SR - L0_PR) + Gamma - T],
+ *
+ * with x and v the fibre length and lengthening speed of the muscle, both
+ * normalized by its optimal fibre length. The dynamic (bag1) and static
+ * (bag2) fusimotor activations follow first order dynamics toward
+ * drive^2/(drive^2 + freq^2); the chain fibre takes the static activation
+ * without lag. The parameters are those of Mileusnic et al. The viscosity is
+ * linear in the speed rather than a fractional power, and the same in
+ * lengthening and shortening, and the term of the fibre acceleration is
+ * left out, so the derivatives are smooth and the Jacobian exists
+ * everywhere.
+ *
+ * The primary (Ia) afferent combines the sensory region stretch of bag1 with
+ * that of bag2 and chain with partial occlusion; the secondary (II)
+ * afferent sums the sensory and polar region stretch of bag2 and chain.
+ * Both are firing rates in spikes per second.
+ *
+ * The states are in the order of StateIndex. The Jacobian of the
+ * derivatives with respect to the states is computed in closed form, in
+ * row major order.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMSIMPLESPINDLE_API SpindleDynamics {
+
+public:
+    /** Order of the states. */
+    enum StateIndex {
+        Bag1Tension,
+        Bag1TensionRate,
+        Bag2Tension,
+        Bag2TensionRate,
+        ChainTension,
+        ChainTensionRate,
+        Bag1Activation,
+        Bag2Activation,
+        NumStates
+    };
+
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no fusimotor drive. */
+    SpindleDynamics();
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+    /** Dynamic and static fusimotor drive, in pulses per second. */
+    void setFusimotorDrive(double dynamicDrive, double staticDrive);
+    double getDynamicDrive() const { return _dynamicDrive; }
+    double getStaticDrive() const { return _staticDrive; }
+
+//--------------------------------------------------------------------------
+// SPINDLE DYNAMICS
+//--------------------------------------------------------------------------
+    /** The states at rest at the normalized fibre length, with the
+        activations settled on the drive. */
+    void computeRestState(double length, double* y) const;
+
+    /** Time derivatives dy of the states y at the normalized fibre length
+        and lengthening speed. */
+    void computeDerivatives(const double* y, double length, double speed,
+                            double* dy) const;
+    /** Jacobian of computeDerivatives() with respect to y, NumStates by
+        NumStates in row major order. */
+    void computeJacobian(const double* y, double length, double speed,
+                         double* jacobian) const;
+
+    /** Primary (Ia) and secondary (II) afferent firing rates. */
+    double getPrimaryAfferent(const double* y) const;
+    double getSecondaryAfferent(const double* y, double length) const;
+
+private:
+    double _dynamicDrive;
+    double _staticDrive;
+    // the chain activation, which follows the static drive without lag
+    double _chainActivation;
+
+};  // END of class SpindleDynamics
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_SpindleDynamics_H_
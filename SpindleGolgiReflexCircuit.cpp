@@ -0,0 +1,94 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  SpindleGolgiReflexCircuit.cpp               *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "SpindleGolgiReflexCircuit.h"
+#include <OpenSim/OpenSim.h>
+
+
+
+// This allows us to use OpenSim functions, classes, etc., without having to
+// prefix the names of those things with "OpenSim::".
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+SpindleGolgiReflexCircuit::SpindleGolgiReflexCircuit()
+{
+}
+
+/* Convenience constructor. */
+SpindleGolgiReflexCircuit::SpindleGolgiReflexCircuit(const std::string& name,
+                                                     const Muscle& muscle,
+                                                     const SimpleSpindle& spindle,
+                                                     const GolgiTendon& golgi,
+                                                     double threshold,
+                                                     double timeDelay,
+                                                     double defaultControlSignal) :
+    Super(name, muscle, threshold, timeDelay, defaultControlSignal)
+{
+    connectSocket_spindle(spindle);
+    connectSocket_golgi(golgi);
+}
+
+//=============================================================================
+// SETUP
+//=============================================================================
+
+void SpindleGolgiReflexCircuit::extendConnectToModel(Model& model)
+{
+    Super::extendConnectToModel(model);
+    
+    // connect the afferents to the spindle and golgi outputs, dropping the
+    // connections of any earlier call
+    const SimpleSpindle& spindle = getSpindle();
+    const GolgiTendon& golgi = getGolgi();
+    
+    updInput("afferents").disconnect();
+    updInput("afferents").connect(spindle.getOutput("spindle_length"));
+    updInput("afferents").connect(spindle.getOutput("spindle_speed"));
+    updInput("afferents").connect(golgi.getOutput("golgiLength"));
+}
+
+//-----------------------------------------------------------------------------
+// SOCKETS
+//-----------------------------------------------------------------------------
+const SimpleSpindle& SpindleGolgiReflexCircuit::getSpindle() const
+{
+    return getSocket<SimpleSpindle>("spindle").getConnectee();
+}
+
+const GolgiTendon& SpindleGolgiReflexCircuit::getGolgi() const
+{
+    return getSocket<GolgiTendon>("golgi").getConnectee();
+}
@@ -0,0 +1,120 @@
+#ifndef OPENSIM_SpindleGolgiReflexCircuit_H_
+#define OPENSIM_SpindleGolgiReflexCircuit_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: SpindleGolgiReflexCircuit.h                  *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimMuscleReflexCircuitDLL.h"
+#include "StaticReflexCircuit.h"
+#include "SimpleSpindle.h"
+#include "GolgiTendon.h"
+
+
+
+namespace OpenSim {
+
+// The afferents of the circuit MuscleReflexCircuit builds by default
+struct SpindleLengthAfferent :
+    ReflexAfferent<SimpleSpindle, &SimpleSpindle::getSpindleLength> {
+    static const char* getOutputName() { return "spindle_length"; }
+};
+
+struct SpindleSpeedAfferent :
+    ReflexAfferent<SimpleSpindle, &SimpleSpindle::getSpindleSpeed> {
+    static const char* getOutputName() { return "spindle_speed"; }
+};
+
+struct TendonLengthAfferent :
+    ReflexAfferent<GolgiTendon, &GolgiTendon::getTendonLength> {
+    static const char* getOutputName() { return "golgiLength"; }
+};
+
+// The circuit MuscleReflexCircuit builds by default: spindle length,
+// spindle speed and Golgi length, with a linearly interpolated delay
+typedef StaticReflexCircuit<DelayLine::Linear, SpindleLengthAfferent,
+    SpindleSpeedAfferent, TendonLengthAfferent> SpindleGolgiStaticCircuit;
+
+//=============================================================================
+//=============================================================================
+/**
+ * SpindleGolgiReflexCircuit is the StaticReflexCircuit of the three input
+ * circuit that MuscleReflexCircuit builds: the spindle_length and
+ * spindle_speed outputs of a SimpleSpindle and the golgiLength output of a
+ * GolgiTendon, weighted in that order and delayed with linear
+ * interpolation. The afferents are connected to the spindle and golgi
+ * sockets when the model is connected.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMMUSCLEREFLEXCIRCUIT_API SpindleGolgiReflexCircuit :
+    public SpindleGolgiStaticCircuit {
+OpenSim_DECLARE_CONCRETE_OBJECT(SpindleGolgiReflexCircuit, SpindleGolgiStaticCircuit);
+
+public:
+//==============================================================================
+// SOCKETS
+//==============================================================================
+    OpenSim_DECLARE_SOCKET(spindle, SimpleSpindle, "The spindle that is sending out muscle length and muscle lengthening speed");
+    
+    OpenSim_DECLARE_SOCKET(golgi, GolgiTendon, "The Golgi-Tendon Organ that is sending out muscle tendon length");
+    
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    SpindleGolgiReflexCircuit();
+    SpindleGolgiReflexCircuit(const std::string& name,
+                              const Muscle& muscle,
+                              const SimpleSpindle& spindle,
+                              const GolgiTendon& golgi,
+                              double threshold,
+                              double timeDelay,
+                              double defaultControlSignal);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+    
+    const SimpleSpindle& getSpindle() const;
+    const GolgiTendon& getGolgi() const;
+    
+
+private:
+    // Connect the afferents to the spindle and golgi outputs
+    void extendConnectToModel(Model& model) override;
+    
+    
+protected:
+    //=========================================================================
+};  // END of class SpindleGolgiReflexCircuit
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_SpindleGolgiReflexCircuit_H_
@@ -0,0 +1,459 @@
+#ifndef OPENSIM_StaticReflexCircuit_H_
+#define OPENSIM_StaticReflexCircuit_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: StaticReflexCircuit.h                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "OutputCounter.h"
+#include "DelayLine.h"
+#include "OpenSim/Simulation/Model/Muscle.h"
+#include "OpenSim/Simulation/Model/Model.h"
+#include "OpenSim/Simulation/Model/ModelComponent.h"
+#include <array>
+#include <tuple>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * ReflexAfferent names the getter through which a StaticReflexCircuit reads
+ * one of its afferents: the component type Source that owns the output and
+ * its member function Getter. A concrete afferent derives from one
+ * instantiation and adds the name of the output the getter computes,
+ *
+ *     struct SpindleLengthAfferent :
+ *         ReflexAfferent<SimpleSpindle, &SimpleSpindle::getSpindleLength> {
+ *         static const char* getOutputName() { return "spindle_length"; }
+ *     };
+ *
+ * so that the circuit can check the connected channel when it binds it.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+template <class Source, double (Source::*Getter)(const SimTK::State&) const>
+struct ReflexAfferent {
+    typedef Source SourceType;
+
+    static double getValue(const Source& source, const SimTK::State& s)
+    {
+        return (source.*Getter)(s);
+    }
+};
+
+// Binds and sums the afferents from index I on, one template instance per
+// afferent so that both unroll at compile time
+template <int I, class... Afferents>
+struct StaticAfferents {
+    template <class Sources>
+    static void bind(const Component& owner, const Input<double>& input,
+                     Sources& sources) {}
+
+    template <class Sources, std::size_t N>
+    static double sum(double partial, const std::array<double, N>& weights,
+                      const Sources& sources, const SimTK::State& s)
+    {
+        return partial;
+    }
+};
+
+template <int I, class Afferent, class... Rest>
+struct StaticAfferents<I, Afferent, Rest...> {
+    typedef typename Afferent::SourceType Source;
+
+    template <class Sources>
+    static void bind(const Component& owner, const Input<double>& input,
+                     Sources& sources)
+    {
+        const AbstractOutput& output = input.getChannel(I).getOutput();
+        const Source* source = dynamic_cast<const Source*>(&output.getOwner());
+        OPENSIM_THROW_IF(source == nullptr || output.getName() != Afferent::getOutputName(), Exception, owner.getName() + ": afferent " + std::to_string(I) + " must be the " + Afferent::getOutputName() + " output of a " + Source::getClassName());
+        std::get<I>(sources) = source;
+
+        StaticAfferents<I + 1, Rest...>::bind(owner, input, sources);
+    }
+
+    template <class Sources, std::size_t N>
+    static double sum(double partial, const std::array<double, N>& weights,
+                      const Sources& sources, const SimTK::State& s)
+    {
+        // summed in the order of the afferents, as Interneuron does
+        partial += weights[I]*Afferent::getValue(*std::get<I>(sources), s);
+        return StaticAfferents<I + 1, Rest...>::sum(partial, weights,
+                                                    sources, s);
+    }
+};
+
+//=============================================================================
+//=============================================================================
+/**
+ * StaticReflexCircuit is a reflex circuit whose shape is fixed at compile
+ * time: an interneuron summing one weighted afferent per ReflexAfferent in
+ * Afferents, then a delay whose history is rebuilt with the DelayKernel
+ * interpolation.
+ *
+ * MuscleReflexCircuit assembles the same chain from an Interneuron with a
+ * list input and a list of weights and a Delay that picks its kernel at run
+ * time. Here the weights are copied into a fixed-size array when the
+ * properties are finalized and the owner of each afferent channel is bound
+ * to its source type when the system is built, so the weighted sum unrolls
+ * into direct calls of the afferent getters, and the interpolation kernel is
+ * inlined into the lookup. The properties are the usual ones, so the circuit
+ * reads and writes .osim files like any other component.
+ *
+ * The template has no class name of its own for .osim files; a concrete
+ * circuit derives from one instantiation and gives it a name, as
+ * SpindleGolgiReflexCircuit does for the three input spindle and Golgi
+ * circuit.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+class StaticReflexCircuit : public ModelComponent {
+OpenSim_DECLARE_ABSTRACT_OBJECT(StaticReflexCircuit, ModelComponent);
+
+public:
+    static const int NumAfferents = sizeof...(Afferents);
+    static const DelayLine::Interpolation Kernel = DelayKernel;
+
+//=============================================================================
+// INPUT
+//=============================================================================
+    OpenSim_DECLARE_LIST_INPUT(afferents, double, SimTK::Stage::Velocity,
+        "The afferent signals weighted by the interneuron, the outputs named by the afferent types in order");
+
+//=============================================================================
+// PROPERTIES
+//=============================================================================
+    OpenSim_DECLARE_PROPERTY(threshold, double, "The weighted sum of the afferents above which the interneuron sends its signal");
+
+    OpenSim_DECLARE_LIST_PROPERTY_SIZE(weights, double, NumAfferents, "The weights given to the afferent signals, one per afferent, between 0 and 1 and summing to at most 1");
+
+    OpenSim_DECLARE_PROPERTY(timeDelay, double, "The time delay (seconds) between the interneuron signal and the muscle signal");
+
+    OpenSim_DECLARE_PROPERTY(defaultControlSignal, double, "The muscle signal sent until the delayed signal is available");
+
+    OpenSim_DECLARE_PROPERTY(minimum_step_size, double, "The smallest time step (seconds) the integrator is expected to take, used to size the signal history");
+
+//==============================================================================
+// SOCKETS
+//==============================================================================
+    OpenSim_DECLARE_SOCKET(muscle, Muscle, "The muscle that is being controlled");
+
+//=============================================================================
+// OUTPUTS
+//=============================================================================
+    OpenSim_DECLARE_OUTPUT(signal, double, getSignal, SimTK::Stage::Velocity);
+
+    OpenSim_DECLARE_OUTPUT(muscle_signal, double, getMuscleSignal, SimTK::Stage::Velocity);
+//=============================================================================
+// METHODS
+//=============================================================================
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor. */
+    StaticReflexCircuit();
+    StaticReflexCircuit(const std::string& name,
+                        const Muscle& muscle,
+                        double threshold,
+                        double timeDelay,
+                        double defaultControlSignal);
+
+    // Uses default (compiler-generated) destructor, copy constructor and copy
+    // assignment operator.
+
+//--------------------------------------------------------------------------
+// STATIC REFLEX CIRCUIT ACCESSORS
+//--------------------------------------------------------------------------
+    const Muscle& getMuscle() const;
+
+    /** The undelayed interneuron signal. */
+    double getSignal(const SimTK::State& s) const;
+    // How often signal was computed and read on the lineage of s
+    OutputCounter getSignalCounter(const SimTK::State& s) const;
+    /** The interneuron signal delayed by timeDelay. */
+    double getMuscleSignal(const SimTK::State& s) const;
+    // How often muscle_signal was computed and read on the lineage of s
+    OutputCounter getMuscleSignalCounter(const SimTK::State& s) const;
+
+
+protected:
+    // Check the properties and copy the weights into the fixed array
+    void extendFinalizeFromProperties() override;
+    // Allocate the cached outputs and their counters
+    void extendAddToSystem(SimTK::MultibodySystem& system) const override;
+    // Bind the afferents and allocate the signal history in the State
+    void extendRealizeTopology(SimTK::State& s) const override;
+    // Sample the signal on every step even when nothing reads the output
+    void extendRealizeAcceleration(const SimTK::State& s) const override;
+
+private:
+    // Connect properties to local pointers.  */
+    void constructProperties();
+
+    // The history that will replace the committed one if the current step
+    // is accepted, with the signal at the current time pending
+    const DelayHistory& getUpdatedHistory(const SimTK::State& s) const;
+
+    // Parameters, copied from the properties
+    std::array<double, NumAfferents> _weights;
+    double _threshold;
+    double _delay;
+    double _defaultSignal;
+
+    // The owners of the afferent channels, cache entries and auto-update
+    // discrete variable holding the DelayHistory, resolved when the system
+    // is built
+    mutable std::tuple<const typename Afferents::SourceType*...> _sources;
+    mutable CacheVariable<double> _signalCV;
+    mutable CacheVariable<OutputCounter> _signalCountCV;
+    mutable CacheVariable<double> _muscleSignalCV;
+    mutable CacheVariable<OutputCounter> _muscleSignalCountCV;
+    mutable SimTK::DiscreteVariableIndex _historyIndex;
+
+
+    //=========================================================================
+};  // END of class StaticReflexCircuit
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+StaticReflexCircuit<DelayKernel, Afferents...>::StaticReflexCircuit() :
+    _threshold(0),
+    _delay(0),
+    _defaultSignal(0)
+{
+    static_assert(NumAfferents > 0, "A reflex circuit needs an afferent");
+
+    _weights.fill(0);
+    constructProperties();
+}
+
+/* Convenience constructor. */
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+StaticReflexCircuit<DelayKernel, Afferents...>::StaticReflexCircuit(
+        const std::string& name,
+        const Muscle& muscle,
+        double threshold,
+        double timeDelay,
+        double defaultControlSignal) :
+    StaticReflexCircuit()
+{
+    OPENSIM_THROW_IF(name.empty(), ComponentHasNoName, getClassName());
+
+    setName(name);
+    connectSocket_muscle(muscle);
+
+    set_threshold(threshold);
+    set_timeDelay(timeDelay);
+    set_defaultControlSignal(defaultControlSignal);
+}
+
+//=============================================================================
+// SETUP PROPERTIES
+//=============================================================================
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+void StaticReflexCircuit<DelayKernel, Afferents...>::constructProperties()
+{
+    constructProperty_threshold(0.5);
+    constructProperty_weights(SimTK::Array_<double>(NumAfferents, 1.0/NumAfferents));
+    constructProperty_timeDelay(0.1);
+    constructProperty_defaultControlSignal(1.0);
+    constructProperty_minimum_step_size(1.0e-4);
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+void StaticReflexCircuit<DelayKernel, Afferents...>::extendFinalizeFromProperties()
+{
+    Super::extendFinalizeFromProperties();
+
+    OPENSIM_THROW_IF_FRMOBJ(get_timeDelay() < 0, InvalidPropertyValue, getName(), "The delay cannot be negative");
+    OPENSIM_THROW_IF_FRMOBJ(get_minimum_step_size() <= 0, InvalidPropertyValue, getName(), "The minimum step size must be positive");
+
+    double total = 0;
+    for (int i = 0; i < NumAfferents; ++i)
+    {
+        _weights[i] = get_weights(i);
+        total += _weights[i];
+        OPENSIM_THROW_IF_FRMOBJ(_weights[i] < 0 || _weights[i] > 1, InvalidPropertyValue, getName(), "The weights must be between 0 and 1");
+    }
+    OPENSIM_THROW_IF_FRMOBJ(total > 1 + SimTK::SignificantReal, InvalidPropertyValue, getName(), "The weights cannot sum to more than 1");
+    _threshold = get_threshold();
+    _delay = get_timeDelay();
+    _defaultSignal = get_defaultControlSignal();
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+void StaticReflexCircuit<DelayKernel, Afferents...>::extendAddToSystem(
+        SimTK::MultibodySystem& system) const
+{
+    Super::extendAddToSystem(system);
+
+    // outputs are computed once per realization and counted
+    _signalCV = addCacheVariable("signal", 0.0, SimTK::Stage::Velocity);
+    _signalCountCV = addCacheVariable("signal_count", OutputCounter(), SimTK::Stage::Topology);
+    _muscleSignalCV = addCacheVariable("muscle_signal", 0.0, SimTK::Stage::Velocity);
+    _muscleSignalCountCV = addCacheVariable("muscle_signal_count", OutputCounter(), SimTK::Stage::Topology);
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+void StaticReflexCircuit<DelayKernel, Afferents...>::extendRealizeTopology(
+        SimTK::State& s) const
+{
+    Super::extendRealizeTopology(s);
+
+    const Input<double>& afferents = getInput<double>("afferents");
+    OPENSIM_THROW_IF_FRMOBJ((int)afferents.getNumConnectees() != NumAfferents, Exception, "The afferents input must be connected to exactly " + std::to_string(NumAfferents) + " outputs");
+    StaticAfferents<0, Afferents...>::bind(*this, afferents, _sources);
+
+    DelayHistory history;
+    history.reset(_delay, get_minimum_step_size(), 0, DelayKernel);
+
+    // the update value is rebuilt whenever the input changes and is swapped
+    // into the State by the integrator only on accepted steps
+    const SimTK::Subsystem& subsys = getSystem().getDefaultSubsystem();
+    _historyIndex = subsys.allocateAutoUpdateDiscreteVariable(s,
+        SimTK::Stage::Acceleration, new SimTK::Value<DelayHistory>(history),
+        SimTK::Stage::Velocity);
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+void StaticReflexCircuit<DelayKernel, Afferents...>::extendRealizeAcceleration(
+        const SimTK::State& s) const
+{
+    Super::extendRealizeAcceleration(s);
+
+    getUpdatedHistory(s);
+}
+
+//=============================================================================
+// GET AND SET
+//=============================================================================
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+const Muscle& StaticReflexCircuit<DelayKernel, Afferents...>::getMuscle() const
+{
+    return getSocket<Muscle>("muscle").getConnectee();
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+const DelayHistory& StaticReflexCircuit<DelayKernel, Afferents...>::getUpdatedHistory(
+        const SimTK::State& s) const
+{
+    const SimTK::SubsystemIndex subsys =
+        getSystem().getDefaultSubsystem().getMySubsystemIndex();
+
+    DelayHistory& update = SimTK::Value<DelayHistory>::updDowncast(
+        s.updDiscreteVarUpdateValue(subsys, _historyIndex)).upd();
+
+    if (!s.isDiscreteVarUpdateValueRealized(subsys, _historyIndex))
+    {
+        const DelayHistory& committed = SimTK::Value<DelayHistory>::downcast(
+            s.getDiscreteVariable(subsys, _historyIndex)).get();
+        update.prepareUpdate(committed, s.getTime(), getSignal(s));
+        s.markDiscreteVarUpdateValueRealized(subsys, _historyIndex);
+    }
+
+    return update;
+}
+
+//=============================================================================
+// SIGNALS
+//=============================================================================
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+double StaticReflexCircuit<DelayKernel, Afferents...>::getSignal(
+        const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _signalCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _signalCV))
+    {
+        return getCacheVariableValue(s, _signalCV);
+    }
+
+    // one direct getter call per afferent, unrolled at compile time
+    ++counter.numComputed;
+    double sum = StaticAfferents<0, Afferents...>::sum(0.0, _weights,
+                                                       _sources, s);
+    double signal = sum > _threshold ? sum : 0.0;
+
+    setCacheVariableValue(s, _signalCV, signal);
+    return signal;
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+OutputCounter StaticReflexCircuit<DelayKernel, Afferents...>::getSignalCounter(
+        const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _signalCountCV);
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+double StaticReflexCircuit<DelayKernel, Afferents...>::getMuscleSignal(
+        const SimTK::State& s) const
+{
+    OutputCounter& counter = updCacheVariableValue(s, _muscleSignalCountCV);
+    ++counter.numRead;
+    if (isCacheVariableValid(s, _muscleSignalCV))
+    {
+        return getCacheVariableValue(s, _muscleSignalCV);
+    }
+
+    ++counter.numComputed;
+    const DelayHistory& history = getUpdatedHistory(s);
+
+    // time < tau return default control signal
+    double time = s.getTime() - _delay;
+    double muscle_signal = time < history.getStartTime() ?
+        _defaultSignal : history.getValue<DelayKernel>(time);
+
+    setCacheVariableValue(s, _muscleSignalCV, muscle_signal);
+    return muscle_signal;
+}
+
+template <DelayLine::Interpolation DelayKernel, class... Afferents>
+OutputCounter StaticReflexCircuit<DelayKernel, Afferents...>::getMuscleSignalCounter(
+        const SimTK::State& s) const
+{
+    // the counters are never marked valid, they only accumulate
+    return updCacheVariableValue(s, _muscleSignalCountCV);
+}
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_StaticReflexCircuit_H_
@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  TugOfWarModel.cpp                           *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "TugOfWarModel.h"
+#include "ReflexController.h"
+#include "EnsembleController.h"
+#include <OpenSim/OpenSim.h>
+
+
+
+using namespace OpenSim;
+using namespace std;
+using namespace SimTK;
+
+
+void OpenSim::buildTugOfWarModel(Model& osimModel, TugOfWarControl control)
+{
+    osimModel.setName("tugofWar");
+
+    Ground& ground = osimModel.updGround();
+
+    // BLOCK BODY
+    double blockMass = 20.0, blockSideLength = 0.1;
+    Vec3 blockMassCenter(0);
+    Inertia blockInertia = blockMass*Inertia::brick(blockSideLength, blockSideLength, blockSideLength);
+    OpenSim::Body *block = new OpenSim::Body("block", blockMass, blockMassCenter, blockInertia);
+
+    // FREE JOINT
+    double halfLength = blockSideLength/2.0;
+    Vec3 locationInParent(0, halfLength, 0), orientationInParent(0);
+    Vec3 locationInBody(0, halfLength, 0), orientationInBody(0);
+    FreeJoint *blockToGround = new FreeJoint("blockToGround", ground, locationInParent, orientationInParent, *block, locationInBody, orientationInBody);
+
+    double angleRange[2] = {-SimTK::Pi/2, SimTK::Pi/2};
+    double positionRange[2] = {-1, 1};
+    blockToGround->updCoordinate(FreeJoint::Coord::Rotation1X).setRange(angleRange);
+    blockToGround->updCoordinate(FreeJoint::Coord::Rotation2Y).setRange(angleRange);
+    blockToGround->updCoordinate(FreeJoint::Coord::Rotation3Z).setRange(angleRange);
+    blockToGround->updCoordinate(FreeJoint::Coord::TranslationX).setRange(positionRange);
+    blockToGround->updCoordinate(FreeJoint::Coord::TranslationY).setRange(positionRange);
+    blockToGround->updCoordinate(FreeJoint::Coord::TranslationZ).setRange(positionRange);
+
+    osimModel.addBody(block);
+    osimModel.addJoint(blockToGround);
+
+    // MUSCLE FORCES
+    double maxIsometricForce = 1000.0, optimalFiberLength = 0.2,
+    tendonSlackLength = 0.1,    pennationAngle = 0.0;
+
+    Millard2012EquilibriumMuscle* original1 =
+        new Millard2012EquilibriumMuscle("original1",
+            maxIsometricForce, optimalFiberLength, tendonSlackLength,
+            pennationAngle);
+
+    Millard2012EquilibriumMuscle* original2 =
+        new Millard2012EquilibriumMuscle("original2",
+            maxIsometricForce, optimalFiberLength, tendonSlackLength,
+            pennationAngle);
+
+    original1->addNewPathPoint("original1-point1", ground,
+        Vec3(0.0, halfLength, 0.35));
+    original1->addNewPathPoint("original1-point2", *block,
+        Vec3(0.0, halfLength, halfLength));
+
+    original2->addNewPathPoint("original2-point1", ground,
+        Vec3(0.0, halfLength, 0.35));
+    original2->addNewPathPoint("original2-point2", *block,
+        Vec3(0.0, halfLength, halfLength));
+
+    original1->setDefaultActivation(0.1);
+    original2->setDefaultActivation(0.01);
+    original1->setDefaultFiberLength(optimalFiberLength);
+    original2->setDefaultFiberLength(optimalFiberLength);
+
+    osimModel.addForce(original1);
+    osimModel.addForce(original2);
+
+    // REFLEX CIRCUIT
+    SimpleSpindle* spindle = new SimpleSpindle("muscle_spindle", *original1,
+        optimalFiberLength);
+    GolgiTendon* golgi = new GolgiTendon("muscle_golgi", *original1);
+    osimModel.addComponent(spindle);
+    osimModel.addComponent(golgi);
+
+    if (control != EnsembleExcitation)
+    {
+        MuscleReflexCircuit* circuit = new MuscleReflexCircuit("reflex_circuit",
+            *original1, *spindle, *golgi, 0.1, 0.1, 0.5);
+        circuit->append_weights(0.4);
+        circuit->append_weights(0.4);
+        circuit->append_weights(0.2);
+        osimModel.addComponent(circuit);
+    }
+
+    // CONTROLS
+    PrescribedController *muscleController = new PrescribedController();
+    if (control == ReflexExcitation)
+    {
+        osimModel.addController(new ReflexController("reflex_controller", 0.5));
+        muscleController->addActuator(*original2);
+    }
+    else if (control == EnsembleExcitation)
+    {
+        EnsembleController* ensembleController =
+            new EnsembleController("ensemble_controller", 0.5);
+        ensembleController->addActuator(*original1);
+        osimModel.addController(ensembleController);
+        muscleController->addActuator(*original2);
+    }
+    else
+    {
+        muscleController->setActuators(osimModel.updActuators());
+        muscleController->prescribeControlForActuator("original1", new Constant(1.0));
+    }
+    muscleController->prescribeControlForActuator("original2", new Constant(1.0));
+    osimModel.addController(muscleController);
+
+    osimModel.setUseVisualizer(false);
+}
+
+SimTK::State& OpenSim::initializeTugOfWarState(Model& osimModel)
+{
+    SimTK::State& si = osimModel.initSystem();
+
+    // Lock everything but the Z translation (index 5) of the block
+    CoordinateSet& coordinates = osimModel.updCoordinateSet();
+    for (int i = 0; i < 6; ++i)
+    {
+        coordinates[i].setValue(si, 0);
+    }
+    coordinates[0].setLocked(si, true);
+    coordinates[1].setLocked(si, true);
+    coordinates[2].setLocked(si, true);
+    coordinates[4].setLocked(si, true);
+
+    osimModel.equilibrateMuscles(si);
+
+    return si;
+}
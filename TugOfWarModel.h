@@ -0,0 +1,74 @@
+#ifndef OPENSIM_TugOfWarModel_H_
+#define OPENSIM_TugOfWarModel_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: TugOfWarModel.h                              *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "MuscleReflexCircuit.h"
+
+
+
+namespace OpenSim {
+
+/** How original1 of the tug-of-war model is excited. */
+enum TugOfWarControl {
+    PrescribedExcitation,   ///< a constant 1 from the PrescribedController
+    ReflexExcitation,       ///< the ReflexController, from the circuit
+    EnsembleExcitation      ///< an EnsembleController, set from outside
+};
+
+/**
+ * Build the sliding block tug-of-war model of mainSimulation.cpp: a 20 kg
+ * block on a free joint pulled by the two Millard muscles "original1" and
+ * "original2", both excited by a PrescribedController. A SimpleSpindle
+ * "muscle_spindle", a GolgiTendon "muscle_golgi" and a MuscleReflexCircuit
+ * "reflex_circuit" are attached to original1.
+ *
+ * The circuit can be looked up and edited before the system is built, e.g.
+ * model.updComponent<MuscleReflexCircuit>("reflex_circuit").
+ *
+ * With ReflexExcitation, original1 is excited as in mainSimulation.cpp by a
+ * ReflexController "reflex_controller", a baseline of 0.5 plus the signal
+ * of the circuit, and the PrescribedController excites original2 only.
+ *
+ * With EnsembleExcitation the model has no circuit: original1 is excited by
+ * an EnsembleController "ensemble_controller" with the excitation held in
+ * its State, for a circuit evaluated outside the model, and the
+ * PrescribedController excites original2 only.
+ */
+void buildTugOfWarModel(Model& model,
+                        TugOfWarControl control = PrescribedExcitation);
+
+/**
+ * Build the system of a tug-of-war model, lock every coordinate of the block
+ * except its Z translation and equilibrate the muscles. Returns the
+ * initialized working State of the model.
+ */
+SimTK::State& initializeTugOfWarState(Model& model);
+
+}; //namespace
+
+#endif // OPENSIM_TugOfWarModel_H_
@@ -0,0 +1,153 @@
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim:  WeightedSum.cpp                             *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+
+//=============================================================================
+// INCLUDES
+//=============================================================================
+#include "WeightedSum.h"
+#include <algorithm>
+#include <cstdint>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+
+
+using namespace OpenSim;
+using namespace std;
+
+
+//=============================================================================
+// CONSTRUCTOR(S) AND DESTRUCTOR
+//=============================================================================
+//_____________________________________________________________________________
+/* Default constructor. */
+WeightedSum::WeightedSum() :
+    _weights(nullptr),
+    _size(0),
+    _paddedSize(0)
+{
+    assign(nullptr, 0);
+}
+
+WeightedSum::WeightedSum(const WeightedSum& other) :
+    _storage(other._storage),
+    _weights(nullptr),
+    _size(other._size),
+    _paddedSize(other._paddedSize)
+{
+    align();
+    std::copy(other._weights, other._weights + _paddedSize, _weights);
+}
+
+WeightedSum& WeightedSum::operator=(const WeightedSum& other)
+{
+    if (this != &other)
+    {
+        _storage = other._storage;
+        _size = other._size;
+        _paddedSize = other._paddedSize;
+        align();
+        std::copy(other._weights, other._weights + _paddedSize, _weights);
+    }
+    return *this;
+}
+
+void WeightedSum::assign(const double* weights, int size)
+{
+    _size = size;
+    _paddedSize = (size + Width - 1)/Width*Width;
+
+    // the padded weights plus the slack to align them
+    _storage.assign(_paddedSize + Width - 1, 0.0);
+    align();
+    std::copy(weights, weights + size, _weights);
+}
+
+void WeightedSum::align()
+{
+    const std::uintptr_t bytes = Width*sizeof(double);
+    std::uintptr_t address = (std::uintptr_t)_storage.data();
+    int offset = (int)(((bytes - address % bytes) % bytes)/sizeof(double));
+    _weights = _storage.data() + offset;
+}
+
+//=============================================================================
+// SUM
+//=============================================================================
+
+const char* WeightedSum::getKernelName()
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    return "avx2+fma";
+#else
+    return "scalar";
+#endif
+}
+
+double WeightedSum::evaluate(const double* values) const
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    if (_size < MinVectorSize)
+    {
+        return evaluateReference(values);
+    }
+
+    // two accumulators hide the latency of the fused multiply-add; the
+    // padding is zero in both buffers so no tail is needed. The values are
+    // a buffer of the caller, so they are not assumed aligned
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 2*Width <= _paddedSize; i += 2*Width)
+    {
+        sum0 = _mm256_fmadd_pd(_mm256_load_pd(_weights + i),
+                               _mm256_loadu_pd(values + i), sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_load_pd(_weights + i + Width),
+                               _mm256_loadu_pd(values + i + Width), sum1);
+    }
+    if (i < _paddedSize)
+    {
+        sum0 = _mm256_fmadd_pd(_mm256_load_pd(_weights + i),
+                               _mm256_loadu_pd(values + i), sum0);
+    }
+    __m256d sum = _mm256_add_pd(sum0, sum1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum),
+                              _mm256_extractf128_pd(sum, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#else
+    return evaluateReference(values);
+#endif
+}
+
+double WeightedSum::evaluateReference(const double* values) const
+{
+    double sum = 0;
+    for (int i = 0; i < _size; ++i)
+    {
+        sum += _weights[i]*values[i];
+    }
+    return sum;
+}
@@ -0,0 +1,111 @@
+#ifndef OPENSIM_WeightedSum_H_
+#define OPENSIM_WeightedSum_H_
+/* -------------------------------------------------------------------------- *
+ *                      OpenSim: WeightedSum.h                                *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+
+//============================================================================
+// INCLUDE
+//============================================================================
+#include "osimInterneuronDLL.h"
+#include <vector>
+
+
+
+namespace OpenSim {
+
+//=============================================================================
+//=============================================================================
+/**
+ * WeightedSum is the packed weight vector of an Interneuron. The weights are
+ * copied once, when the properties are finalized, into a 32 byte aligned
+ * buffer padded with zeros to a multiple of Width. The afferent values are
+ * held by the caller, in a buffer of getPaddedSize() entries with the
+ * padding 0, so that a WeightedSum is never written while it is evaluated
+ * and one can be evaluated from several threads at once. Evaluating the sum
+ * is then a single fused multiply-add reduction over the two buffers.
+ *
+ * With AVX2 and FMA the reduction runs Width doubles at a time in two
+ * accumulators. The values are written one at a time just before the sum,
+ * and reading them back as vectors stalls store forwarding, so fan-ins
+ * below MinVectorSize keep the scalar loop. evaluateReference() is the plain
+ * scalar loop the vector kernel is checked against; the two differ only by
+ * the order of the additions.
+ *
+ * @author  Hjalti Hilmarsson
+ */
+class OSIMINTERNEURON_API WeightedSum {
+
+public:
+    /** Doubles per vector register, the padding of both buffers. */
+    static const int Width = 4;
+    /** Smallest fan-in evaluated with the vector kernel. */
+    static const int MinVectorSize = 16;
+
+    //--------------------------------------------------------------------------
+    // CONSTRUCTION AND DESTRUCTION
+    //--------------------------------------------------------------------------
+    /** Default constructor, no weights. */
+    WeightedSum();
+    // The weights point into the storage, so copies realign them
+    WeightedSum(const WeightedSum& other);
+    WeightedSum& operator=(const WeightedSum& other);
+
+    /** Copy size weights into the aligned buffer. */
+    void assign(const double* weights, int size);
+
+//--------------------------------------------------------------------------
+// WEIGHTED SUM ACCESSORS
+//--------------------------------------------------------------------------
+    int getSize() const { return _size; }
+    /** getSize() rounded up to a multiple of Width. */
+    int getPaddedSize() const { return _paddedSize; }
+    const double* getWeights() const { return _weights; }
+
+    /** Name of the kernel evaluate() was built with, "avx2+fma" when the
+        library is compiled for AVX2 and FMA (ENABLE_AVX2) and "scalar"
+        otherwise. */
+    static const char* getKernelName();
+
+    /** Sum of the weights times values, getPaddedSize() entries with the
+        padding 0, vectorized where available. */
+    double evaluate(const double* values) const;
+    /** The same sum as a scalar loop in index order. */
+    double evaluateReference(const double* values) const;
+
+private:
+    // point the weights at the aligned part of the storage
+    void align();
+
+    std::vector<double> _storage;
+    double* _weights;
+    int _size;
+    int _paddedSize;
+
+};  // END of class WeightedSum
+
+}; //namespace
+//=============================================================================
+//=============================================================================
+
+#endif // OPENSIM_WeightedSum_H_
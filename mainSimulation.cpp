@@ -24,7 +24,7 @@
 //=============================================================================
 //=============================================================================
 #include <OpenSim/OpenSim.h>
-#include "MuscleReflexCircuit.h"
+#include "TugOfWarModel.h"
 #include <OpenSim/Common/IO.h>
 #include "OpenSim/Common/STOFileAdapter.h"
 
@@ -48,167 +48,32 @@ int main() {
         double initialTime = 0.0;
         double finalTime = 10.0;
         
-        ///////////////////////////////////////////
-        // DEFINE BODIES AND JOINTS OF THE MODEL //
-        ///////////////////////////////////////////
-        // Create an OpenSim model and set its name
+        ////////////////////////////////////////////
+        // DEFINE THE MODEL, CIRCUIT AND CONTROLS //
+        ////////////////////////////////////////////
+        // The block on a free joint pulled by original1 and original2. The
+        // spindle and golgi signals of original1 are weighted by the
+        // interneuron and delayed by 0.1 s, and the reflex controller excites
+        // original1 with the circuit signal on top of a baseline.
         Model osimModel;
-        osimModel.setName("tugofWar");
-        
-        // GROUND FRAME
-        
-        // Get a reference to the model's ground body
-        Ground& ground = osimModel.updGround();
-        
-        // Add display geometry to the ground to visualize in the GUI
-        /*
-        ground.attachGeometry(new Mesh("ground.vtp"));
-        ground.attachGeometry(new Mesh("anchor1.vtp"));
-        ground.attachGeometry(new Mesh("anchor2.vtp"));
-         */
-        
-        // BLOCK BODY
-        
-        // Specify properties of a 20 kg 1cm length block body
-        double blockMass = 20.0, blockSideLength = 0.1;
-        Vec3 blockMassCenter(0);
-        Inertia blockInertia = blockMass*Inertia::brick(blockSideLength, blockSideLength, blockSideLength);
-        
-        // Create a new block body with the specified properties
-        OpenSim::Body *block = new OpenSim::Body("block", blockMass, blockMassCenter, blockInertia);
-        
-        //block->attachGeometry(new Mesh("block.vtb"));
-        
-        // FREE JOINT
-        
-        // Create a new free joint with 6 degrees-of-freedom (coordinates)
-        // between the block and ground bodies
-        double halfLength = blockSideLength/2.0;
-        Vec3 locationInParent(0, halfLength, 0), orientationInParent(0);
-        Vec3 locationInBody(0, halfLength, 0), orientationInBody(0);
-        FreeJoint *blockToGround = new FreeJoint("blockToGround", ground, locationInParent, orientationInParent, *block, locationInBody, orientationInBody);
-        
-        // Set the angle and position ranges for the free (6-degree-of-freedom)
-        // joint between the block and ground frames.
-        double angleRange[2] = {-SimTK::Pi/2, SimTK::Pi/2};
-        double positionRange[2] = {-1, 1};
-        blockToGround->updCoordinate(FreeJoint::Coord::Rotation1X).setRange(angleRange);
-        blockToGround->updCoordinate(FreeJoint::Coord::Rotation2Y).setRange(angleRange);
-        blockToGround->updCoordinate(FreeJoint::Coord::Rotation3Z).setRange(angleRange);
-        blockToGround->updCoordinate(FreeJoint::Coord::TranslationX).setRange(positionRange);
-        blockToGround->updCoordinate(FreeJoint::Coord::TranslationY).setRange(positionRange);
-        blockToGround->updCoordinate(FreeJoint::Coord::TranslationZ).setRange(positionRange);
-        
-        // Add the block body to the model
-        osimModel.addBody(block);
-        osimModel.addJoint(blockToGround);
-        
-        ///////////////////////////////////////
-        // DEFINE FORCES ACTING ON THE MODEL //
-        ///////////////////////////////////////
-        // MUSCLE FORCES
-        // Create two new muscles
-        double maxIsometricForce = 1000.0, optimalFiberLength = 0.2,
-        tendonSlackLength = 0.1,    pennationAngle = 0.0;
-        
-        // muscle models
-         Millard2012EquilibriumMuscle* original1 =
-             new Millard2012EquilibriumMuscle("original1",
-                 maxIsometricForce, optimalFiberLength, tendonSlackLength,
-                 pennationAngle);
-        
-        Millard2012EquilibriumMuscle* original2 =
-            new Millard2012EquilibriumMuscle("original2",
-                maxIsometricForce, optimalFiberLength, tendonSlackLength,
-                pennationAngle);
-        
-        // Define the path of the muscles
-        original1->addNewPathPoint("original1-point1", ground,
-            Vec3(0.0, halfLength, 0.35));
-        original1->addNewPathPoint("original1-point2", *block,
-            Vec3(0.0, halfLength, halfLength));
-        
-        original2->addNewPathPoint("original2-point1", ground,
-            Vec3(0.0, halfLength, 0.35));
-        original2->addNewPathPoint("original2-point2", *block,
-            Vec3(0.0, halfLength, halfLength));
-        
-        // Define the default states for the two muscles
-        // Activation
-        original1->setDefaultActivation(0.1);
-        original2->setDefaultActivation(0.01);
-        
-        // Fiber length
-        original1->setDefaultFiberLength(optimalFiberLength);
-        original2->setDefaultFiberLength(optimalFiberLength);
-        
-        // Add the two muscles to the model
-        osimModel.addForce(original1);
-        osimModel.addForce(original2);
-        
-        // add spindle and golgi to model
-        SimpleSpindle* spindle = new SimpleSpindle("muscle_spindle", *original1, optimalFiberLength);
-        
-        GolgiTendon* golgi = new GolgiTendon("muscle_golgi", *original1);
-        
-        ///////////////////////////////////
-        // DEFINE CONTROLS FOR THE MODEL //
-        ///////////////////////////////////
-        
-        // prescribe our spindle controller as a sensor??? how
-        // can I prescribe two controllers, one controller for the muscles and the spindle controller only to print out the muscle length and velocity?
-        
-        PrescribedController *muscleController = new PrescribedController();
-        muscleController->setActuators(osimModel.updActuators());
-        
-        // set the muscle controls
-        muscleController->prescribeControlForActuator("original1", new Constant(1.0));
-        muscleController->prescribeControlForActuator("original2", new Constant(1.0));
-        
-        // Add the muscle controller to the model
-        osimModel.addController(muscleController);
+        buildTugOfWarModel(osimModel, ReflexExcitation);
         
         // Add analysis
         MuscleAnalysis* muscAnalysis = new MuscleAnalysis(&osimModel);
-        Array<std::string> coords(blockToGround->getCoordinate(FreeJoint::Coord::TranslationZ).getName(),1);
+        const FreeJoint& blockToGround = dynamic_cast<const FreeJoint&>(
+            osimModel.getJointSet().get("blockToGround"));
+        Array<std::string> coords(blockToGround.getCoordinate(FreeJoint::Coord::TranslationZ).getName(),1);
         muscAnalysis->setCoordinates(coords);
         muscAnalysis->setComputeMoments(false);
         osimModel.addAnalysis(muscAnalysis);
         
-        // set visualizer
-        osimModel.setUseVisualizer(false);
-        
-        
-        //////////////////////////
-        // Define spindle //
-        //////////////////////////
-        
-
-        
         //////////////////////////
         // PERFORM A SIMULATION //
         //////////////////////////
         
-        // Initialize the system and get the state
-        SimTK::State& si = osimModel.initSystem();
-        
-        //Initialize the cords to 0 and lock the rotational degrees of freedom so the block doesn't twist
-        
-        CoordinateSet& coordinates = osimModel.updCoordinateSet();
-        coordinates[0].setValue(si, 0);
-        coordinates[1].setValue(si, 0);
-        coordinates[2].setValue(si, 0);
-        coordinates[3].setValue(si, 0);
-        coordinates[4].setValue(si, 0);
-        coordinates[5].setValue(si, 0);
-        coordinates[0].setLocked(si, true);
-        coordinates[1].setLocked(si, true);
-        coordinates[2].setLocked(si, true);
-        // Last coordinate (index 5) is the Z translation of the block
-        coordinates[4].setLocked(si, true);
-        
-        // Compute initial conditions for muscles
-        osimModel.equilibrateMuscles(si);
+        // Initialize the system and get the state, with the block locked
+        // but for its Z translation and the muscles equilibrated
+        SimTK::State& si = initializeTugOfWarState(osimModel);
 
         // Create the force reporter
         ForceReporter* reporter = new ForceReporter(&osimModel);
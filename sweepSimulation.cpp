@@ -0,0 +1,155 @@
+/* -------------------------------------------------------------------------- *
+ *                       OpenSim:  sweepSimulation.cpp                        *
+ * -------------------------------------------------------------------------- *
+ * The OpenSim API is a toolkit for musculoskeletal modeling and simulation.  *
+ * See http://opensim.stanford.edu and the NOTICE file for more information.  *
+ * OpenSim is developed at Stanford University and supported by the US        *
+ * National Institutes of Health (U54 GM072970, R24 HD065690) and by DARPA    *
+ * through the Warrior Web program.                                           *
+ *                                                                            *
+ * Copyright (c) 2005-2021 Stanford University, TU Delft and the Authors      *
+ * Author(s): Ajay Seth, Hjalti Hilmarsson                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied    *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+//=============================================================================
+//=============================================================================
+#include "ReflexSweep.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace OpenSim;
+
+//_____________________________________________________________________________
+/**
+ * Run the tug-of-war simulation of mainSimulation.cpp for every
+ * MuscleReflexCircuit property set of a sweep file, on a pool of threads,
+ * and write one summary table. See ReflexSweep for the file format.
+ *
+ *     ReflexSweep [--processes [--timeout s] [--attempts n] | --ensemble h]
+ *                 sweepFile [threads [finalTime [table]]]
+ *
+ * threads defaults to one per hardware thread, finalTime to 10 s and the
+ * table to standard output. With --processes the runs are made in as many
+ * worker processes instead, so that a run that crashes or hangs is recorded
+ * as failed rather than ending the sweep; a run is killed after the
+ * timeout, 600 s by default, and tried the given number of times, 2 by
+ * default. With --ensemble the runs are advanced in lockstep on one thread
+ * at a fixed step of h seconds, and threads is not used. The throughput of
+ * the sweep, in seconds simulated per wall second summed over the runs, is
+ * written to standard error.
+ */
+
+int main(int argc, char* argv[]) {
+    
+    bool processes = false;
+    double timeout = 600;
+    int attempts = 2;
+    double ensembleStep = 0;
+    
+    try {
+        // options come before the sweep file
+        int first = 1;
+        for (; first < argc && std::string(argv[first]).compare(0, 2, "--") == 0; ++first)
+        {
+            std::string option = argv[first];
+            if (option == "--processes")
+            {
+                processes = true;
+            }
+            else if (option == "--timeout" && first + 1 < argc)
+            {
+                timeout = std::stod(argv[++first]);
+            }
+            else if (option == "--attempts" && first + 1 < argc)
+            {
+                attempts = std::stoi(argv[++first]);
+            }
+            else if (option == "--ensemble" && first + 1 < argc)
+            {
+                ensembleStep = std::stod(argv[++first]);
+            }
+            else
+            {
+                first = argc;
+            }
+        }
+        
+        if (argc - first < 1 || argc - first > 4)
+        {
+            std::cout << "usage: " << argv[0]
+                      << " [--processes [--timeout s] [--attempts n] | --ensemble h]"
+                      << " sweepFile [threads [finalTime [table]]]\n";
+            return 1;
+        }
+        argc -= first - 1;
+        argv += first - 1;
+        
+        std::ifstream in(argv[1]);
+        if (!in)
+        {
+            std::cout << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        
+        ReflexSweep sweep;
+        std::string message;
+        if (!sweep.read(in, message))
+        {
+            std::cout << argv[1] << ", " << message << std::endl;
+            return 1;
+        }
+        
+        int numThreads = argc > 2 ? std::stoi(argv[2]) : 0;
+        if (argc > 3)
+        {
+            sweep.setFinalTime(std::stod(argv[3]));
+        }
+        
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        std::vector<ReflexSweepResult> results = ensembleStep > 0 ?
+            sweep.runEnsemble(ensembleStep) : processes ?
+            sweep.runProcesses(numThreads, timeout, attempts) :
+            sweep.run(numThreads);
+        double wallTime = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        double simulated = 0;
+        for (const ReflexSweepResult& result : results)
+        {
+            simulated += result.endTime;
+        }
+        std::cerr << "throughput " << simulated/wallTime
+                  << " variant-s per wall-s" << std::endl;
+        
+        if (argc > 4)
+        {
+            std::ofstream table(argv[4]);
+            ReflexSweep::writeTable(table, results);
+        }
+        else
+        {
+            ReflexSweep::writeTable(std::cout, results);
+        }
+    }
+    
+    catch(const std::exception& ex){
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}